@@ -62,6 +62,40 @@ static std::map<std::string, backend_t> backend_t_map {
    {"palisade", backend_t::palisade},
 };
 
+//----------------------------- Expression graph -------------------------------
+enum class graph_op_t : std::uint8_t{
+  // Leaf: ciphertext operand `ctxt`
+  ctxt = 0x0,
+  // Leaf: plaintext operand, either `ptxt` or raw `fvalues`/`ivalues`
+  ptxt = 0x1,
+  // lhs + rhs, lhs - rhs, lhs * rhs (rhs may be a plaintext leaf)
+  add = 0x2,
+  sub = 0x3,
+  multiply = 0x4,
+  // -lhs
+  negate = 0x5,
+  // lhs rotated by k positions
+  rotate = 0x6,
+  // lhs with its two rows swapped (bfv/bgv)
+  flip = 0x7
+};
+// Node of an expression graph, evaluated by Afhel::eval_graph. Nodes are
+//  listed operands first: lhs/rhs are indexes of earlier nodes. Output nodes
+//  are written into `ctxt`, setting `mod_level` to the number of primes
+//  consumed.
+struct AfGraphNode {
+  graph_op_t op = graph_op_t::ctxt;
+  std::int64_t lhs = -1;
+  std::int64_t rhs = -1;
+  int k = 0;
+  bool output = false;
+  int mod_level = 0;
+  std::shared_ptr<AfCtxt> ctxt;
+  std::shared_ptr<AfPtxt> ptxt;
+  std::vector<double> fvalues;
+  std::vector<std::int64_t> ivalues;
+};
+
 
 // =============================================================================
 // ================== ABSTRACTION FOR HOMOMORPHIC ENCR. LIBS ===================
@@ -86,9 +120,19 @@ class Afhel {
   virtual void relinKeyGen() = 0;
   virtual void rotateKeyGen(std::vector<int> rot_steps) = 0;
 
+  // EVALUATION-ONLY MODE
+  // Holds no secret key and never builds a key generator, for servers that
+  //  only evaluate. Enabling it drops the secret key.
+  virtual void set_eval_only(bool eval_only) = 0;
+  virtual bool is_eval_only() = 0;
+
   // ENCRYPTION
   virtual void encrypt(AfPtxt &plain1, AfCtxt &cipherOut) = 0;
   virtual void encrypt_v(std::vector<std::shared_ptr<AfPtxt>> &plainV, std::vector<std::shared_ptr<AfCtxt>> &cipherVOut) = 0;
+  // Secret key encryption. Saved without encrypting first, the uniform half
+  //  of the ciphertext is replaced by the seed that generates it.
+  virtual void encrypt_symmetric(AfPtxt &plain1, AfCtxt &cipherOut) = 0;
+  virtual size_t save_encrypt_symmetric(std::ostream &out_stream, std::string &compr_mode, AfPtxt &plain1) = 0;
 
   // DECRYPTION
   virtual void decrypt(AfCtxt &cipher1, AfPtxt &plainOut) = 0;
@@ -101,23 +145,47 @@ class Afhel {
   // ENCODE
   // bfv
   virtual void encode_i(std::vector<int64_t> &values, AfPtxt &plainOut) = 0;
+  virtual void encode_i(const int64_t *values, std::size_t n_values, AfPtxt &plainOut) = 0;
   // ckks
   virtual void encode_f(std::vector<double> &values, double scale, AfPtxt &plainVOut) = 0;
+  virtual void encode_f(const double *values, std::size_t n_values, double scale, AfPtxt &plainVOut) = 0;
   virtual void encode_c(std::vector<std::complex<double>> &values, double scale, AfPtxt &plainVOut) = 0;
+  virtual void encode_c(const std::complex<double> *values, std::size_t n_values, double scale, AfPtxt &plainVOut) = 0;
   // bgv
   virtual void encode_g(std::vector<int64_t> &values, AfPtxt &plainOut) = 0;
+  virtual void encode_g(const int64_t *values, std::size_t n_values, AfPtxt &plainOut) = 0;
 
   // DECODE
   // bfv
   virtual void decode_i(AfPtxt &plain1, std::vector<int64_t> &valueVOut) = 0;
+  virtual void decode_i(AfPtxt &plain1, int64_t *valuesOut, std::size_t n_values) = 0;
   // ckks
   virtual void decode_f(AfPtxt &plain1, std::vector<double> &valueVOut) = 0;
+  virtual void decode_f(AfPtxt &plain1, double *valuesOut, std::size_t n_values) = 0;
   virtual void decode_c(AfPtxt &plain1, std::vector<std::complex<double>> &valueVOut) = 0;
+  virtual void decode_c(AfPtxt &plain1, std::complex<double> *valuesOut, std::size_t n_values) = 0;
   // bgv
   virtual void decode_g(AfPtxt &plain1, std::vector<int64_t> &valueVOut) = 0;
+  virtual void decode_g(AfPtxt &plain1, int64_t *valuesOut, std::size_t n_values) = 0;
+
+  // BATCHED CODEC (row-major 2D arrays, one plaintext per row)
+  virtual void encode_i_v(const int64_t *values, std::size_t n_rows, std::size_t row_len, std::vector<std::shared_ptr<AfPtxt>> &plainVOut) = 0;
+  virtual void encode_f_v(const double *values, std::size_t n_rows, std::size_t row_len, double scale, std::vector<std::shared_ptr<AfPtxt>> &plainVOut) = 0;
+  virtual void encode_c_v(const std::complex<double> *values, std::size_t n_rows, std::size_t row_len, double scale, std::vector<std::shared_ptr<AfPtxt>> &plainVOut) = 0;
+  virtual void encode_g_v(const int64_t *values, std::size_t n_rows, std::size_t row_len, std::vector<std::shared_ptr<AfPtxt>> &plainVOut) = 0;
+  virtual void decode_i_v(std::vector<std::shared_ptr<AfPtxt>> &plainV, int64_t *valuesOut, std::size_t row_len) = 0;
+  virtual void decode_f_v(std::vector<std::shared_ptr<AfPtxt>> &plainV, double *valuesOut, std::size_t row_len) = 0;
+  virtual void decode_c_v(std::vector<std::shared_ptr<AfPtxt>> &plainV, std::complex<double> *valuesOut, std::size_t row_len) = 0;
+  virtual void decode_g_v(std::vector<std::shared_ptr<AfPtxt>> &plainV, int64_t *valuesOut, std::size_t row_len) = 0;
   
   // -------------------------- RELINEARIZATION -------------------------
   virtual void relinearize(AfCtxt &cipher1) = 0;
+  // Deferred relinearization: products stay at size 3 until an operation needs
+  //  size 2 (multiply, rotate, save) or the size would exceed max_size.
+  virtual void set_auto_relin(bool enabled, std::size_t max_size) = 0;
+  virtual bool get_auto_relin() = 0;
+  virtual std::size_t get_relin_max_size() = 0;
+  virtual std::vector<std::uint64_t> get_relin_stats(bool reset) = 0;
 
   // ---------------------- HOMOMORPHIC OPERATIONS ----------------------
   // NEGATE
@@ -152,24 +220,55 @@ class Afhel {
   virtual void rotate_v(std::vector<std::shared_ptr<AfCtxt>> &cipherV, int k) = 0;
   virtual void flip(AfCtxt &ctxt) = 0;
   virtual void flip_v(std::vector<std::shared_ptr<AfCtxt>> &ctxtV) = 0;
+  virtual void rotate_many(AfCtxt &ctxt, std::vector<int> &steps, std::vector<std::shared_ptr<AfCtxt>> &ctxtVOut) = 0;
+  virtual void cumul_add(AfCtxt &ctxt, std::size_t n_elements) = 0;
+
+  // REDUCTIONS
+  virtual void add_many(std::vector<std::shared_ptr<AfCtxt>> &ctxtV, AfCtxt &ctxtOut) = 0;
+  virtual void multiply_many(std::vector<std::shared_ptr<AfCtxt>> &ctxtV, AfCtxt &ctxtOut) = 0;
+
+  // ROTATION KEY PLANNING
+  // Steps are counted per rotation (0 stands for column flips). In dry runs
+  //  rotations are only recorded, and need no rotation keys.
+  virtual void set_rotation_record(bool enabled, bool dry_run) = 0;
+  virtual std::map<int, std::uint64_t> get_rotation_record() = 0;
+  // Fewest key steps composing every step with at most max_extra additional
+  //  rotations, and the total rotations a set of key steps needs for `steps`.
+  virtual std::vector<int> plan_rotation_keys(std::map<int, std::uint64_t> &steps, std::size_t max_extra) = 0;
+  virtual std::int64_t count_rotations(std::vector<int> &key_steps, std::map<int, std::uint64_t> &steps) = 0;
+
+  // LINEAR ALGEBRA
+  virtual void encode_matrix_i(const std::int64_t *matrix, std::size_t n_rows, std::size_t n_cols, std::vector<std::shared_ptr<AfPtxt>> &diagVOut) = 0;
+  virtual void encode_matrix_f(const double *matrix, std::size_t n_rows, std::size_t n_cols, double scale, std::vector<std::shared_ptr<AfPtxt>> &diagVOut) = 0;
+  virtual void matvec_plain(AfCtxt &ctxt, std::vector<std::shared_ptr<AfPtxt>> &diagV) = 0;
 
   // POWER
   virtual void exponentiate(AfCtxt &cipher1, std::uint64_t &expon) = 0;
   virtual void exponentiate_v(std::vector<std::shared_ptr<AfCtxt>> &cipherV, std::uint64_t &expon) = 0;
+  virtual void eval_poly(AfCtxt &ctxt, std::vector<double> &coeffs, bool chebyshev, double x_min, double x_max) = 0;
+
+  // EXPRESSION GRAPH
+  virtual void eval_graph(std::vector<AfGraphNode> &nodes) = 0;
 
   // CKKS -> Rescaling and mod switching
   virtual void rescale_to_next(AfCtxt &cipher1) = 0;
   virtual void mod_switch_to_next(AfCtxt &cipher1) = 0;
   virtual void mod_switch_to_next_plain(AfPtxt &ptxt) = 0;
 
+  // NTT plaintexts, to multiply repeatedly without transforming them again
+  virtual void plain_to_ntt(AfPtxt &ptxt, std::size_t mod_level) = 0;
+  virtual std::size_t get_mod_level(AfCtxt &ctxt) = 0;
+
 
   // -------------------------------- I/O -------------------------------
   // SAVE/LOAD CONTEXT
   virtual size_t save_context(std::ostream &out_stream, std::string &compr_mode) = 0;
   virtual size_t load_context(std::istream &in_stream, int sec) = 0;
 
+  // Seeded keys are freshly generated from the secret key, replacing their
+  //  uniform half by a seed: about half the size, and loaded the same way.
   // SAVE/LOAD PUBLICKEY
-  virtual size_t save_public_key(std::ostream &out_stream, std::string &compr_mode) = 0;
+  virtual size_t save_public_key(std::ostream &out_stream, std::string &compr_mode, bool seeded) = 0;
   virtual size_t load_public_key(std::istream &in_stream) = 0;
 
   // SAVE/LOAD SECRETKEY
@@ -177,12 +276,17 @@ class Afhel {
   virtual size_t load_secret_key(std::istream &in_stream) = 0;
 
   // SAVE/LOAD RELINKEY
-  virtual size_t save_relin_keys(std::ostream &out_stream, std::string &compr_mode) = 0;
+  virtual size_t save_relin_keys(std::ostream &out_stream, std::string &compr_mode, bool seeded) = 0;
   virtual size_t load_relin_keys(std::istream &in_stream) = 0;
 
   // SAVE/LOAD ROTKEYS
-  virtual size_t save_rotate_keys(std::ostream &out_stream, std::string &compr_mode) = 0;
+  virtual size_t save_rotate_keys(std::ostream &out_stream, std::string &compr_mode, bool seeded) = 0;
   virtual size_t load_rotate_keys(std::istream &in_stream) = 0;
+  // Key store indexed by galois element: memory-mapped on load, keys decoded
+  //  on first use. Stats are {keys in store, keys loaded}, empty without one.
+  virtual size_t save_rotate_keys_store(std::string &filename) = 0;
+  virtual size_t load_rotate_keys_store(std::string &filename) = 0;
+  virtual std::vector<std::size_t> get_rotate_keys_store_stats() = 0;
 
   // SAVE/LOAD PLAINTEXT --> Could be achieved outside of Afhel
   virtual size_t save_plaintext(std::ostream &out_stream, std::string &compr_mode, AfPtxt &plain) = 0;
@@ -192,6 +296,24 @@ class Afhel {
   virtual size_t save_ciphertext(std::ostream &out_stream, std::string &compr_mode, AfCtxt &ciphert) = 0;
   virtual size_t load_ciphertext(std::istream &in_stream, AfCtxt &plain) = 0;
 
+  // SAVE/LOAD IN MEMORY --> Straight into/from a buffer of sizeof_* bytes
+  virtual size_t save_plaintext(std::uint8_t *out, size_t size, std::string &compr_mode, AfPtxt &plain) = 0;
+  virtual size_t load_plaintext(const std::uint8_t *in, size_t size, AfPtxt &plain) = 0;
+  virtual size_t save_ciphertext(std::uint8_t *out, size_t size, std::string &compr_mode, AfCtxt &ciphert) = 0;
+  virtual size_t load_ciphertext(const std::uint8_t *in, size_t size, AfCtxt &ciphert) = 0;
+
+  // RAW DATA --> RNS coefficients in place, for zero-copy export. The header
+  //  rebuilds the object from a copy of the data: {parms_id (4 words), size,
+  //  coeff_modulus_size, poly_modulus_degree, is_ntt_form, correction_factor,
+  //  scale bits} for ciphertexts, {parms_id (4 words), coeff_count, scale
+  //  bits} for plaintexts.
+  virtual std::vector<std::uint64_t> raw_header(AfCtxt &ciphert) = 0;
+  virtual std::uint64_t *raw_data(AfCtxt &ciphert) = 0;
+  virtual void load_raw(AfCtxt &ciphert, std::vector<std::uint64_t> &header, const std::uint8_t *data, size_t n_bytes) = 0;
+  virtual std::vector<std::uint64_t> raw_header(AfPtxt &plain) = 0;
+  virtual std::uint64_t *raw_data(AfPtxt &plain) = 0;
+  virtual void load_raw(AfPtxt &plain, std::vector<std::uint64_t> &header, const std::uint8_t *data, size_t n_bytes) = 0;
+
   // ----------------------------- AUXILIARY ----------------------------
   // GETTERS
   virtual std::vector<std::uint64_t> get_qi() = 0;
@@ -206,6 +328,7 @@ class Afhel {
   virtual size_t sizeof_secret_key(std::string &compr_mode) = 0;
   virtual size_t sizeof_relin_keys(std::string &compr_mode) = 0;
   virtual size_t sizeof_rotate_keys(std::string &compr_mode) = 0;
+  virtual size_t sizeof_galois_key() = 0;
   virtual size_t sizeof_plaintext(std::string &compr_mode, AfPtxt &pt) = 0;
   virtual size_t sizeof_ciphertext(std::string &compr_mode, AfCtxt &ct) = 0;
 
@@ -60,6 +60,17 @@ cdef extern from "Afhel.h" nogil:
         palisade
     cdef cpp_map backend_t_str[backend_t, string]
 
+    # Expression graph operation
+    cdef enum class graph_op_t(uint8_t):
+        ctxt,
+        ptxt,
+        add,
+        sub,
+        multiply,
+        negate,
+        rotate,
+        flip
+
     # ============================== Classes ===================================
     # Ciphertext
     cdef cppclass AfCtxt:
@@ -69,6 +80,19 @@ cdef extern from "Afhel.h" nogil:
     cdef cppclass AfPtxt:
         pass
 
+    # Node of an expression graph, see Afhel::eval_graph
+    cdef cppclass AfGraphNode:
+        graph_op_t op
+        int64_t lhs
+        int64_t rhs
+        int k
+        bool output
+        int mod_level
+        shared_ptr[AfCtxt] ctxt
+        shared_ptr[AfPtxt] ptxt
+        vector[double] fvalues
+        vector[int64_t] ivalues
+
     # Polynomials
     cdef cppclass AfPoly:
         AfPoly() except +
@@ -91,9 +115,15 @@ cdef extern from "Afhel.h" nogil:
         void relinKeyGen() except +
         void rotateKeyGen(vector[int] rot_steps) except +
 
+        # EVALUATION-ONLY MODE
+        void set_eval_only(bool eval_only) except +
+        bool is_eval_only() except +
+
         # ENCRYPTION
         void encrypt(AfPtxt& ptxt, AfCtxt& ctxtOut) except +
         void encrypt_v(vector[shared_ptr[AfPtxt]]& plainV, vector[shared_ptr[AfCtxt]]& ctxtVOut) except +
+        void encrypt_symmetric(AfPtxt& ptxt, AfCtxt& ctxtOut) except +
+        size_t save_encrypt_symmetric(ostream &out_stream, string &compr_mode, AfPtxt& ptxt) except +
         
         # DECRYPTION
         void decrypt(AfCtxt &ctxtInOut, AfPtxt &plainOut) except +
@@ -106,20 +136,38 @@ cdef extern from "Afhel.h" nogil:
         # ENCODE
         # bfv
         void encode_i(vector[int64_t] &values, AfPtxt &plainOut) except +
+        void encode_i(const int64_t *values, size_t n_values, AfPtxt &plainOut) except +
         # ckks
         void encode_f(vector[double] &values, double scale, AfPtxt &plainVOut) except +
+        void encode_f(const double *values, size_t n_values, double scale, AfPtxt &plainVOut) except +
         void encode_c(vector[cy_complex] &values, double scale, AfPtxt &plainVOut) except +
+        void encode_c(const cy_complex *values, size_t n_values, double scale, AfPtxt &plainVOut) except +
         # bgv
         void encode_g(vector[int64_t] &values, AfPtxt &plainOut) except +
+        void encode_g(const int64_t *values, size_t n_values, AfPtxt &plainOut) except +
 
         # DECODE
         # bfv
         void decode_i(AfPtxt &ptxt, vector[int64_t] &valueVOut) except +
+        void decode_i(AfPtxt &ptxt, int64_t *valuesOut, size_t n_values) except +
         # ckks
         void decode_f(AfPtxt &ptxt, vector[double] &valueVOut) except +
+        void decode_f(AfPtxt &ptxt, double *valuesOut, size_t n_values) except +
         void decode_c(AfPtxt &ptxt, vector[cy_complex] &valueVOut) except +
+        void decode_c(AfPtxt &ptxt, cy_complex *valuesOut, size_t n_values) except +
         # bgv
         void decode_g(AfPtxt &ptxt, vector[int64_t] &valueVOut) except +
+        void decode_g(AfPtxt &ptxt, int64_t *valuesOut, size_t n_values) except +
+
+        # BATCHED CODEC (row-major 2D arrays, one plaintext per row)
+        void encode_i_v(const int64_t *values, size_t n_rows, size_t row_len, vector[shared_ptr[AfPtxt]] &plainVOut) except +
+        void encode_f_v(const double *values, size_t n_rows, size_t row_len, double scale, vector[shared_ptr[AfPtxt]] &plainVOut) except +
+        void encode_c_v(const cy_complex *values, size_t n_rows, size_t row_len, double scale, vector[shared_ptr[AfPtxt]] &plainVOut) except +
+        void encode_g_v(const int64_t *values, size_t n_rows, size_t row_len, vector[shared_ptr[AfPtxt]] &plainVOut) except +
+        void decode_i_v(vector[shared_ptr[AfPtxt]] &plainV, int64_t *valuesOut, size_t row_len) except +
+        void decode_f_v(vector[shared_ptr[AfPtxt]] &plainV, double *valuesOut, size_t row_len) except +
+        void decode_c_v(vector[shared_ptr[AfPtxt]] &plainV, cy_complex *valuesOut, size_t row_len) except +
+        void decode_g_v(vector[shared_ptr[AfPtxt]] &plainV, int64_t *valuesOut, size_t row_len) except +
 
         # AUXILIARY
         void data(AfPtxt &ptxt, uint64_t *dest) except +
@@ -127,6 +175,10 @@ cdef extern from "Afhel.h" nogil:
         
         # -------------------------- RELINEARIZATION ---------------------------
         void relinearize(AfCtxt& ctxtInOut) except +
+        void set_auto_relin(bool enabled, size_t max_size) except +
+        bool get_auto_relin() except +
+        size_t get_relin_max_size() except +
+        vector[uint64_t] get_relin_stats(bool reset) except +
 
         # ---------------------- HOMOMORPHIC OPERATIONS ------------------------
         # Negate
@@ -158,10 +210,29 @@ cdef extern from "Afhel.h" nogil:
         void rotate_v(vector[shared_ptr[AfCtxt]]& ctxtV, int k) except +
         void flip(AfCtxt& ctxtInOut) except +
         void flip_v(vector[shared_ptr[AfCtxt]]& ctxtV) except +
+        void rotate_many(AfCtxt& ctxt, vector[int]& steps, vector[shared_ptr[AfCtxt]]& ctxtVOut) except +
+        void cumul_add(AfCtxt& ctxtInOut, size_t n_elements) except +
+        void add_many(vector[shared_ptr[AfCtxt]]& ctxtV, AfCtxt& ctxtOut) except +
+        void multiply_many(vector[shared_ptr[AfCtxt]]& ctxtV, AfCtxt& ctxtOut) except +
+
+        # Rotation key planning
+        void set_rotation_record(bool enabled, bool dry_run) except +
+        cpp_map[int, uint64_t] get_rotation_record() except +
+        vector[int] plan_rotation_keys(cpp_map[int, uint64_t]& steps, size_t max_extra) except +
+        int64_t count_rotations(vector[int]& key_steps, cpp_map[int, uint64_t]& steps) except +
+
+        # Linear algebra
+        void encode_matrix_i(const int64_t *matrix, size_t n_rows, size_t n_cols, vector[shared_ptr[AfPtxt]]& diagVOut) except +
+        void encode_matrix_f(const double *matrix, size_t n_rows, size_t n_cols, double scale, vector[shared_ptr[AfPtxt]]& diagVOut) except +
+        void matvec_plain(AfCtxt& ctxtInOut, vector[shared_ptr[AfPtxt]]& diagV) except +
 
         # Power
         void exponentiate(AfCtxt& ctxtInOut, uint64_t& expon) except +
         void exponentiate_v(vector[shared_ptr[AfCtxt]]& ctxtV, uint64_t& expon) except +
+        void eval_poly(AfCtxt& ctxtInOut, vector[double]& coeffs, bool chebyshev, double x_min, double x_max) except +
+
+        # Expression graph
+        void eval_graph(vector[AfGraphNode]& nodes) except +
 
         # ckks -> rescale and mod switching
         void rescale_to_next(AfCtxt &ctxtInOut) except +
@@ -171,13 +242,17 @@ cdef extern from "Afhel.h" nogil:
         void mod_switch_to_next_plain(AfPtxt &ptxtInOut) except +
         void mod_switch_to_next_plain_v(vector[shared_ptr[AfPtxt]]& ptxtVInOut) except +
 
+        # NTT plaintexts
+        void plain_to_ntt(AfPtxt &ptxtInOut, size_t mod_level) except +
+        size_t get_mod_level(AfCtxt &ctxt) except +
+
         # -------------------------------- I/O --------------------------------
         # SAVE/LOAD CONTEXT
         size_t save_context(ostream &out_stream, string &compr_mode) except +
         size_t load_context(istream &in_stream, int sec) except +
 
         # SAVE/LOAD PUBLICKEY
-        size_t save_public_key(ostream &out_stream, string &compr_mode) except +
+        size_t save_public_key(ostream &out_stream, string &compr_mode, bool seeded) except +
         size_t load_public_key(istream &in_stream) except +
 
         # SAVE/LOAD SECRETKEY
@@ -185,12 +260,15 @@ cdef extern from "Afhel.h" nogil:
         size_t load_secret_key(istream &in_stream) except +
 
         # SAVE/LOAD RELINKEY
-        size_t save_relin_keys(ostream &out_stream, string &compr_mode) except +
+        size_t save_relin_keys(ostream &out_stream, string &compr_mode, bool seeded) except +
         size_t load_relin_keys(istream &in_stream) except +
 
         # SAVE/LOAD ROTKEYS
-        size_t save_rotate_keys(ostream &out_stream, string &compr_mode) except +
+        size_t save_rotate_keys(ostream &out_stream, string &compr_mode, bool seeded) except +
         size_t load_rotate_keys(istream &in_stream) except +
+        size_t save_rotate_keys_store(string &filename) except +
+        size_t load_rotate_keys_store(string &filename) except +
+        vector[size_t] get_rotate_keys_store_stats() except +
 
         # SAVE/LOAD PLAINTEXT --> Could be achieved outside of Afseal
         size_t save_plaintext(ostream &out_stream, string &compr_mode, AfPtxt &plain) except +
@@ -200,12 +278,27 @@ cdef extern from "Afhel.h" nogil:
         size_t save_ciphertext(ostream &out_stream, string &compr_mode, AfCtxt &ciphert) except +
         size_t load_ciphertext(istream &in_stream, AfCtxt &plain) except +
 
+        # SAVE/LOAD IN MEMORY
+        size_t save_plaintext(uint8_t *out, size_t size, string &compr_mode, AfPtxt &plain) except +
+        size_t load_plaintext(const uint8_t *inp, size_t size, AfPtxt &plain) except +
+        size_t save_ciphertext(uint8_t *out, size_t size, string &compr_mode, AfCtxt &ciphert) except +
+        size_t load_ciphertext(const uint8_t *inp, size_t size, AfCtxt &ciphert) except +
+
+        # RAW DATA
+        vector[uint64_t] raw_header(AfCtxt &ciphert) except +
+        uint64_t *raw_data(AfCtxt &ciphert) except +
+        void load_raw(AfCtxt &ciphert, vector[uint64_t] &header, const uint8_t *data, size_t n_bytes) except +
+        vector[uint64_t] raw_header(AfPtxt &plain) except +
+        uint64_t *raw_data(AfPtxt &plain) except +
+        void load_raw(AfPtxt &plain, vector[uint64_t] &header, const uint8_t *data, size_t n_bytes) except +
+
         # SIZES
         size_t sizeof_context(string &compr_mode) except +
         size_t sizeof_public_key(string &compr_mode) except +
         size_t sizeof_secret_key(string &compr_mode) except +
         size_t sizeof_relin_keys(string &compr_mode) except +
         size_t sizeof_rotate_keys(string &compr_mode) except +
+        size_t sizeof_galois_key() except +
         size_t sizeof_plaintext(string &compr_mode, AfPtxt &pt) except +
         size_t sizeof_ciphertext(string &compr_mode, AfCtxt &ct) except +
 
@@ -264,6 +357,65 @@ cdef extern from "Afseal.h" nogil:
         int get_sec() except +
         int total_coeff_modulus_bit_count() except +
 
+    cdef cppclass AfsealMemoryPools:
+        @staticmethod
+        vector[size_t] high_water() except +
+        @staticmethod
+        size_t retired_high_water() except +
+
+    cdef cppclass AfsealTracer:
+        @staticmethod
+        void start(size_t capacity) except +
+        @staticmethod
+        size_t stop(string& path) except +
+
+    cdef cppclass AfsealStats:
+        @staticmethod
+        bool enabled()
+        @staticmethod
+        void set_enabled(bool enabled) except +
+        @staticmethod
+        void reset() except +
+        @staticmethod
+        cpp_map[string, vector[double]] snapshot() except +
+
+    cdef cppclass AfsealContextCache:
+        @staticmethod
+        void set_capacity(size_t capacity) except +
+        @staticmethod
+        void clear() except +
+        @staticmethod
+        vector[uint64_t] stats() except +
+
+    cdef cppclass AfsealTenantRegistry:
+        @staticmethod
+        void add(const string &tenant, const Afseal &afseal,
+                 double scale, const vector[int] &qi_sizes) except +
+        @staticmethod
+        shared_ptr[Afseal] get(const string &tenant) except +
+        @staticmethod
+        shared_ptr[Afseal] get(const string &tenant, double &scale,
+                               vector[int] &qi_sizes) except +
+        @staticmethod
+        void remove(const string &tenant) except +
+        @staticmethod
+        void configure(size_t budget_bytes, const string &spill_dir) except +
+        @staticmethod
+        vector[uint64_t] stats() except +
+
+    cdef cppclass AfsealCtxtFileWriter:
+        AfsealCtxtFileWriter(const string &filename, Afseal &afseal,
+                             const string &compr_mode, bool append) except +
+        void append(vector[shared_ptr[AfCtxt]] &ctxts) except +
+        void close() except +
+        size_t size()
+
+    cdef cppclass AfsealCtxtFileReader:
+        AfsealCtxtFileReader(const string &filename, Afseal &afseal) except +
+        size_t size()
+        string compr_mode()
+        void read(size_t begin, vector[shared_ptr[AfCtxt]] &ctxtVOut) except +
+
     cdef cppclass AfsealPoly(AfPoly):
         AfsealPoly(Afseal &afseal, const AfsealCtxt &ref) except+
         AfsealPoly(AfsealPoly &other) except+
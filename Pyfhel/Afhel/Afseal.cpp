@@ -37,6 +37,46 @@ using namespace seal;
 #include <chrono>
 #include <thread>
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <filesystem>
+#include <iomanip>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>   /* rotation key store mapping */
+#else
+#include <fcntl.h>     /* rotation key store mapping */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Pool for the temporaries of SEAL calls made by the current thread
+inline const MemoryPoolHandle &_pool() { return AfsealMemoryPools::local(); }
+
+// Component built on first use. Threads racing to build it may each build one,
+//  but all of them return the one stored first.
+template <class T, class F>
+shared_ptr<T> _lazy(shared_ptr<T> &member, F make)
+{
+  shared_ptr<T> p = std::atomic_load(&member);
+  if (p == nullptr)
+  {
+    shared_ptr<T> made = make();
+    if (std::atomic_compare_exchange_strong(&member, &p, made))
+    {
+      p = made;
+    }
+  }
+  return p;
+}
+}  // namespace
 
 // =============================================================================
 // ================================== AFSEAL ===================================
@@ -47,23 +87,9 @@ Afseal::Afseal(){};
 
 Afseal::Afseal(const Afseal &otherAfseal)
 {
-  this->context = make_shared<SEALContext>(otherAfseal.context->first_context_data()->parms());
-
-  // TODO: Copy Encoder ptr
-
-  this->keyGenObj = make_shared<KeyGenerator>(*context);
-  this->secretKey = make_shared<SecretKey>(*(otherAfseal.secretKey));
-  this->publicKey = make_shared<PublicKey>(*(otherAfseal.publicKey));
-  this->relinKeys = make_shared<RelinKeys>(*(otherAfseal.relinKeys));
-  this->rotateKeys = make_shared<GaloisKeys>(*(otherAfseal.rotateKeys));
-
-  this->encryptor = make_shared<Encryptor>(*context, *publicKey, *secretKey);
-  this->evaluator = make_shared<Evaluator>(*context);
-  this->decryptor = make_shared<Decryptor>(*context, *secretKey);
-
-  this->bfvEncoder = make_shared<BatchEncoder>(*context);
-  this->ckksEncoder = make_shared<CKKSEncoder>(*context);
-  this->bgvEncoder = make_shared<BatchEncoder>(*context);
+  // Shares the context, components and keys, which are never modified once
+  //  built but replaced. Missing keys stay missing.
+  *this = otherAfseal;
 };
 
 Afseal::~Afseal(){};
@@ -130,52 +156,45 @@ string Afseal::ContextGen(scheme_t scheme,
     }
   }
   // Validate parameters by putting them inside a SEALContext
-  this->context = make_shared<SEALContext>(parms, true, sec_map[sec]);
-  
-  // If parameters are valid, build {codec, evaluator, keygen}
-  if (this->context->parameters_set())
-  {
-    // Codec
-    if (scheme == scheme_t::bfv)
-    {
-      this->bfvEncoder = make_shared<BatchEncoder>(*context);
-    }         
-    else if (scheme == scheme_t::bgv)
-    {
-      this->bgvEncoder = make_shared<BatchEncoder>(*context);
-    }
-    else // ckks
-    {
-      this->ckksEncoder = make_shared<CKKSEncoder>(*context);
-    }
-    // Evaluator
-    this->evaluator = make_shared<Evaluator>(*context);
-    // Key generator
-    this->keyGenObj = make_shared<KeyGenerator>(*context);
-  }
+  this->set_context(parms, sec);
+  auto context = this->get_context();
   // Return info about parameter validity.
   //    - 'success: valid' if everything went well
   //    - Error name and message from list in seal/context/context.cpp otherwise
-  return string(this->context->parameter_error_name())  + ": " +
-                this->context->parameter_error_message();
+  return string(context->parameter_error_name())  + ": " +
+                context->parameter_error_message();
 }
 
 
+// The context comes from the context cache, and codec and evaluator are built
+//  on first use. The key generator is kept eager, except in evaluation-only
+//  mode where it is never built.
+void Afseal::set_context(const EncryptionParameters &parms, int sec)
+{
+  this->components = AfsealContextCache::get(parms, sec_map[sec]);
+  if (components->context->parameters_set())
+  {
+    this->keyGenObj = (eval_only) ? NULL : make_shared<KeyGenerator>(*(components->context));
+  }
+}
+
 // KEY GENERATION
 void Afseal::KeyGen()
 {
+  this->check_secret_allowed();
   auto &afhel_context = *(this->get_context());
   // Key generator
   this->keyGenObj = make_shared<KeyGenerator>(afhel_context); // Refresh KeyGen obj
   this->publicKey = make_shared<PublicKey>();
   keyGenObj->create_public_key(*publicKey); // Extract keys
   this->secretKey = make_shared<SecretKey>(keyGenObj->secret_key());
-  this->encryptor = make_shared<Encryptor>(afhel_context, *publicKey);
+  this->encryptor = make_shared<Encryptor>(afhel_context, *publicKey, *secretKey);
   this->decryptor = make_shared<Decryptor>(afhel_context, *secretKey);
 }
 
 void Afseal::relinKeyGen()
 {
+  this->check_secret_allowed();
   if (keyGenObj == NULL)
   {
     throw std::logic_error("<Afseal>: Context not initialized");
@@ -186,11 +205,13 @@ void Afseal::relinKeyGen()
 
 void Afseal::rotateKeyGen(vector<int> rot_steps)
 {
+  this->check_secret_allowed();
   if (keyGenObj == NULL)
   {
     throw std::logic_error("<Afseal>: Context not initialized");
   }
   rotateKeys = make_shared<GaloisKeys>();
+  rotateKeyStore = NULL;
   if (!rot_steps.empty())
   {
     keyGenObj->create_galois_keys(rot_steps, *rotateKeys);
@@ -201,31 +222,71 @@ void Afseal::rotateKeyGen(vector<int> rot_steps)
   }
 }
 
+// EVALUATION-ONLY MODE
+void Afseal::set_eval_only(bool eval_only)
+{
+  this->eval_only = eval_only;
+  if (eval_only)
+  {
+    // Drop all that derives from the secret key; encryption uses the public key
+    this->secretKey = NULL;
+    this->keyGenObj = NULL;
+    this->decryptor = NULL;
+    this->encryptor = NULL;
+  }
+}
+void Afseal::check_secret_allowed()
+{
+  if (this->eval_only)
+  {
+    throw std::logic_error("<Afseal>: Evaluation-only mode holds no secret key");
+  }
+}
+
 // ENCRYPTION
 void Afseal::encrypt(AfPtxt &plain1, AfCtxt &ctxt)
 {
-  this->get_encryptor()->encrypt(_dyn_p(plain1), _dyn_c(ctxt));
+  AfsealStats::Scope stats("encrypt");
+  stats.ctxt(ctxt);
+  this->get_encryptor()->encrypt(_dyn_p(plain1), _dyn_c(ctxt), _pool());
 }
 void Afseal::encrypt_v(vector<std::shared_ptr<AfPtxt>> &plainV, std::vector<std::shared_ptr<AfCtxt>> &ctxtVOut)
 {
+  AfsealStats::Scope stats("encrypt_v");
   auto encryptor = this->get_encryptor();
   vectorize(
       ctxtVOut, plainV,
-      [encryptor](AfCtxt c, AfPtxt p)
-      { encryptor->encrypt(_dyn_p(p), _dyn_c(c)); });
+      [encryptor](AfCtxt &c, AfPtxt &p)
+      { encryptor->encrypt(_dyn_p(p), _dyn_c(c), _pool()); });
+}
+void Afseal::encrypt_symmetric(AfPtxt &plain1, AfCtxt &ctxt)
+{
+  AfsealStats::Scope stats("encrypt_symmetric");
+  this->get_secretKey();
+  this->get_encryptor()->encrypt_symmetric(_dyn_p(plain1), _dyn_c(ctxt), _pool());
+}
+size_t Afseal::save_encrypt_symmetric(ostream &out_stream, string &compr_mode, AfPtxt &plain1)
+{
+  AfsealStats::Scope stats("save_encrypt_symmetric");
+  this->get_secretKey();
+  return stats.bytes((size_t)this->get_encryptor()->encrypt_symmetric(_dyn_p(plain1), _pool())
+      .save(out_stream, compr_mode_map[compr_mode]));
 }
 
 // DECRYPTION
 void Afseal::decrypt(AfCtxt &ctxt, AfPtxt &ptxtOut)
 {
+  AfsealStats::Scope stats("decrypt");
+  stats.ctxt(ctxt);
   this->get_decryptor()->decrypt(_dyn_c(ctxt), _dyn_p(ptxtOut));
 }
 void Afseal::decrypt_v(std::vector<std::shared_ptr<AfCtxt>> &ctxtV, vector<std::shared_ptr<AfPtxt>> &plainVOut)
 {
+  AfsealStats::Scope stats("decrypt_v");
   auto decryptor = this->get_decryptor();
   vectorize(
       ctxtV, plainVOut,
-      [decryptor](AfCtxt c, AfPtxt p)
+      [decryptor](AfCtxt &c, AfPtxt &p)
       { decryptor->decrypt(_dyn_c(c), _dyn_p(p)); });
 }
 
@@ -238,66 +299,206 @@ int Afseal::noise_level(AfCtxt &ctxt)
 // -----------------------------------------------------------------------------
 // ---------------------------------- CODEC -----------------------------------
 // -----------------------------------------------------------------------------
+// Zero-copy codec: with MSGSL, SEAL encodes from/decodes into gsl::span
+//  views of the caller buffers. Otherwise we go through a temporary vector.
+template <typename T, typename Encoder, typename... Scale>
+static void _encode_from(Encoder &encoder, const T *values, size_t n_values,
+                         Plaintext &ptxtOut, const string &scheme, Scale... scale)
+{
+  if (n_values > encoder.slot_count())
+  {
+    throw range_error("<Afseal>: Data vector size is bigger than " + scheme + " nSlots");
+  }
+  // Only the ckks encoder (the one taking a scale) needs temporaries
+#ifdef SEAL_USE_MSGSL
+  gsl::span<const T> in(values, n_values);
+#else
+  vector<T> in(values, values + n_values);
+#endif
+  if constexpr (sizeof...(Scale) > 0)
+  {
+    encoder.encode(in, scale..., ptxtOut, _pool());
+  }
+  else
+  {
+    encoder.encode(in, ptxtOut);
+  }
+}
+// Fills valuesOut with the first n_values slots, zero padding beyond nSlots.
+template <typename T, typename Encoder>
+static void _decode_into(Encoder &encoder, const Plaintext &ptxt, T *valuesOut, size_t n_values)
+{
+#ifdef SEAL_USE_MSGSL
+  if (n_values == encoder.slot_count())
+  {
+    encoder.decode(ptxt, gsl::span<T>(valuesOut, n_values), _pool());
+    return;
+  }
+#endif
+  vector<T> values;
+  encoder.decode(ptxt, values, _pool());
+  size_t n = std::min(values.size(), n_values);
+  std::copy(values.begin(), values.begin() + n, valuesOut);
+  std::fill(valuesOut + n, valuesOut + n_values, T());
+}
+
 // ENCODE
 // bfv
 void Afseal::encode_i(vector<int64_t> &values, AfPtxt &ptxtOut)
 {
-  auto bfv_encoder = this->get_bfv_encoder();
-  if (values.size() > bfv_encoder->slot_count())
-  {
-    throw range_error("<Afseal>: Data vector size is bigger than bfv nSlots");
-  }
-  bfvEncoder->encode(values, _dyn_p(ptxtOut));
+  encode_i(values.data(), values.size(), ptxtOut);
+}
+void Afseal::encode_i(const int64_t *values, size_t n_values, AfPtxt &ptxtOut)
+{
+  AfsealStats::Scope stats("encode");
+  _encode_from(*this->get_bfv_encoder(), values, n_values, _dyn_p(ptxtOut), "bfv");
 }
 // ckks
 void Afseal::encode_f(vector<double> &values, double scale, AfPtxt &ptxtOut)
 {
-  auto ckks_encoder = this->get_ckks_encoder();
-  if (values.size() > ckks_encoder->slot_count())
-  {
-    throw range_error("<Afseal>: Data vector size is bigger than ckks nSlots");
-  }
-  ckks_encoder->encode(values, scale, _dyn_p(ptxtOut));
+  encode_f(values.data(), values.size(), scale, ptxtOut);
+}
+void Afseal::encode_f(const double *values, size_t n_values, double scale, AfPtxt &ptxtOut)
+{
+  AfsealStats::Scope stats("encode");
+  _encode_from(*this->get_ckks_encoder(), values, n_values, _dyn_p(ptxtOut), "ckks", scale);
 }
 void Afseal::encode_c(std::vector<complex<double>> &values, double scale, AfPtxt &ptxtOut)
 {
-  auto ckks_encoder = this->get_ckks_encoder();
-  if (values.size() > ckks_encoder->slot_count())
-  {
-    throw range_error("<Afseal>: Data vector size is bigger than ckks nSlots");
-  }
-  ckks_encoder->encode(values, scale, _dyn_p(ptxtOut));
+  encode_c(values.data(), values.size(), scale, ptxtOut);
+}
+void Afseal::encode_c(const complex<double> *values, size_t n_values, double scale, AfPtxt &ptxtOut)
+{
+  AfsealStats::Scope stats("encode");
+  _encode_from(*this->get_ckks_encoder(), values, n_values, _dyn_p(ptxtOut), "ckks", scale);
 }
 // bgv
 void Afseal::encode_g(vector<int64_t> &values, AfPtxt &ptxtOut)
 {
-    auto bgv_encoder = this->get_bgv_encoder();
-    if (values.size() > bgv_encoder->slot_count())
-        {
-        throw range_error("<Afseal>: Data vector size is bigger than bgv nSlots");
-        }
-    bgvEncoder->encode(values, _dyn_p(ptxtOut));
+  encode_g(values.data(), values.size(), ptxtOut);
+}
+void Afseal::encode_g(const int64_t *values, size_t n_values, AfPtxt &ptxtOut)
+{
+  AfsealStats::Scope stats("encode");
+  _encode_from(*this->get_bgv_encoder(), values, n_values, _dyn_p(ptxtOut), "bgv");
 }
 
 // DECODE
 // bfv
 void Afseal::decode_i(AfPtxt &plain1, std::vector<int64_t> &valueVOut)
 {
-  this->get_bfv_encoder()->decode(_dyn_p(plain1), valueVOut);
+  AfsealStats::Scope stats("decode");
+  this->get_bfv_encoder()->decode(_dyn_p(plain1), valueVOut, _pool());
+}
+void Afseal::decode_i(AfPtxt &plain1, int64_t *valuesOut, size_t n_values)
+{
+  AfsealStats::Scope stats("decode");
+  _decode_into(*this->get_bfv_encoder(), _dyn_p(plain1), valuesOut, n_values);
 }
 // ckks
 void Afseal::decode_f(AfPtxt &plain1, vector<double> &valueVOut)
 {
-  this->get_ckks_encoder()->decode(_dyn_p(plain1), valueVOut);
+  AfsealStats::Scope stats("decode");
+  this->get_ckks_encoder()->decode(_dyn_p(plain1), valueVOut, _pool());
+}
+void Afseal::decode_f(AfPtxt &plain1, double *valuesOut, size_t n_values)
+{
+  AfsealStats::Scope stats("decode");
+  _decode_into(*this->get_ckks_encoder(), _dyn_p(plain1), valuesOut, n_values);
 }
 void Afseal::decode_c(AfPtxt &plain1, vector<std::complex<double>> &valueVOut)
 {
-  this->get_ckks_encoder()->decode(_dyn_p(plain1), valueVOut);
+  AfsealStats::Scope stats("decode");
+  this->get_ckks_encoder()->decode(_dyn_p(plain1), valueVOut, _pool());
+}
+void Afseal::decode_c(AfPtxt &plain1, complex<double> *valuesOut, size_t n_values)
+{
+  AfsealStats::Scope stats("decode");
+  _decode_into(*this->get_ckks_encoder(), _dyn_p(plain1), valuesOut, n_values);
 }
 // bgv
 void Afseal::decode_g(AfPtxt &plain1, std::vector<int64_t> &valueVOut)
 {
-  this->get_bgv_encoder()->decode(_dyn_p(plain1), valueVOut);
+  AfsealStats::Scope stats("decode");
+  this->get_bgv_encoder()->decode(_dyn_p(plain1), valueVOut, _pool());
+}
+void Afseal::decode_g(AfPtxt &plain1, int64_t *valuesOut, size_t n_values)
+{
+  AfsealStats::Scope stats("decode");
+  _decode_into(*this->get_bgv_encoder(), _dyn_p(plain1), valuesOut, n_values);
+}
+
+// BATCHED CODEC
+// Encodes each row of a row-major n_rows x row_len array into its own
+//  plaintext, running the rows in parallel on the AfsealTaskPool.
+template <typename T, typename EncodeF>
+static void _encode_rows(const T *values, size_t n_rows, size_t row_len,
+                         vector<shared_ptr<AfPtxt>> &ptxtVOut, EncodeF encode)
+{
+  ptxtVOut.resize(n_rows);
+  for (auto &p : ptxtVOut)
+  {
+    if (!p) { p = make_shared<AfsealPtxt>(); }
+  }
+  AfsealTaskPool::instance().parallel_for(n_rows, [&](size_t i)
+    { encode(values + i * row_len, *ptxtVOut[i]); });
+}
+// Decodes each plaintext into one row of a preallocated row-major array.
+template <typename T, typename DecodeF>
+static void _decode_rows(vector<shared_ptr<AfPtxt>> &ptxtV, T *valuesOut, size_t row_len,
+                         DecodeF decode)
+{
+  AfsealTaskPool::instance().parallel_for(ptxtV.size(), [&](size_t i)
+    { decode(*ptxtV[i], valuesOut + i * row_len); });
+}
+
+void Afseal::encode_i_v(const int64_t *values, size_t n_rows, size_t row_len, vector<shared_ptr<AfPtxt>> &ptxtVOut)
+{
+  AfsealStats::Scope stats("encode_v");
+  _encode_rows(values, n_rows, row_len, ptxtVOut,
+      [this, row_len](const int64_t *v, AfPtxt &p){ encode_i(v, row_len, p); });
+}
+void Afseal::encode_f_v(const double *values, size_t n_rows, size_t row_len, double scale, vector<shared_ptr<AfPtxt>> &ptxtVOut)
+{
+  AfsealStats::Scope stats("encode_v");
+  _encode_rows(values, n_rows, row_len, ptxtVOut,
+      [this, row_len, scale](const double *v, AfPtxt &p){ encode_f(v, row_len, scale, p); });
+}
+void Afseal::encode_c_v(const complex<double> *values, size_t n_rows, size_t row_len, double scale, vector<shared_ptr<AfPtxt>> &ptxtVOut)
+{
+  AfsealStats::Scope stats("encode_v");
+  _encode_rows(values, n_rows, row_len, ptxtVOut,
+      [this, row_len, scale](const complex<double> *v, AfPtxt &p){ encode_c(v, row_len, scale, p); });
+}
+void Afseal::encode_g_v(const int64_t *values, size_t n_rows, size_t row_len, vector<shared_ptr<AfPtxt>> &ptxtVOut)
+{
+  AfsealStats::Scope stats("encode_v");
+  _encode_rows(values, n_rows, row_len, ptxtVOut,
+      [this, row_len](const int64_t *v, AfPtxt &p){ encode_g(v, row_len, p); });
+}
+void Afseal::decode_i_v(vector<shared_ptr<AfPtxt>> &ptxtV, int64_t *valuesOut, size_t row_len)
+{
+  AfsealStats::Scope stats("decode_v");
+  _decode_rows(ptxtV, valuesOut, row_len,
+      [this, row_len](AfPtxt &p, int64_t *v){ decode_i(p, v, row_len); });
+}
+void Afseal::decode_f_v(vector<shared_ptr<AfPtxt>> &ptxtV, double *valuesOut, size_t row_len)
+{
+  AfsealStats::Scope stats("decode_v");
+  _decode_rows(ptxtV, valuesOut, row_len,
+      [this, row_len](AfPtxt &p, double *v){ decode_f(p, v, row_len); });
+}
+void Afseal::decode_c_v(vector<shared_ptr<AfPtxt>> &ptxtV, complex<double> *valuesOut, size_t row_len)
+{
+  AfsealStats::Scope stats("decode_v");
+  _decode_rows(ptxtV, valuesOut, row_len,
+      [this, row_len](AfPtxt &p, complex<double> *v){ decode_c(p, v, row_len); });
+}
+void Afseal::decode_g_v(vector<shared_ptr<AfPtxt>> &ptxtV, int64_t *valuesOut, size_t row_len)
+{
+  AfsealStats::Scope stats("decode_v");
+  _decode_rows(ptxtV, valuesOut, row_len,
+      [this, row_len](AfPtxt &p, int64_t *v){ decode_g(p, v, row_len); });
 }
 
 // AUXILIARY
@@ -313,15 +514,78 @@ void Afseal::data(AfPtxt &ptxt, uint64_t *dest)
 // ------------------------------ RELINEARIZATION -----------------------------
 void Afseal::relinearize(AfCtxt &ctxt)
 {
-  this->get_evaluator()->relinearize_inplace(_dyn_c(ctxt), *(this->get_relinKeys()));
+  AfsealStats::Scope stats("relinearize");
+  stats.ctxt(ctxt);
+  this->get_evaluator()->relinearize_inplace(_dyn_c(ctxt), *(this->get_relinKeys()), _pool());
 }
-void Afseal::relinearize_v(vector<std::shared_ptr<AfCtxt>> ctxtV)
+void Afseal::relinearize_v(vector<std::shared_ptr<AfCtxt>> &ctxtV)
 {
+  AfsealStats::Scope stats("relinearize_v");
   auto ev = this->get_evaluator();
-  seal::RelinKeys &rlk = *(this->get_relinKeys());
+  auto rlk = this->get_relinKeys();  // Shared, not copied
   vectorize(ctxtV,
-            [ev, rlk](AfCtxt c)
-            { ev->relinearize_inplace(_dyn_c(c), rlk); });
+            [ev, rlk](AfCtxt &c)
+            { ev->relinearize_inplace(_dyn_c(c), *rlk, _pool()); });
+}
+void Afseal::set_auto_relin(bool enabled, size_t max_size)
+{
+  // relinKeyGen only creates the key of s^2, which relinearizes size 3
+  if (max_size < 2 || max_size > 3)
+  {
+    throw std::invalid_argument("<Afseal>: Relinearization max size must be 2 or 3");
+  }
+  this->auto_relin = enabled;
+  this->relin_max_size = max_size;
+}
+bool Afseal::get_auto_relin()
+{
+  return this->auto_relin;
+}
+size_t Afseal::get_relin_max_size()
+{
+  return this->relin_max_size;
+}
+vector<uint64_t> Afseal::get_relin_stats(bool reset)
+{
+  uint64_t deferred = reset ? relin_stats.deferred.exchange(0) : relin_stats.deferred.load();
+  uint64_t performed = reset ? relin_stats.performed.exchange(0) : relin_stats.performed.load();
+  // Eager relinearization costs one key switch per product
+  return {deferred, performed, deferred > performed ? deferred - performed : 0};
+}
+void Afseal::relin_operand(Ciphertext &ctxt)
+{
+  if (this->auto_relin && ctxt.size() > 2)
+  {
+    AfsealStats::Scope stats("auto_relin");
+    this->get_evaluator()->relinearize_inplace(ctxt, *(this->get_relinKeys()), _pool());
+    relin_stats.performed++;
+  }
+}
+const Ciphertext &Afseal::relin_operand(const Ciphertext &ctxt, Ciphertext &tmp)
+{
+  if (!this->auto_relin || ctxt.size() <= 2)
+  {
+    return ctxt;
+  }
+  AfsealStats::Scope stats("auto_relin");
+  tmp = ctxt;
+  this->get_evaluator()->relinearize_inplace(tmp, *(this->get_relinKeys()), _pool());
+  relin_stats.performed++;
+  return tmp;
+}
+void Afseal::relin_product(Ciphertext &ctxt)
+{
+  if (!this->auto_relin || ctxt.size() <= 2) { return; }
+  if (ctxt.size() > this->relin_max_size)
+  {
+    AfsealStats::Scope stats("auto_relin");
+    this->get_evaluator()->relinearize_inplace(ctxt, *(this->get_relinKeys()), _pool());
+    relin_stats.performed++;
+  }
+  else
+  {
+    relin_stats.deferred++;
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -330,566 +594,3796 @@ void Afseal::relinearize_v(vector<std::shared_ptr<AfCtxt>> ctxtV)
 // NEGATE
 void Afseal::negate(AfCtxt &ctxt)
 {
+  AfsealStats::Scope stats("negate");
+  stats.ctxt(ctxt);
   this->get_evaluator()->negate_inplace(_dyn_c(ctxt));
 }
 void Afseal::negate_v(vector<std::shared_ptr<AfCtxt>> &ctxtV)
 {
+  AfsealStats::Scope stats("negate_v");
   auto ev = this->get_evaluator();
   vectorize(ctxtV,
-            [ev](AfCtxt c)
+            [ev](AfCtxt &c)
             { ev->negate_inplace(_dyn_c(c)); });
 }
 
 // SQUARE
 void Afseal::square(AfCtxt &ctxt)
 {
-  this->get_evaluator()->square_inplace(_dyn_c(ctxt));
+  AfsealStats::Scope stats("square");
+  stats.ctxt(ctxt);
+  Ciphertext &c = _dyn_c(ctxt);
+  if (2 * c.size() - 1 > this->relin_max_size) { relin_operand(c); }
+  this->get_evaluator()->square_inplace(c, _pool());
+  relin_product(c);
 }
 void Afseal::square_v(vector<std::shared_ptr<AfCtxt>> &ctxtV)
 {
+  AfsealStats::Scope stats("square_v");
   auto ev = this->get_evaluator();
   vectorize(ctxtV,
-            [ev](AfCtxt c)
-            { ev->square_inplace(_dyn_c(c)); });
+            [this, ev](AfCtxt &ctxt)
+            {
+              Ciphertext &c = _dyn_c(ctxt);
+              if (2 * c.size() - 1 > relin_max_size) { relin_operand(c); }
+              ev->square_inplace(c, _pool());
+              relin_product(c);
+            });
 }
 
 // ADDITION
 void Afseal::add(AfCtxt &cipherInOut, AfCtxt &cipher2)
 {
+  AfsealStats::Scope stats("add");
+  stats.ctxt(cipherInOut);
   this->get_evaluator()->add_inplace(_dyn_c(cipherInOut), _dyn_c(cipher2));
 }
 void Afseal::add_plain(AfCtxt &cipherInOut, AfPtxt &plain2)
 {
-  this->get_evaluator()->add_plain_inplace(_dyn_c(cipherInOut), _dyn_p(plain2));
+  AfsealStats::Scope stats("add_plain");
+  stats.ctxt(cipherInOut);
+  this->get_evaluator()->add_plain_inplace(_dyn_c(cipherInOut), _dyn_p(plain2), _pool());
 }
 void Afseal::add_v(vector<std::shared_ptr<AfCtxt>> &ctxtVInOut, vector<std::shared_ptr<AfCtxt>> &ctxtV2)
 {
+  AfsealStats::Scope stats("add_v");
   auto ev = this->get_evaluator();
   vectorize(ctxtVInOut, ctxtV2,
-            [ev](AfCtxt c, AfCtxt c2)
+            [ev](AfCtxt &c, AfCtxt &c2)
             { ev->add_inplace(_dyn_c(c), _dyn_c(c2)); });
 }
 void Afseal::add_plain_v(vector<std::shared_ptr<AfCtxt>> &ctxtVInOut, vector<std::shared_ptr<AfPtxt>> &ptxtV)
 {
+  AfsealStats::Scope stats("add_plain_v");
   auto ev = this->get_evaluator();
   vectorize(ctxtVInOut, ptxtV,
-            [ev](AfCtxt c, AfPtxt p2)
-            { ev->add_plain_inplace(_dyn_c(c), _dyn_p(p2)); });
+            [ev](AfCtxt &c, AfPtxt &p2)
+            { ev->add_plain_inplace(_dyn_c(c), _dyn_p(p2), _pool()); });
 }
 
 // SUBTRACTION
 void Afseal::sub(AfCtxt &cipherInOut, AfCtxt &cipher2)
 {
+  AfsealStats::Scope stats("sub");
+  stats.ctxt(cipherInOut);
   this->get_evaluator()->sub_inplace(_dyn_c(cipherInOut), _dyn_c(cipher2));
 }
 void Afseal::sub_plain(AfCtxt &cipherInOut, AfPtxt &plain2)
 {
-  this->get_evaluator()->sub_plain_inplace(_dyn_c(cipherInOut), _dyn_p(plain2));
+  AfsealStats::Scope stats("sub_plain");
+  stats.ctxt(cipherInOut);
+  this->get_evaluator()->sub_plain_inplace(_dyn_c(cipherInOut), _dyn_p(plain2), _pool());
 }
 void Afseal::sub_v(vector<std::shared_ptr<AfCtxt>> &ctxtVInOut, vector<std::shared_ptr<AfCtxt>> &ctxtV2)
 {
+  AfsealStats::Scope stats("sub_v");
   auto ev = this->get_evaluator();
   vectorize(ctxtVInOut, ctxtV2,
-            [ev](AfCtxt c, AfCtxt c2)
+            [ev](AfCtxt &c, AfCtxt &c2)
             { ev->sub_inplace(_dyn_c(c), _dyn_c(c2)); });
 }
 void Afseal::sub_plain_v(vector<std::shared_ptr<AfCtxt>> &ctxtVInOut, vector<std::shared_ptr<AfPtxt>> &ptxtV)
 {
+  AfsealStats::Scope stats("sub_plain_v");
   auto ev = this->get_evaluator();
   vectorize(ctxtVInOut, ptxtV,
-            [ev](AfCtxt c, AfPtxt p2)
-            { ev->sub_plain_inplace(_dyn_c(c), _dyn_p(p2)); });
+            [ev](AfCtxt &c, AfPtxt &p2)
+            { ev->sub_plain_inplace(_dyn_c(c), _dyn_p(p2), _pool()); });
 }
 
 // MULTIPLICATION
 void Afseal::multiply(AfCtxt &cipherInOut, AfCtxt &cipher2)
 {
-  this->get_evaluator()->multiply_inplace(_dyn_c(cipherInOut), _dyn_c(cipher2));
+  AfsealStats::Scope stats("multiply");
+  stats.ctxt(cipherInOut);
+  Ciphertext &c = _dyn_c(cipherInOut);
+  const Ciphertext *c2 = &_dyn_c(cipher2);
+  Ciphertext tmp;   // cipher2 is only read: relinearized on a copy
+  if (c.size() + c2->size() - 1 > this->relin_max_size)
+  {
+    relin_operand(c);
+    c2 = &relin_operand(*c2, tmp);
+  }
+  this->get_evaluator()->multiply_inplace(c, *c2, _pool());
+  relin_product(c);
+}
+namespace
+{
+// Plaintext product accepting plaintexts already in NTT form (plain_to_ntt):
+//  bfv ciphertexts are moved to the NTT domain for the dyadic product.
+void _multiply_plain(Evaluator &ev, Ciphertext &ctxt, const Plaintext &ptxt)
+{
+  if (ptxt.is_ntt_form() && !ctxt.is_ntt_form())
+  {
+    if (ptxt.parms_id() != ctxt.parms_id())
+    {
+      throw std::invalid_argument("<Afseal>: NTT plaintext and ciphertext are at different levels");
+    }
+    ev.transform_to_ntt_inplace(ctxt);
+    ev.multiply_plain_inplace(ctxt, ptxt, _pool());
+    ev.transform_from_ntt_inplace(ctxt);
+  }
+  else
+  {
+    ev.multiply_plain_inplace(ctxt, ptxt, _pool());
+  }
 }
+}  // namespace
+
 void Afseal::multiply_plain(AfCtxt &cipherInOut, AfPtxt &plain1)
 {
-  this->get_evaluator()->multiply_plain_inplace(_dyn_c(cipherInOut), _dyn_p(plain1));
+  AfsealStats::Scope stats("multiply_plain");
+  stats.ctxt(cipherInOut);
+  _multiply_plain(*this->get_evaluator(), _dyn_c(cipherInOut), _dyn_p(plain1));
 }
 void Afseal::multiply_v(vector<std::shared_ptr<AfCtxt>> &ctxtVInOut, vector<std::shared_ptr<AfCtxt>> &ctxtV2)
 {
+  AfsealStats::Scope stats("multiply_v");
   auto ev = this->get_evaluator();
   vectorize(ctxtVInOut, ctxtV2,
-            [ev](AfCtxt c, AfCtxt c2)
-            { ev->multiply_inplace(_dyn_c(c), _dyn_c(c2)); });
+            [this, ev](AfCtxt &ctxt, AfCtxt &ctxt2)
+            {
+              Ciphertext &c = _dyn_c(ctxt);
+              const Ciphertext *c2 = &_dyn_c(ctxt2);
+              Ciphertext tmp;
+              if (c.size() + c2->size() - 1 > relin_max_size)
+              {
+                relin_operand(c);
+                c2 = &relin_operand(*c2, tmp);
+              }
+              ev->multiply_inplace(c, *c2, _pool());
+              relin_product(c);
+            });
 }
 void Afseal::multiply_plain_v(vector<std::shared_ptr<AfCtxt>> &ctxtVInOut, vector<std::shared_ptr<AfPtxt>> &ptxtV)
 {
+  AfsealStats::Scope stats("multiply_plain_v");
   auto ev = this->get_evaluator();
   vectorize(ctxtVInOut, ptxtV,
-            [ev](AfCtxt c, AfPtxt p2)
-            { ev->multiply_plain_inplace(_dyn_c(c), _dyn_p(p2)); });
+            [ev](AfCtxt &c, AfPtxt &p2)
+            { _multiply_plain(*ev, _dyn_c(c), _dyn_p(p2)); });
 }
 
 // ROTATION
 void Afseal::rotate(AfCtxt &ctxt, int k)
 {
-  if (this->get_scheme() == scheme_t::bfv || this->get_scheme() == scheme_t::bgv)
-  {
-    this->get_evaluator()->rotate_rows_inplace(_dyn_c(ctxt), k, *(this->get_rotateKeys()));
-  }
-  else if (this->get_scheme() == scheme_t::ckks)
-  {
-    this->get_evaluator()->rotate_vector_inplace(_dyn_c(ctxt), k, *(this->get_rotateKeys()));
-  }
-  else
+  AfsealStats::Scope stats("rotate", k, true);
+  stats.ctxt(ctxt);
+  scheme_t scheme = this->get_scheme();
+  if (scheme != scheme_t::bfv && scheme != scheme_t::bgv && scheme != scheme_t::ckks)
   {
     throw std::logic_error("<Afseal>: Scheme not supported for rotation");
   }
+  relin_operand(_dyn_c(ctxt));
+  rotate_to(_dyn_c(ctxt), k, _dyn_c(ctxt));
 }
 void Afseal::rotate_v(vector<std::shared_ptr<AfCtxt>> &ctxtV, int k)
 {
-  auto ev = this->get_evaluator();
-  auto &rtk = *(this->get_rotateKeys());
-  if (this->get_scheme() == scheme_t::bfv || this->get_scheme() == scheme_t::bgv)
-  {
-    vectorize(ctxtV,
-              [ev, k, rtk](AfCtxt c)
-              { ev->rotate_rows_inplace(_dyn_c(c), k, rtk); });
-  }
-  else if (this->get_scheme() == scheme_t::ckks)
-  {
-    vectorize(ctxtV,
-              [ev, k, rtk](AfCtxt c)
-              { ev->rotate_vector_inplace(_dyn_c(c), k, rtk); });
-  }
-  else
+  AfsealStats::Scope stats("rotate_v", k, true);
+  scheme_t scheme = this->get_scheme();
+  if (scheme != scheme_t::bfv && scheme != scheme_t::bgv && scheme != scheme_t::ckks)
   {
     throw std::logic_error("<Afseal>: Scheme not supported for rotation");
   }
+  vectorize(ctxtV,
+            [this, k](AfCtxt &c)
+            { relin_operand(_dyn_c(c)); rotate_to(_dyn_c(c), k, _dyn_c(c)); });
 }
 void Afseal::flip(AfCtxt &ctxt)
 {
-  if (this->get_scheme() == scheme_t::bfv)
-  {
-    this->get_evaluator()->rotate_columns_inplace(_dyn_c(ctxt), *(this->get_rotateKeys()));
-  }
-  else
+  AfsealStats::Scope stats("flip");
+  stats.ctxt(ctxt);
+  if (this->get_scheme() != scheme_t::bfv)
   {
     throw std::logic_error("<Afseal>: Only bfv scheme supports column rotation");
   }
+  relin_operand(_dyn_c(ctxt));
+  flip_to(_dyn_c(ctxt), _dyn_c(ctxt));
 }
 void Afseal::flip_v(vector<std::shared_ptr<AfCtxt>> &ctxtV)
 {
-  auto ev = this->get_evaluator();
-  auto &rtk = *(this->get_rotateKeys());
-  if (this->get_scheme() == scheme_t::bfv)
-  {
-    vectorize(ctxtV,
-              [ev, rtk](AfCtxt c)
-              { ev->rotate_columns_inplace(_dyn_c(c), rtk); });
-  }
-  else
+  AfsealStats::Scope stats("flip_v");
+  if (this->get_scheme() != scheme_t::bfv)
   {
     throw std::logic_error("<Afseal>: Only bfv scheme supports column rotation");
   }
-}
-
-// POLYNOMIALS
-void Afseal::exponentiate(AfCtxt &ctxt, uint64_t &expon)
-{
-  this->get_evaluator()->exponentiate_inplace(_dyn_c(ctxt), expon, *relinKeys);
-}
-void Afseal::exponentiate_v(vector<std::shared_ptr<AfCtxt>> &ctxtV, uint64_t &expon)
-{
-  auto ev = this->get_evaluator();
-  auto &rlk = *(this->get_relinKeys());
   vectorize(ctxtV,
-            [ev, expon, rlk](AfCtxt c)
-            { ev->exponentiate_inplace(_dyn_c(c), expon, rlk); });
+            [this](AfCtxt &c)
+            { relin_operand(_dyn_c(c)); flip_to(_dyn_c(c), _dyn_c(c)); });
 }
-
-// CKKS -> Rescaling and mod switching
-void Afseal::rescale_to_next(AfCtxt &ctxt)
+void Afseal::rotate_many(AfCtxt &ctxt, vector<int> &steps, vector<shared_ptr<AfCtxt>> &ctxtVOut)
 {
-  if (this->get_scheme() == scheme_t::ckks)
+  AfsealStats::Scope stats("rotate_many");
+  scheme_t scheme = this->get_scheme();
+  if (scheme != scheme_t::bfv && scheme != scheme_t::bgv && scheme != scheme_t::ckks)
   {
-    this->get_evaluator()->rescale_to_next_inplace(_dyn_c(ctxt));
+    throw std::logic_error("<Afseal>: Scheme not supported for rotation");
   }
-  else
+  relin_operand(_dyn_c(ctxt));
+  const Ciphertext &c_in = _dyn_c(ctxt);
+  ctxtVOut.resize(steps.size());
+  for (auto &c : ctxtVOut)
   {
-    throw std::logic_error("<Afseal>: Scheme must be ckks");
+    if (!c) { c = make_shared<AfsealCtxt>(); }
   }
+  // SEAL decomposes the input again for every key switch (no hoisting in its
+  //  public API), so the gain comes from running the rotations concurrently
+  //  on a shared, read-only input and writing straight into the outputs.
+  AfsealTaskPool::instance().parallel_for(steps.size(), [&](size_t i)
+  {
+    rotate_to(c_in, steps[i], _dyn_c(*ctxtVOut[i]));
+  });
 }
-void Afseal::rescale_to_next_v(vector<std::shared_ptr<AfCtxt>> &ctxtV)
+void Afseal::cumul_add(AfCtxt &ctxt, size_t n_elements)
 {
+  AfsealStats::Scope stats("cumul_add");
   auto ev = this->get_evaluator();
-  if (this->get_scheme() == scheme_t::ckks)
+  scheme_t scheme = this->get_scheme();
+  size_t n_slots = this->get_nSlots();
+  if (n_elements == 0 || n_elements > n_slots)
   {
-    vectorize(ctxtV,
-              [ev](AfCtxt c)
-              { ev->rescale_to_next_inplace(_dyn_c(c)); });
+    n_elements = n_slots;
+  }
+  Ciphertext &c = _dyn_c(ctxt);
+  relin_operand(c);
+  Ciphertext aux;   // Scratch buffer, reused by every step
+  if (scheme == scheme_t::bfv || scheme == scheme_t::bgv)
+  {
+    // Add the second row first, then loop over a single row
+    if (n_elements > n_slots / 2)
+    {
+      flip_to(c, aux);
+      ev->add_inplace(c, aux);
+      n_elements = n_slots / 2;
+    }
+    for (size_t k = 1; k < n_elements; k *= 2)
+    {
+      rotate_to(c, -static_cast<int>(k), aux);
+      ev->add_inplace(c, aux);
+    }
+  }
+  else if (scheme == scheme_t::ckks)
+  {
+    for (size_t k = 1; k < n_elements; k *= 2)
+    {
+      rotate_to(c, -static_cast<int>(k), aux);
+      ev->add_inplace(c, aux);
+    }
   }
   else
   {
-    throw std::logic_error("<Afseal>: Scheme must be ckks");
+    throw std::logic_error("<Afseal>: Scheme not supported for rotation");
   }
 }
-
-void Afseal::mod_switch_to_next(AfCtxt &ctxt)
+// REDUCTIONS
+namespace
 {
-  this->get_evaluator()->mod_switch_to_next_inplace(_dyn_c(ctxt));
-}
-void Afseal::mod_switch_to_next_v(vector<std::shared_ptr<AfCtxt>> &ctxtV)
+// Folds v[i + keep] into v[i] in parallel until one element is left, with
+//  keep = ceil(n/2): ceil(log2(v.size())) levels. The middle element of an
+//  odd level is carried to the next one.
+template <class F>
+void _tree_reduce(vector<Ciphertext> &v, F fold)
 {
-  auto ev = this->get_evaluator();
-  vectorize(ctxtV,
-            [ev](AfCtxt c)
-            { ev->mod_switch_to_next_inplace(_dyn_c(c)); });
+  for (size_t n = v.size(); n > 1; n = (n + 1) / 2)
+  {
+    size_t keep = (n + 1) / 2;
+    AfsealTaskPool::instance().parallel_for(n / 2, [&](size_t i) { fold(v[i], v[i + keep]); });
+  }
 }
 
-void Afseal::mod_switch_to_next_plain(AfPtxt &ptxt)
-{
-  this->get_evaluator()->mod_switch_to_next_inplace(_dyn_p(ptxt));
-}
-void Afseal::mod_switch_to_next_plain_v(vector<std::shared_ptr<AfPtxt>> &plainV)
+// Scale bits, rounded as in PyCtxt.scale_bits
+long _scale_bits(double scale)
 {
-  auto ev = this->get_evaluator();
-  vectorize(plainV,
-            [ev](AfPtxt p)
-            { ev->mod_switch_to_next_inplace(_dyn_p(p)); });
+  return std::lround(std::log2(scale));
 }
 
-// -----------------------------------------------------------------------------
-// ------------------------------------- I/O -----------------------------------
-// -----------------------------------------------------------------------------
-// SAVE/LOAD CONTEXT
-size_t Afseal::save_context(ostream &out_stream, string &compr_mode)
-{
-  return (size_t)this->get_context()->key_context_data()->parms().save(
-      out_stream, compr_mode_map[compr_mode]);
-}
-size_t Afseal::load_context(istream &in_stream, int sec)
+// Takes c down to `target`, rescaling at each level where its scale exceeds
+//  `scale` by the dropped prime (up to rounding), mod switching otherwise.
+void _rescale_down(const SEALContext &context, Evaluator &ev, Ciphertext &c,
+                   parms_id_type target, double scale)
 {
-  EncryptionParameters parms;
-  size_t loaded_bytes = (size_t)parms.load(in_stream);
-  this->context = make_shared<SEALContext>(parms, true, sec_map[sec]);
-  if (parms.scheme() == scheme_type::bfv)
-  {
-    this->bfvEncoder = make_shared<BatchEncoder>(*context);
-  }    
-  else if (parms.scheme() == scheme_type::bgv)
+  while (c.parms_id() != target)
   {
-  this->bgvEncoder = make_shared<BatchEncoder>(*context);
+    auto data = context.get_context_data(c.parms_id());
+    double prime = static_cast<double>(data->parms().coeff_modulus().back().value());
+    if (_scale_bits(c.scale() / scale) == _scale_bits(prime))
+    {
+      ev.rescale_to_next_inplace(c, _pool());
+    }
+    else
+    {
+      ev.mod_switch_to_next_inplace(c, _pool());
+    }
   }
-  else if (parms.scheme() == scheme_type::ckks)
+}
+
+// Brings `a` or `b` down to the lowest of their levels. Returns `b`, or its
+//  switched copy in `tmp`. With match_scale (ckks additions), the operand
+//  above is rescaled instead of mod switched where that matches the other
+//  scale, and `a` takes the scale of `b` when both have the same scale bits,
+//  like PyCtxt.round_scale. Other scale mismatches throw invalid_argument.
+const Ciphertext &_align(const SEALContext &context, Evaluator &ev,
+                         Ciphertext &a, const Ciphertext &b, Ciphertext &tmp,
+                         bool match_scale = false)
+{
+  const Ciphertext *b_ = &b;
+  if (a.parms_id() != b.parms_id())
   {
-    this->ckksEncoder = make_shared<CKKSEncoder>(*context);
+    auto a_data = context.get_context_data(a.parms_id());
+    auto b_data = context.get_context_data(b.parms_id());
+    if (!a_data || !b_data)
+    {
+      throw std::invalid_argument("<Afseal>: Ciphertext is not valid for the current context");
+    }
+    if (a_data->chain_index() > b_data->chain_index())
+    {
+      if (match_scale)
+      {
+        _rescale_down(context, ev, a, b.parms_id(), b.scale());
+      }
+      else
+      {
+        ev.mod_switch_to_inplace(a, b.parms_id(), _pool());
+      }
+    }
+    else if (match_scale)
+    {
+      tmp = b;
+      _rescale_down(context, ev, tmp, a.parms_id(), a.scale());
+      b_ = &tmp;
+    }
+    else
+    {
+      ev.mod_switch_to(b, a.parms_id(), tmp, _pool());
+      b_ = &tmp;
+    }
   }
-  else
+  if (match_scale && a.scale() != b_->scale())
   {
-    throw std::logic_error("<Afseal>: Loaded context has invalid scheme");
+    if (_scale_bits(a.scale()) != _scale_bits(b_->scale()))
+    {
+      throw std::invalid_argument("<Afseal>: Cannot add ciphertexts with scales 2^" +
+                                  to_string(std::log2(a.scale())) + " and 2^" +
+                                  to_string(std::log2(b_->scale())));
+    }
+    a.scale() = b_->scale();
   }
-  this->evaluator = make_shared<Evaluator>(*context);
-  this->keyGenObj = make_shared<KeyGenerator>(*context);
-  return loaded_bytes;
+  return *b_;
 }
+}  // namespace
 
-// SAVE/LOAD PUBLICKEY
-size_t Afseal::save_public_key(ostream &out_stream, string &compr_mode)
-{
-  return (size_t)this->get_publicKey()->save(out_stream, compr_mode_map[compr_mode]);
-}
-size_t Afseal::load_public_key(istream &in_stream)
+void Afseal::add_many(vector<shared_ptr<AfCtxt>> &ctxtV, AfCtxt &ctxtOut)
 {
+  AfsealStats::Scope stats("add_many");
+  if (ctxtV.empty())
+  {
+    throw std::invalid_argument("<Afseal>: No ciphertexts to add");
+  }
+  auto context = this->get_context();
+  auto ev = this->get_evaluator();
+  bool ckks = (this->get_scheme() == scheme_t::ckks);
+  // Contiguous chunks are summed into one partial each, so thousands of
+  //  operands only need a few temporaries. The partials form the tree.
+  size_t n = ctxtV.size();
+  size_t n_parts = std::min(n, 2 * AfsealTaskPool::instance().num_threads());
+  vector<Ciphertext> part(n_parts);
+  AfsealTaskPool::instance().parallel_for(n_parts, [&](size_t p)
+  {
+    size_t begin = n * p / n_parts, end = n * (p + 1) / n_parts;
+    part[p] = _dyn_c(*ctxtV[begin]);
+    Ciphertext tmp;
+    for (size_t i = begin + 1; i < end; i++)
+    {
+      ev->add_inplace(part[p], _align(*context, *ev, part[p], _dyn_c(*ctxtV[i]), tmp, ckks));
+    }
+  });
+  _tree_reduce(part, [&](Ciphertext &a, Ciphertext &b)
+  {
+    Ciphertext tmp;
+    ev->add_inplace(a, _align(*context, *ev, a, b, tmp, ckks));
+  });
+  static_cast<Ciphertext &>(_dyn_c(ctxtOut)) = std::move(part[0]);
+}
+
+void Afseal::multiply_many(vector<shared_ptr<AfCtxt>> &ctxtV, AfCtxt &ctxtOut)
+{
+  AfsealStats::Scope stats("multiply_many");
+  if (ctxtV.empty())
+  {
+    throw std::invalid_argument("<Afseal>: No ciphertexts to multiply");
+  }
+  auto context = this->get_context();
+  auto ev = this->get_evaluator();
+  scheme_t scheme = this->get_scheme();
+  shared_ptr<RelinKeys> rlk = (ctxtV.size() > 1) ? this->get_relinKeys() : nullptr;
+  // a *= b, back to size 2 and down one level
+  auto product = [&](Ciphertext &a, const Ciphertext &b)
+  {
+    Ciphertext tmp;
+    const Ciphertext *b_ = &_align(*context, *ev, a, b, tmp);
+    if (a.size() > 2) { ev->relinearize_inplace(a, *rlk, _pool()); }
+    if (b_->size() > 2)   // Deferred relinearization (auto_relin)
+    {
+      if (b_ != &tmp) { tmp = *b_; }
+      ev->relinearize_inplace(tmp, *rlk, _pool());
+      b_ = &tmp;
+    }
+    ev->multiply_inplace(a, *b_, _pool());
+    ev->relinearize_inplace(a, *rlk, _pool());
+    if (scheme == scheme_t::ckks)
+    {
+      ev->rescale_to_next_inplace(a, _pool());
+    }
+    else if (scheme == scheme_t::bgv && context->get_context_data(a.parms_id())->next_context_data())
+    {
+      ev->mod_switch_to_next_inplace(a, _pool());
+    }
+  };
+  // First tree level straight from the inputs, which are left untouched
+  size_t n = ctxtV.size(), keep = (n + 1) / 2;
+  vector<Ciphertext> v(keep);
+  AfsealTaskPool::instance().parallel_for(keep, [&](size_t i)
+  {
+    v[i] = _dyn_c(*ctxtV[i]);
+    if (i + keep < n)
+    {
+      product(v[i], _dyn_c(*ctxtV[i + keep]));
+    }
+  });
+  _tree_reduce(v, product);
+  static_cast<Ciphertext &>(_dyn_c(ctxtOut)) = std::move(v[0]);
+}
+
+// ROTATION KEY PLANNING
+namespace
+{
+// Rotation step as a row rotation in [0, row_size)
+size_t _row_step(int k, size_t row_size)
+{
+  long r = k % static_cast<long>(row_size);
+  return static_cast<size_t>(r < 0 ? r + static_cast<long>(row_size) : r);
+}
+// Row rotation in [0, row_size) as the step of smallest magnitude
+int _signed_step(size_t s, size_t row_size)
+{
+  return (s > row_size / 2) ? static_cast<int>(s) - static_cast<int>(row_size) : static_cast<int>(s);
+}
+// Fewest rotations by key_steps adding up to each row step, up to max_depth
+//  (-1: unreachable). If given, last receives the key step reaching each one.
+vector<int> _rotation_bfs(const vector<int> &key_steps, size_t row_size, size_t max_depth,
+                          vector<int> *last = nullptr)
+{
+  vector<int> dist(row_size, -1);
+  if (last) { last->assign(row_size, 0); }
+  vector<size_t> frontier = {0}, next;
+  dist[0] = 0;
+  for (size_t d = 1; d <= max_depth && !frontier.empty(); d++)
+  {
+    next.clear();
+    for (size_t s : frontier)
+    {
+      for (int k : key_steps)
+      {
+        size_t t = (s + _row_step(k, row_size)) % row_size;
+        if (dist[t] < 0)
+        {
+          dist[t] = static_cast<int>(d);
+          if (last) { (*last)[t] = k; }
+          next.push_back(t);
+        }
+      }
+    }
+    std::swap(frontier, next);
+  }
+  return dist;
+}
+}  // namespace
+
+size_t Afseal::rot_row_size()
+{
+  return this->get_context()->key_context_data()->parms().poly_modulus_degree() / 2;
+}
+bool Afseal::rot_has_key(uint32_t galois_elt)
+{
+  auto store = this->rotateKeyStore;
+  return (store) ? store->contains(galois_elt) : this->get_rotateKeys()->has_key(galois_elt);
+}
+shared_lock<shared_mutex> Afseal::rot_key_lock(uint32_t galois_elt)
+{
+  auto store = this->rotateKeyStore;
+  return (store) ? store->use(galois_elt) : shared_lock<shared_mutex>();
+}
+bool Afseal::rot_record(int step)
+{
+  if (rot_plan.record)
+  {
+    lock_guard<mutex> lk(rot_plan.mtx);
+    rot_plan.steps[step]++;
+  }
+  return rot_plan.dry_run;
+}
+void Afseal::rotate_to(const Ciphertext &in, int k, Ciphertext &out)
+{
+  size_t row_size = this->rot_row_size();
+  size_t s = _row_step(k, row_size);
+  if (s == 0 || rot_record(_signed_step(s, row_size)))  // Identity or dry run
+  {
+    if (&in != &out) { out = in; }
+    return;
+  }
+  auto ev = this->get_evaluator();
+  auto rtk = this->get_rotateKeys();  // Shared, not copied
+  bool ckks = (this->get_scheme() == scheme_t::ckks);
+  auto galois_tool = this->get_context()->key_context_data()->galois_tool();
+  auto rot = [&](const Ciphertext &c_in, int step, Ciphertext &c_out)
+  {
+    shared_lock<shared_mutex> lk = this->rot_key_lock(galois_tool->get_elt_from_step(step));
+    if (ckks) { ev->rotate_vector(c_in, step, *rtk, c_out, _pool()); }
+    else      { ev->rotate_rows(c_in, step, *rtk, c_out, _pool()); }
+  };
+  int step = _signed_step(s, row_size);
+  if (this->rot_has_key(galois_tool->get_elt_from_step(step)))
+  {
+    rot(in, step, out);
+    return;
+  }
+  // No key of its own: shortest chain of available keys, found by a single
+  //  search over all row steps each time the keys change.
+  vector<int> chain;
+  {
+    lock_guard<mutex> lk(rot_plan.mtx);
+    if (rot_plan.chains_keys.lock() != rtk)
+    {
+      // Same map as SEAL: the key of row step t has galois_elt 3^t mod 2n
+      uint64_t m = 2 * row_size * 2, elt = 1;
+      vector<int> key_steps;
+      for (size_t t = 1; t < row_size; t++)
+      {
+        elt = (elt * 3) & (m - 1);
+        if (this->rot_has_key(static_cast<uint32_t>(elt)))
+        {
+          key_steps.push_back(_signed_step(t, row_size));
+        }
+      }
+      rot_plan.dist = _rotation_bfs(key_steps, row_size, row_size, &rot_plan.last);
+      rot_plan.chains_keys = rtk;
+    }
+    for (size_t t = s; rot_plan.dist[t] > 0; t = _row_step(static_cast<int>(t) - rot_plan.last[t], row_size))
+    {
+      chain.push_back(rot_plan.last[t]);
+    }
+  }
+  if (chain.empty())
+  {
+    rot(in, step, out);   // Unreachable: SEAL reports the missing keys
+    return;
+  }
+  rot(in, chain[0], out);
+  for (size_t i = 1; i < chain.size(); i++)
+  {
+    rot(out, chain[i], out);
+  }
+}
+void Afseal::flip_to(const Ciphertext &in, Ciphertext &out)
+{
+  if (rot_record(0))
+  {
+    if (&in != &out) { out = in; }
+    return;
+  }
+  auto rtk = this->get_rotateKeys();
+  auto galois_tool = this->get_context()->key_context_data()->galois_tool();
+  shared_lock<shared_mutex> lk = this->rot_key_lock(galois_tool->get_elt_from_step(0));
+  this->get_evaluator()->rotate_columns(in, *rtk, out, _pool());
+}
+
+void Afseal::set_rotation_record(bool enabled, bool dry_run)
+{
+  lock_guard<mutex> lk(rot_plan.mtx);
+  if (enabled)
+  {
+    rot_plan.steps.clear();
+  }
+  rot_plan.record = enabled;
+  rot_plan.dry_run = enabled && dry_run;
+}
+map<int, uint64_t> Afseal::get_rotation_record()
+{
+  lock_guard<mutex> lk(rot_plan.mtx);
+  return rot_plan.steps;
+}
+int64_t Afseal::count_rotations(vector<int> &key_steps, map<int, uint64_t> &steps)
+{
+  size_t row_size = this->rot_row_size();
+  vector<int> row_keys;
+  bool has_flip = false;
+  for (int k : key_steps)
+  {
+    if (k == 0) { has_flip = true; }
+    else        { row_keys.push_back(k); }
+  }
+  vector<int> dist = _rotation_bfs(row_keys, row_size, row_size);
+  int64_t total = 0;
+  for (auto &st : steps)
+  {
+    int d = (st.first == 0) ? (has_flip ? 1 : -1) : dist[_row_step(st.first, row_size)];
+    if (d < 0)
+    {
+      return -1;
+    }
+    total += d * static_cast<int64_t>(st.second);
+  }
+  return total;
+}
+vector<int> Afseal::plan_rotation_keys(map<int, uint64_t> &steps, size_t max_extra)
+{
+  size_t row_size = this->rot_row_size();
+  map<size_t, uint64_t> targets;   // Row step -> number of rotations
+  map<int, uint64_t> row_steps;    // Same, without the flips
+  bool flip = false;
+  for (auto &st : steps)
+  {
+    if (st.first == 0)  { flip = true; continue; }
+    row_steps.insert(st);
+    if (size_t s = _row_step(st.first, row_size)) { targets[s] += st.second; }
+  }
+  auto covers = [&](const vector<int> &keys)
+  {
+    vector<int> dist = _rotation_bfs(keys, row_size, 1 + max_extra);
+    for (auto &t : targets)
+    {
+      if (dist[t.first] < 0) { return false; }
+    }
+    return true;
+  };
+  // Drops the keys in `order` one by one, as long as all steps stay covered
+  auto prune = [&](vector<int> keys, const vector<int> &order)
+  {
+    for (int k : order)
+    {
+      vector<int> fewer;
+      std::copy_if(keys.begin(), keys.end(), std::back_inserter(fewer), [k](int x) { return x != k; });
+      if (covers(fewer)) { keys = std::move(fewer); }
+    }
+    return keys;
+  };
+  // Candidates: one key per step (least used and longest dropped first),
+  //  alone or with the default keys of steps +-2^i (largest dropped first).
+  vector<int> own;
+  for (auto &t : targets) { own.push_back(_signed_step(t.first, row_size)); }
+  std::stable_sort(own.begin(), own.end(), [&](int a, int b)
+  {
+    uint64_t na = targets[_row_step(a, row_size)], nb = targets[_row_step(b, row_size)];
+    return (na != nb) ? na < nb : std::abs(a) > std::abs(b);
+  });
+  vector<int> pow2;
+  for (size_t p = row_size / 2; p >= 1; p /= 2)
+  {
+    for (size_t s : {p, row_size - p})
+    {
+      int k = _signed_step(s, row_size);
+      if (!targets.count(s) && std::find(pow2.begin(), pow2.end(), k) == pow2.end())
+      {
+        pow2.push_back(k);
+      }
+    }
+  }
+  vector<int> plan = prune(own, own);
+  vector<int> mixed = own;
+  mixed.insert(mixed.end(), pow2.begin(), pow2.end());
+  mixed = prune(mixed, mixed);
+  if (mixed.size() < plan.size() ||
+      (mixed.size() == plan.size() && count_rotations(mixed, row_steps) < count_rotations(plan, row_steps)))
+  {
+    plan = std::move(mixed);
+  }
+  std::sort(plan.begin(), plan.end());
+  if (flip)
+  {
+    plan.insert(plan.begin(), 0);
+  }
+  return plan;
+}
+
+// LINEAR ALGEBRA
+// Matrix-vector products with the diagonal method [Halevi-Shoup] and
+//  baby-step giant-step: with dim = n1*n2 diagonals, y = sum_j rot_{j*n1}(
+//  sum_i rot_{-j*n1}(diag_{j*n1+i}) * rot_i(x)), i.e. n1+n2 rotations.
+static size_t _matrix_dim(size_t n_rows, size_t n_cols, size_t row_size)
+{
+  size_t dim = 1;
+  while (dim < std::max(n_rows, n_cols))
+  {
+    dim *= 2;
+  }
+  if (dim > row_size)
+  {
+    throw std::range_error("<Afseal>: Matrix doesn't fit in a ciphertext row (" +
+                           std::to_string(dim) + " > " + std::to_string(row_size) + ")");
+  }
+  return dim;
+}
+static size_t _bsgs_baby_steps(size_t dim)
+{
+  size_t n1 = 1;
+  while (n1 * n1 < dim)
+  {
+    n1 *= 2;
+  }
+  return n1;
+}
+// Fills every plaintext in diagVOut with one pre-rotated generalized diagonal.
+//  Only the slots that land in [0, dim) of each row after the giant-step
+//  rotation are set, so the product is zero outside [0, dim) and can be chained.
+template <typename T, typename EncodeF>
+static void _encode_diagonals(const T *matrix, size_t n_rows, size_t n_cols,
+                              size_t dim, size_t row_size, size_t n_slots,
+                              vector<shared_ptr<AfPtxt>> &diagVOut, EncodeF encode)
+{
+  size_t n1 = _bsgs_baby_steps(dim);
+  diagVOut.resize(dim);
+  for (auto &p : diagVOut)
+  {
+    if (!p) { p = make_shared<AfsealPtxt>(); }
+  }
+  AfsealTaskPool::instance().parallel_for(dim, [&](size_t k)
+  {
+    size_t shift = (k / n1) * n1;
+    vector<T> diag(n_slots, T(0));
+    for (size_t t = 0; t < n_slots; t++)
+    {
+      size_t r = (t % row_size + row_size - shift) % row_size;   // Matrix row
+      size_t c = (r + k) % dim;                                  // Matrix column
+      if (r < n_rows && c < n_cols)
+      {
+        diag[t] = matrix[r * n_cols + c];
+      }
+    }
+    encode(diag.data(), n_slots, *diagVOut[k]);
+  });
+}
+void Afseal::encode_matrix_i(const int64_t *matrix, size_t n_rows, size_t n_cols, vector<shared_ptr<AfPtxt>> &diagVOut)
+{
+  scheme_t scheme = this->get_scheme();
+  if (scheme != scheme_t::bfv && scheme != scheme_t::bgv)
+  {
+    throw std::logic_error("<Afseal>: Integer matrices require bfv or bgv scheme");
+  }
+  size_t n_slots = this->get_nSlots();
+  size_t dim = _matrix_dim(n_rows, n_cols, n_slots / 2);
+  _encode_diagonals(matrix, n_rows, n_cols, dim, n_slots / 2, n_slots, diagVOut,
+      [this, scheme](const int64_t *v, size_t n, AfPtxt &p)
+      { (scheme == scheme_t::bfv) ? encode_i(v, n, p) : encode_g(v, n, p); });
+}
+void Afseal::encode_matrix_f(const double *matrix, size_t n_rows, size_t n_cols, double scale, vector<shared_ptr<AfPtxt>> &diagVOut)
+{
+  if (this->get_scheme() != scheme_t::ckks)
+  {
+    throw std::logic_error("<Afseal>: Fractional matrices require ckks scheme");
+  }
+  size_t n_slots = this->get_nSlots();
+  size_t dim = _matrix_dim(n_rows, n_cols, n_slots);
+  _encode_diagonals(matrix, n_rows, n_cols, dim, n_slots, n_slots, diagVOut,
+      [this, scale](const double *v, size_t n, AfPtxt &p) { encode_f(v, n, scale, p); });
+}
+void Afseal::matvec_plain(AfCtxt &ctxt, vector<shared_ptr<AfPtxt>> &diagV)
+{
+  AfsealStats::Scope stats("matvec_plain");
+  scheme_t scheme = this->get_scheme();
+  if (scheme != scheme_t::bfv && scheme != scheme_t::bgv && scheme != scheme_t::ckks)
+  {
+    throw std::logic_error("<Afseal>: Scheme not supported for rotation");
+  }
+  size_t dim = diagV.size();
+  size_t row_size = (scheme == scheme_t::ckks) ? this->get_nSlots() : this->get_nSlots() / 2;
+  if (dim == 0 || (dim & (dim - 1)) != 0 || dim > row_size)
+  {
+    throw std::invalid_argument("<Afseal>: Number of matrix diagonals must be a power of 2 <= " +
+                                std::to_string(row_size));
+  }
+  for (auto &p : diagV)
+  {
+    if (!p) { throw std::invalid_argument("<Afseal>: Empty matrix diagonal"); }
+  }
+  auto ev = this->get_evaluator();
+  Ciphertext &c = _dyn_c(ctxt);
+  relin_operand(c);
+
+  // Repeat x with period dim over the row, so rotations wrap modulo dim
+  Ciphertext aux;
+  for (size_t s = dim; s < row_size; s *= 2)
+  {
+    rotate_to(c, -static_cast<int>(s), aux);
+    ev->add_inplace(c, aux);
+  }
+
+  // Baby steps: rot_i(x) for i in [0, n1)
+  size_t n1 = _bsgs_baby_steps(dim), n2 = dim / n1;
+  vector<Ciphertext> baby(n1);
+  baby[0] = c;
+  AfsealTaskPool::instance().parallel_for(n1 - 1, [&](size_t i)
+    { rotate_to(c, static_cast<int>(i + 1), baby[i + 1]); });
+
+  // Giant steps: inner products with the diagonals, then one rotation each.
+  //  All-zero diagonals are skipped (SEAL rejects transparent products).
+  vector<Ciphertext> giant(n2);
+  vector<char> used(n2, 0);
+  AfsealTaskPool::instance().parallel_for(n2, [&](size_t j)
+  {
+    Ciphertext prod;
+    Plaintext p_lvl;
+    for (size_t i = 0; i < n1; i++)
+    {
+      const Plaintext *p = &_dyn_p(*diagV[j * n1 + i]);
+      if (p->is_zero())
+      {
+        continue;
+      }
+      if (p->is_ntt_form() && p->parms_id() != baby[i].parms_id())
+      {
+        ev->mod_switch_to(*p, baby[i].parms_id(), p_lvl);
+        p = &p_lvl;
+      }
+      prod = baby[i];
+      _multiply_plain(*ev, prod, *p);
+      if (used[j]) { ev->add_inplace(giant[j], prod); }
+      else         { giant[j] = std::move(prod); used[j] = 1; }
+    }
+    if (used[j] && j > 0)
+    {
+      rotate_to(giant[j], static_cast<int>(j * n1), prod);
+      giant[j] = std::move(prod);
+    }
+  });
+
+  bool first = true;
+  for (size_t j = 0; j < n2; j++)
+  {
+    if (!used[j]) { continue; }
+    if (first) { c = std::move(giant[j]); first = false; }
+    else       { ev->add_inplace(c, giant[j]); }
+  }
+  if (first)   // All-zero matrix: fresh encryption of zero at the same level
+  {
+    Ciphertext zero;
+    this->get_encryptor()->encrypt_zero(c.parms_id(), zero, _pool());
+    zero.scale() = c.scale() * _dyn_p(*diagV[0]).scale();
+    zero.correction_factor() = c.correction_factor();
+    c = std::move(zero);
+  }
+}
+
+// POLYNOMIALS
+void Afseal::exponentiate(AfCtxt &ctxt, uint64_t &expon)
+{
+  AfsealStats::Scope stats("exponentiate");
+  relin_operand(_dyn_c(ctxt));
+  this->get_evaluator()->exponentiate_inplace(_dyn_c(ctxt), expon, *(this->get_relinKeys()), _pool());
+}
+void Afseal::exponentiate_v(vector<std::shared_ptr<AfCtxt>> &ctxtV, uint64_t &expon)
+{
+  AfsealStats::Scope stats("exponentiate_v");
+  auto ev = this->get_evaluator();
+  auto rlk = this->get_relinKeys();  // Shared, not copied
+  vectorize(ctxtV,
+            [this, ev, expon, rlk](AfCtxt &c)
+            { relin_operand(_dyn_c(c)); ev->exponentiate_inplace(_dyn_c(c), expon, *rlk, _pool()); });
+}
+
+// Polynomial evaluation (ckks). Baby steps: powers x^1..x^k (or T_1..T_k),
+//  giant steps: x^(k*2^t). The polynomial is split recursively as
+//  p = low + x^s * high with s = k*2^t (in Chebyshev: T_{s+j} = 2T_sT_j - T_{s-j}),
+//  so the leaves of degree < k only need scalar products. This takes
+//  O(sqrt(d)) + O(d/k) non-scalar products for degree d and depth ~log2(d)+1.
+//  Like PyCtxt.round_scale, the scale is rounded back to the input scale
+//  after each rescale, assuming qi sizes close to the scale.
+namespace
+{
+struct _Poly
+{
+  bool has_ct = false;   // Otherwise the polynomial is just `constant`
+  Ciphertext ct;
+  double constant = 0;
+};
+
+class _CkksPolyEval
+{
+ public:
+  _CkksPolyEval(shared_ptr<SEALContext> context, shared_ptr<Evaluator> ev,
+                shared_ptr<CKKSEncoder> encoder, shared_ptr<RelinKeys> rlk,
+                double scale, bool chebyshev)
+      : context(context), ev(ev), encoder(encoder), rlk(rlk), scale(scale),
+        chebyshev(chebyshev) {}
+
+  void run(Ciphertext &x, vector<double> coeffs)
+  {
+    size_t len = coeffs.size();
+    k = 1;
+    while (k * k < len)
+    {
+      k *= 2;
+    }
+    // Baby steps
+    pw.resize(k + 1);
+    pw[1] = x;
+    for (size_t i = 2; i <= k; i++)
+    {
+      size_t m = 1;
+      while (2 * m < i) { m *= 2; }   // Largest power of 2 below i
+      multiply(pw[m], pw[i - m], pw[i]);
+      if (chebyshev)
+      {
+        ev->add_inplace(pw[i], pw[i]);
+        if (2 * m == i) { add_const(pw[i], -1.0); }
+        else            { sub(pw[i], pw[2 * m - i]); }
+      }
+    }
+    // Giant steps
+    giant.clear();
+    giant.push_back(pw[k]);
+    for (size_t s = k; 2 * s < len; s *= 2)
+    {
+      Ciphertext g;
+      multiply(giant.back(), giant.back(), g);
+      if (chebyshev)
+      {
+        ev->add_inplace(g, g);
+        add_const(g, -1.0);
+      }
+      giant.push_back(std::move(g));
+    }
+    _Poly p = eval(coeffs);
+    if (!p.has_ct)
+    {
+      throw std::invalid_argument("<Afseal>: Polynomial must have degree >= 1");
+    }
+    x = std::move(p.ct);
+  }
+
+  // Scalar product with the coefficient encoded at the scale of the prime
+  //  dropped by the rescale, keeping the ciphertext scale unchanged.
+  //  Returns false if the coefficient encodes to zero.
+  bool multiply_const(const Ciphertext &in, double c, Ciphertext &out)
+  {
+    Plaintext p;
+    encoder->encode(c, in.parms_id(), last_prime(in), p, _pool());
+    if (p.is_zero())
+    {
+      return false;
+    }
+    ev->multiply_plain(in, p, out, _pool());
+    ev->rescale_to_next_inplace(out, _pool());
+    out.scale() = in.scale();
+    return true;
+  }
+
+ private:
+  shared_ptr<SEALContext> context;
+  shared_ptr<Evaluator> ev;
+  shared_ptr<CKKSEncoder> encoder;
+  shared_ptr<RelinKeys> rlk;
+  double scale;
+  bool chebyshev;
+  size_t k = 1;
+  vector<Ciphertext> pw;      // Baby steps, pw[i] = x^i or T_i
+  vector<Ciphertext> giant;   // giant[t] = x^(k*2^t) or T_(k*2^t)
+
+  double last_prime(const Ciphertext &c)
+  {
+    return static_cast<double>(
+        context->get_context_data(c.parms_id())->parms().coeff_modulus().back().value());
+  }
+  size_t level(const Ciphertext &c)
+  {
+    return context->get_context_data(c.parms_id())->chain_index();
+  }
+  // Brings a and b to the lowest of their levels
+  void align(Ciphertext &a, Ciphertext &b)
+  {
+    if (level(a) > level(b))      { ev->mod_switch_to_inplace(a, b.parms_id(), _pool()); }
+    else if (level(b) > level(a)) { ev->mod_switch_to_inplace(b, a.parms_id(), _pool()); }
+  }
+  void fix_scale(Ciphertext &c)
+  {
+    if (std::abs(std::log2(c.scale() / scale)) > 1)
+    {
+      throw std::range_error("<Afseal>: qi sizes must match the scale to evaluate polynomials");
+    }
+    c.scale() = scale;
+  }
+  void multiply(const Ciphertext &a, const Ciphertext &b, Ciphertext &out)
+  {
+    Ciphertext a_ = a, b_ = b;
+    align(a_, b_);
+    ev->multiply(a_, b_, out, _pool());
+    ev->relinearize_inplace(out, *rlk, _pool());
+    ev->rescale_to_next_inplace(out, _pool());
+    fix_scale(out);
+  }
+  void sub(Ciphertext &c, const Ciphertext &other)
+  {
+    Ciphertext o = other;
+    align(c, o);
+    o.scale() = c.scale();
+    ev->sub_inplace(c, o);
+  }
+  void add(Ciphertext &c, Ciphertext &other)
+  {
+    align(c, other);
+    other.scale() = c.scale();
+    ev->add_inplace(c, other);
+  }
+  void add_const(Ciphertext &c, double v)
+  {
+    if (v == 0)
+    {
+      return;
+    }
+    Plaintext p;
+    encoder->encode(v, c.parms_id(), c.scale(), p, _pool());
+    ev->add_plain_inplace(c, p, _pool());
+  }
+
+  _Poly eval(const vector<double> &c)
+  {
+    _Poly res;
+    size_t len = c.size();
+    if (len <= k)   // Leaf: scalar products with the baby steps
+    {
+      size_t lvl = level(pw[1]);
+      for (size_t i = 1; i < len; i++)
+      {
+        if (c[i] != 0) { lvl = std::min(lvl, level(pw[i])); }
+      }
+      for (size_t i = 1; i < len; i++)
+      {
+        if (c[i] == 0) { continue; }
+        Ciphertext x_i = pw[i], term;
+        if (level(x_i) > lvl)
+        {
+          for (size_t l = level(x_i); l > lvl; l--) { ev->mod_switch_to_next_inplace(x_i, _pool()); }
+        }
+        if (!multiply_const(x_i, c[i], term)) { continue; }
+        if (res.has_ct) { add(res.ct, term); }
+        else            { res.ct = std::move(term); res.has_ct = true; }
+      }
+      if (res.has_ct) { add_const(res.ct, c[0]); }
+      else            { res.constant = c[0]; }
+      return res;
+    }
+    // Split at s = k*2^t, the largest with s < len (so len <= 2s)
+    size_t t = 0;
+    while (k << (t + 1) < len) { t++; }
+    size_t s = k << t;
+    vector<double> low(c.begin(), c.begin() + s), high(c.begin() + s, c.end());
+    if (chebyshev)
+    {
+      for (size_t j = 1; j < high.size(); j++)
+      {
+        high[j] = 2 * c[s + j];
+        low[s - j] -= c[s + j];
+      }
+    }
+    _Poly lo = eval(low), hi = eval(high);
+    if (hi.has_ct)
+    {
+      multiply(hi.ct, giant[t], res.ct);
+      res.has_ct = true;
+    }
+    else if (hi.constant != 0)
+    {
+      res.has_ct = multiply_const(giant[t], hi.constant, res.ct);
+    }
+    if (!res.has_ct)
+    {
+      return lo;
+    }
+    if (lo.has_ct) { add(res.ct, lo.ct); }
+    else           { add_const(res.ct, lo.constant); }
+    return res;
+  }
+};
+}  // namespace
+
+void Afseal::eval_poly(AfCtxt &ctxt, vector<double> &coeffs, bool chebyshev, double x_min, double x_max)
+{
+  AfsealStats::Scope stats("eval_poly");
+  if (this->get_scheme() != scheme_t::ckks)
+  {
+    throw std::logic_error("<Afseal>: Scheme must be ckks");
+  }
+  vector<double> c(coeffs);
+  while (!c.empty() && c.back() == 0)
+  {
+    c.pop_back();
+  }
+  if (c.size() < 2)
+  {
+    throw std::invalid_argument("<Afseal>: Polynomial must have degree >= 1");
+  }
+  if (chebyshev && !(x_min < x_max))
+  {
+    throw std::invalid_argument("<Afseal>: Chebyshev interval must satisfy x_min < x_max");
+  }
+  Ciphertext &x = _dyn_c(ctxt);
+  relin_operand(x);
+  _CkksPolyEval pe(this->get_context(), this->get_evaluator(), this->get_ckks_encoder(),
+                   this->get_relinKeys(), x.scale(), chebyshev);
+  // Chebyshev: map [x_min, x_max] to [-1, 1]
+  if (chebyshev && (x_min != -1 || x_max != 1))
+  {
+    Ciphertext y;
+    double a = 2 / (x_max - x_min), b = -(x_max + x_min) / (x_max - x_min);
+    pe.multiply_const(x, a, y);
+    if (b != 0)
+    {
+      Plaintext p;
+      this->get_ckks_encoder()->encode(b, y.parms_id(), y.scale(), p, _pool());
+      this->get_evaluator()->add_plain_inplace(y, p, _pool());
+    }
+    x = std::move(y);
+  }
+  pe.run(x, std::move(c));
+}
+
+// EXPRESSION GRAPH
+namespace
+{
+// Value of a graph node: leaves are read in place, intermediates are owned
+//  and released once their last consumer has run.
+struct _GraphVal
+{
+  const Ciphertext *ref = nullptr;
+  Ciphertext own;
+  bool pending_rescale = false;   // ckks product whose rescale was deferred
+  const Ciphertext &get() const { return ref ? *ref : own; }
+};
+}  // namespace
+
+void Afseal::eval_graph(vector<AfGraphNode> &nodes)
+{
+  AfsealStats::Scope stats("eval_graph");
+  scheme_t scheme = this->get_scheme();
+  bool ckks = (scheme == scheme_t::ckks);
+  size_t n = nodes.size();
+  auto is_leaf = [&](int64_t j)
+    { return nodes[j].op == graph_op_t::ctxt || nodes[j].op == graph_op_t::ptxt; };
+
+  // Validate, and find the consumers and the wave (depth) of every node
+  vector<size_t> uses(n, 0), wave(n, 0);
+  vector<char> normalize(n, 0);
+  size_t n_waves = 0;
+  bool need_rlk = false, need_rtk = false;
+  for (size_t i = 0; i < n; i++)
+  {
+    AfGraphNode &nd = nodes[i];
+    if (nd.op == graph_op_t::ctxt || nd.op == graph_op_t::ptxt)
+    {
+      if ((nd.op == graph_op_t::ctxt && !nd.ctxt) ||
+          (nd.op == graph_op_t::ptxt && !nd.ptxt && nd.fvalues.empty() && nd.ivalues.empty()))
+      {
+        throw std::invalid_argument("<Afseal>: Empty operand in expression graph");
+      }
+      // Leaves left unrelinearized by auto_relin
+      need_rlk |= (nd.op == graph_op_t::ctxt && _dyn_c(*nd.ctxt).size() > 2);
+      continue;
+    }
+    bool binary = (nd.op == graph_op_t::add || nd.op == graph_op_t::sub ||
+                   nd.op == graph_op_t::multiply);
+    if (nd.lhs < 0 || static_cast<size_t>(nd.lhs) >= i || nodes[nd.lhs].op == graph_op_t::ptxt ||
+        (binary && (nd.rhs < 0 || static_cast<size_t>(nd.rhs) >= i)))
+    {
+      throw std::invalid_argument("<Afseal>: Expression graph nodes must follow their operands");
+    }
+    uses[nd.lhs]++;
+    wave[i] = wave[nd.lhs] + 1;
+    if (binary)
+    {
+      uses[nd.rhs]++;
+      wave[i] = std::max(wave[i], wave[nd.rhs] + 1);
+    }
+    n_waves = std::max(n_waves, wave[i]);
+    // Products and rotations need relinearized (and rescaled) operands
+    if (nd.op == graph_op_t::multiply || nd.op == graph_op_t::rotate || nd.op == graph_op_t::flip)
+    {
+      normalize[nd.lhs] = 1;
+      if (binary && nodes[nd.rhs].op != graph_op_t::ptxt) { normalize[nd.rhs] = 1; }
+    }
+    need_rlk |= (nd.op == graph_op_t::multiply);
+    need_rtk |= (nd.op == graph_op_t::rotate || nd.op == graph_op_t::flip);
+  }
+  for (size_t i = 0; i < n; i++)
+  {
+    if (nodes[i].output) { normalize[i] = 1; }
+  }
+
+  auto ev = this->get_evaluator();
+  auto context = this->get_context();
+  auto rlk = need_rlk ? this->get_relinKeys() : nullptr;
+  if (need_rtk && !rot_plan.dry_run)
+  {
+    this->get_rotateKeys();   // Fail before evaluating anything
+  }
+  auto level = [&](const Ciphertext &c)
+    { return context->get_context_data(c.parms_id())->chain_index(); };
+  auto relin = [&](Ciphertext &c)
+  {
+    if (c.size() > 2) { ev->relinearize_inplace(c, *rlk, _pool()); }
+  };
+  auto prepare = [&](Ciphertext &c, bool &pending)
+  {
+    relin(c);
+    if (pending) { ev->rescale_to_next_inplace(c, _pool()); pending = false; }
+  };
+
+  vector<_GraphVal> vals(n);
+  for (size_t i = 0; i < n; i++)
+  {
+    if (nodes[i].op == graph_op_t::ctxt) { vals[i].ref = &_dyn_c(*nodes[i].ctxt); }
+  }
+
+  // Plaintext operand `j`, encoded/switched for `c` (ckks: at the scale of c
+  //  to add it, or at the scale of the next prime to multiply).
+  auto plain_for = [&](int64_t j, const Ciphertext &c, bool mult, Plaintext &tmp) -> const Plaintext &
+  {
+    AfGraphNode &nd = nodes[j];
+    if (nd.ptxt)
+    {
+      const Plaintext &p = _dyn_p(*nd.ptxt);
+      if (ckks && !mult && p.scale() != c.scale())
+      {
+        // Sums need equal scales: re-encoded at the scale of c, since
+        //  overwriting the scale of c would change its value
+        vector<std::complex<double>> values;
+        this->get_ckks_encoder()->decode(p, values, _pool());
+        this->get_ckks_encoder()->encode(values, c.parms_id(), c.scale(), tmp, _pool());
+        return tmp;
+      }
+      if (ckks && p.parms_id() != c.parms_id())
+      {
+        ev->mod_switch_to(p, c.parms_id(), tmp);
+        return tmp;
+      }
+      return p;
+    }
+    AfsealPtxt p;
+    if (ckks)
+    {
+      double scale = mult ? static_cast<double>(context->get_context_data(c.parms_id())
+                                ->parms().coeff_modulus().back().value())
+                          : c.scale();
+      this->get_ckks_encoder()->encode(nd.fvalues, c.parms_id(), scale, tmp, _pool());
+      return tmp;
+    }
+    if (scheme == scheme_t::bgv) { encode_g(nd.ivalues.data(), nd.ivalues.size(), p); }
+    else                         { encode_i(nd.ivalues.data(), nd.ivalues.size(), p); }
+    tmp = std::move(p);
+    return tmp;
+  };
+
+  auto eval_node = [&](size_t i)
+  {
+    AfGraphNode &nd = nodes[i];
+    // Accumulator: steal single-use intermediates, copy anything else
+    Ciphertext acc;
+    bool pending = vals[nd.lhs].pending_rescale;
+    if (!is_leaf(nd.lhs) && uses[nd.lhs] == 1 && !nodes[nd.lhs].output)
+    {
+      acc = std::move(vals[nd.lhs].own);
+    }
+    else
+    {
+      acc = vals[nd.lhs].get();
+    }
+    switch (nd.op)
+    {
+    case graph_op_t::negate:
+      ev->negate_inplace(acc);
+      break;
+    case graph_op_t::rotate:
+      prepare(acc, pending);
+      if (scheme != scheme_t::none) { rotate_to(acc, nd.k, acc); }
+      break;
+    case graph_op_t::flip:
+      if (ckks) { throw std::logic_error("<Afseal>: Only bfv/bgv schemes support column rotation"); }
+      prepare(acc, pending);
+      flip_to(acc, acc);
+      break;
+    default:   // Binary ops
+      if (nodes[nd.rhs].op == graph_op_t::ptxt)
+      {
+        Plaintext tmp;
+        if (nd.op == graph_op_t::multiply)
+        {
+          prepare(acc, pending);
+          _multiply_plain(*ev, acc, plain_for(nd.rhs, acc, true, tmp));
+          pending = ckks;
+          break;
+        }
+        // A plaintext encoded at the rescaled scale: rescale first
+        AfPtxt *raw = nodes[nd.rhs].ptxt.get();
+        if (ckks && pending && raw && std::log2(acc.scale() / _dyn_p(*raw).scale()) >= 1)
+        {
+          prepare(acc, pending);
+        }
+        const Plaintext &p = plain_for(nd.rhs, acc, false, tmp);
+        (nd.op == graph_op_t::add) ? ev->add_plain_inplace(acc, p, _pool()) : ev->sub_plain_inplace(acc, p, _pool());
+        break;
+      }
+      Ciphertext b_tmp;
+      const Ciphertext *b = &vals[nd.rhs].get();
+      bool b_pending = vals[nd.rhs].pending_rescale;
+      auto own_b = [&]() -> Ciphertext &
+      {
+        if (b != &b_tmp) { b_tmp = *b; b = &b_tmp; }
+        return b_tmp;
+      };
+      if (nd.op == graph_op_t::multiply)
+      {
+        prepare(acc, pending);
+        if (b->size() > 2 || b_pending) { prepare(own_b(), b_pending); }
+      }
+      else if (ckks)   // Rescale deferred products until both scales match
+      {
+        double r;
+        while (std::abs(r = std::log2(acc.scale() / b->scale())) >= 1)
+        {
+          if (r > 0 && pending)        { ev->rescale_to_next_inplace(acc, _pool()); pending = false; }
+          else if (r < 0 && b_pending) { ev->rescale_to_next_inplace(own_b(), _pool()); b_pending = false; }
+          else { throw std::invalid_argument("<Afseal>: Cannot align the scales of the operands"); }
+        }
+      }
+      if (level(acc) > level(*b))      { ev->mod_switch_to_inplace(acc, b->parms_id(), _pool()); }
+      else if (level(acc) < level(*b)) { ev->mod_switch_to_inplace(own_b(), acc.parms_id(), _pool()); }
+      if (ckks) { acc.scale() = b->scale(); }
+      switch (nd.op)
+      {
+      case graph_op_t::add: ev->add_inplace(acc, *b); break;
+      case graph_op_t::sub: ev->sub_inplace(acc, *b); break;
+      default:
+        (nd.lhs == nd.rhs) ? ev->square_inplace(acc, _pool()) : ev->multiply_inplace(acc, *b, _pool());
+        pending = ckks;
+        break;
+      }
+    }
+    if (normalize[i]) { prepare(acc, pending); }
+    vals[i].own = std::move(acc);
+    vals[i].pending_rescale = pending;
+  };
+
+  // Run wave by wave: all nodes in a wave only depend on earlier waves
+  vector<vector<size_t>> waves(n_waves + 1);
+  for (size_t i = 0; i < n; i++)
+  {
+    if (!is_leaf(i)) { waves[wave[i]].push_back(i); }
+  }
+  vector<size_t> remaining(uses);
+  for (size_t w = 1; w <= n_waves; w++)
+  {
+    vector<size_t> &wv = waves[w];
+    AfsealTaskPool::instance().parallel_for(wv.size(), [&](size_t t) { eval_node(wv[t]); });
+    for (size_t i : wv)
+    {
+      bool binary = (nodes[i].op == graph_op_t::add || nodes[i].op == graph_op_t::sub ||
+                     nodes[i].op == graph_op_t::multiply);
+      for (int64_t j : {nodes[i].lhs, binary ? nodes[i].rhs : int64_t(-1)})
+      {
+        if (j >= 0 && --remaining[j] == 0 && !nodes[j].output && !is_leaf(j))
+        {
+          vals[j].own = Ciphertext();
+        }
+      }
+    }
+  }
+
+  // Write the outputs
+  size_t top = context->first_context_data()->chain_index();
+  for (size_t i = 0; i < n; i++)
+  {
+    AfGraphNode &nd = nodes[i];
+    if (!nd.output) { continue; }
+    if (nd.op == graph_op_t::ptxt || !nd.ctxt)
+    {
+      throw std::invalid_argument("<Afseal>: Graph outputs must be ciphertexts");
+    }
+    Ciphertext &dst = _dyn_c(*nd.ctxt);
+    if (is_leaf(i)) { if (&dst != vals[i].ref) { dst = *vals[i].ref; } }
+    else            { dst = std::move(vals[i].own); }
+    nd.mod_level = static_cast<int>(top - level(dst));
+  }
+}
+
+// CKKS -> Rescaling and mod switching
+void Afseal::rescale_to_next(AfCtxt &ctxt)
+{
+  AfsealStats::Scope stats("rescale_to_next");
+  stats.ctxt(ctxt);
+  if (this->get_scheme() == scheme_t::ckks)
+  {
+    this->get_evaluator()->rescale_to_next_inplace(_dyn_c(ctxt), _pool());
+  }
+  else
+  {
+    throw std::logic_error("<Afseal>: Scheme must be ckks");
+  }
+}
+void Afseal::rescale_to_next_v(vector<std::shared_ptr<AfCtxt>> &ctxtV)
+{
+  AfsealStats::Scope stats("rescale_to_next_v");
+  auto ev = this->get_evaluator();
+  if (this->get_scheme() == scheme_t::ckks)
+  {
+    vectorize(ctxtV,
+              [ev](AfCtxt &c)
+              { ev->rescale_to_next_inplace(_dyn_c(c), _pool()); });
+  }
+  else
+  {
+    throw std::logic_error("<Afseal>: Scheme must be ckks");
+  }
+}
+
+void Afseal::mod_switch_to_next(AfCtxt &ctxt)
+{
+  AfsealStats::Scope stats("mod_switch_to_next");
+  stats.ctxt(ctxt);
+  this->get_evaluator()->mod_switch_to_next_inplace(_dyn_c(ctxt), _pool());
+}
+void Afseal::mod_switch_to_next_v(vector<std::shared_ptr<AfCtxt>> &ctxtV)
+{
+  AfsealStats::Scope stats("mod_switch_to_next_v");
+  auto ev = this->get_evaluator();
+  vectorize(ctxtV,
+            [ev](AfCtxt &c)
+            { ev->mod_switch_to_next_inplace(_dyn_c(c), _pool()); });
+}
+
+void Afseal::mod_switch_to_next_plain(AfPtxt &ptxt)
+{
+  AfsealStats::Scope stats("mod_switch_to_next_plain");
+  this->get_evaluator()->mod_switch_to_next_inplace(_dyn_p(ptxt));
+}
+void Afseal::mod_switch_to_next_plain_v(vector<std::shared_ptr<AfPtxt>> &plainV)
+{
+  AfsealStats::Scope stats("mod_switch_to_next_plain_v");
+  auto ev = this->get_evaluator();
+  vectorize(plainV,
+            [ev](AfPtxt &p)
+            { ev->mod_switch_to_next_inplace(_dyn_p(p)); });
+}
+
+// NTT PLAINTEXTS
+void Afseal::plain_to_ntt(AfPtxt &ptxt, size_t mod_level)
+{
+  AfsealStats::Scope stats("plain_to_ntt");
+  auto context = this->get_context();
+  auto ctx_data = context->first_context_data();
+  for (size_t i = 0; i < mod_level && ctx_data; i++)
+  {
+    ctx_data = ctx_data->next_context_data();
+  }
+  if (!ctx_data)
+  {
+    throw std::out_of_range("<Afseal>: mod_level exceeds the modulus chain");
+  }
+  Plaintext &p = _dyn_p(ptxt);
+  auto ev = this->get_evaluator();
+  if (this->get_scheme() == scheme_t::ckks)
+  {
+    if (p.parms_id() != ctx_data->parms_id())
+    {
+      ev->mod_switch_to_inplace(p, ctx_data->parms_id());
+    }
+  }
+  else if (this->get_scheme() == scheme_t::bfv || this->get_scheme() == scheme_t::bgv)
+  {
+    if (p.is_ntt_form())
+    {
+      throw std::logic_error("<Afseal>: Plaintext is already in NTT form");
+    }
+    ev->transform_to_ntt_inplace(p, ctx_data->parms_id(), _pool());
+  }
+  else
+  {
+    throw std::logic_error("<Afseal>: Scheme not supported for NTT plaintexts");
+  }
+}
+size_t Afseal::get_mod_level(AfCtxt &ctxt)
+{
+  auto context = this->get_context();
+  auto ctx_data = context->get_context_data(_dyn_c(ctxt).parms_id());
+  if (!ctx_data)
+  {
+    throw std::invalid_argument("<Afseal>: Ciphertext is not valid for the current context");
+  }
+  return context->first_context_data()->chain_index() - ctx_data->chain_index();
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------------- I/O -----------------------------------
+// -----------------------------------------------------------------------------
+// SAVE/LOAD CONTEXT
+size_t Afseal::save_context(ostream &out_stream, string &compr_mode)
+{
+  AfsealStats::Scope stats("save_context");
+  return stats.bytes((size_t)this->get_context()->key_context_data()->parms().save(
+      out_stream, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_context(istream &in_stream, int sec)
+{
+  AfsealStats::Scope stats("load_context");
+  EncryptionParameters parms;
+  size_t loaded_bytes = (size_t)parms.load(in_stream);
+  if (parms.scheme() != scheme_type::bfv && parms.scheme() != scheme_type::bgv &&
+      parms.scheme() != scheme_type::ckks)
+  {
+    throw std::logic_error("<Afseal>: Loaded context has invalid scheme");
+  }
+  this->set_context(parms, sec);
+  if (!this->get_context()->parameters_set())
+  {
+    throw std::invalid_argument(string("<Afseal>: Loaded context is invalid: ") +
+                                this->get_context()->parameter_error_message());
+  }
+  return stats.bytes(loaded_bytes);
+}
+
+// SAVE/LOAD PUBLICKEY
+size_t Afseal::save_public_key(ostream &out_stream, string &compr_mode, bool seeded)
+{
+  AfsealStats::Scope stats("save_public_key");
+  if (seeded)
+  {
+    return stats.bytes((size_t)this->get_keyGenObj()->create_public_key().save(out_stream, compr_mode_map[compr_mode]));
+  }
+  return stats.bytes((size_t)this->get_publicKey()->save(out_stream, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_public_key(istream &in_stream)
+{
+  AfsealStats::Scope stats("load_public_key");
   seal::SEALContext &context = *(this->get_context());
   this->publicKey = make_shared<PublicKey>();
   size_t loaded_bytes = (size_t)publicKey->load(context, in_stream);
-  this->encryptor = make_shared<Encryptor>(context, *publicKey);
-  return loaded_bytes;
+  if (this->secretKey != NULL)
+  {
+    this->encryptor = make_shared<Encryptor>(context, *publicKey, *secretKey);
+  }
+  else
+  {
+    this->encryptor = make_shared<Encryptor>(context, *publicKey);
+  }
+  return stats.bytes(loaded_bytes);
+}
+
+// SAVE/LOAD SECRETKEY
+size_t Afseal::save_secret_key(ostream &out_stream, string &compr_mode)
+{
+  AfsealStats::Scope stats("save_secret_key");
+  return stats.bytes((size_t)this->get_secretKey()->save(out_stream, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_secret_key(istream &in_stream)
+{
+  AfsealStats::Scope stats("load_secret_key");
+  this->check_secret_allowed();
+  seal::SEALContext &context = *(this->get_context());
+  this->secretKey = make_shared<SecretKey>();
+  size_t loaded_bytes = (size_t)secretKey->load(context, in_stream);
+  this->decryptor = make_shared<Decryptor>(context, *secretKey);
+  // Keys generated from now on must belong to the loaded secret key
+  this->keyGenObj = make_shared<KeyGenerator>(context, *secretKey);
+  // New encryptor: copies of this Afseal may share the current one
+  if (this->publicKey != NULL)
+  {
+    this->encryptor = make_shared<Encryptor>(context, *publicKey, *secretKey);
+  }
+  else
+  {
+    this->encryptor = make_shared<Encryptor>(context, *secretKey);
+  }
+  return stats.bytes(loaded_bytes);
+}
+
+// SAVE/LOAD RELINKEY
+size_t Afseal::save_relin_keys(ostream &out_stream, string &compr_mode, bool seeded)
+{
+  AfsealStats::Scope stats("save_relin_keys");
+  if (seeded)
+  {
+    return stats.bytes((size_t)this->get_keyGenObj()->create_relin_keys().save(out_stream, compr_mode_map[compr_mode]));
+  }
+  return stats.bytes((size_t)this->get_relinKeys()->save(out_stream, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_relin_keys(istream &in_stream)
+{
+  AfsealStats::Scope stats("load_relin_keys");
+  this->relinKeys = make_shared<RelinKeys>();
+  return stats.bytes((size_t)relinKeys->load(*(this->get_context()), in_stream));
+}
+
+// SAVE/LOAD ROTKEYS
+size_t Afseal::save_rotate_keys(ostream &out_stream, string &compr_mode, bool seeded)
+{
+  AfsealStats::Scope stats("save_rotate_keys");
+  if (rotateKeyStore)
+  {
+    rotateKeyStore->load_all();
+  }
+  if (seeded)
+  {
+    // Regenerate the same set of keys: the key of galois_elt sits at index (elt-1)/2
+    auto &keys = this->get_rotateKeys()->data();
+    vector<uint32_t> galois_elts;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      if (!keys[i].empty())
+      {
+        galois_elts.push_back(static_cast<uint32_t>(2 * i + 1));
+      }
+    }
+    return stats.bytes((size_t)this->get_keyGenObj()->create_galois_keys(galois_elts).save(out_stream, compr_mode_map[compr_mode]));
+  }
+  return stats.bytes((size_t)this->get_rotateKeys()->save(out_stream, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_rotate_keys(istream &in_stream)
+{
+  AfsealStats::Scope stats("load_rotate_keys");
+  this->rotateKeys = make_shared<GaloisKeys>();
+  this->rotateKeyStore = NULL;
+  return stats.bytes((size_t)rotateKeys->load(*(this->get_context()), in_stream));
+}
+size_t Afseal::save_rotate_keys_store(string &filename)
+{
+  if (rotateKeyStore)
+  {
+    rotateKeyStore->load_all();
+  }
+  return AfsealGaloisKeyStore::save(*(this->get_rotateKeys()), filename);
+}
+size_t Afseal::load_rotate_keys_store(string &filename)
+{
+  auto store = make_shared<AfsealGaloisKeyStore>(filename, this->get_context());
+  this->rotateKeys = store->keys();
+  this->rotateKeyStore = store;
+  return store->n_keys();
+}
+vector<size_t> Afseal::get_rotate_keys_store_stats()
+{
+  auto store = this->rotateKeyStore;
+  if (!store)
+  {
+    return {};
+  }
+  return {store->n_keys(), store->n_loaded()};
+}
+
+// SAVE/LOAD PLAINTEXT --> Could be achieved outside of Afseal
+size_t Afseal::save_plaintext(ostream &out_stream, string &compr_mode, AfPtxt &pt)
+{
+  AfsealStats::Scope stats("save_plaintext");
+  return stats.bytes((size_t)_dyn_p(pt).save(out_stream, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_plaintext(istream &in_stream, AfPtxt &pt)
+{
+  AfsealStats::Scope stats("load_plaintext");
+  return stats.bytes((size_t)_dyn_p(pt).load(*(this->get_context()), in_stream));
+}
+
+// SAVE/LOAD CIPHERTEXT --> Could be achieved outside of Afseal
+size_t Afseal::save_ciphertext(ostream &out_stream, string &compr_mode, AfCtxt &ct)
+{
+  AfsealStats::Scope stats("save_ciphertext");
+  stats.ctxt(ct);
+  relin_operand(_dyn_c(ct));
+  return stats.bytes((size_t)_dyn_c(ct).save(out_stream, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_ciphertext(istream &in_stream, AfCtxt &ct)
+{
+  AfsealStats::Scope stats("load_ciphertext");
+  stats.ctxt(ct);
+  return stats.bytes((size_t)_dyn_c(ct).load(*(this->get_context()), in_stream));
+}
+
+// SAVE/LOAD IN MEMORY
+size_t Afseal::save_plaintext(uint8_t *out, size_t size, string &compr_mode, AfPtxt &pt)
+{
+  AfsealStats::Scope stats("save_plaintext");
+  return stats.bytes((size_t)_dyn_p(pt).save(reinterpret_cast<seal_byte *>(out), size, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_plaintext(const uint8_t *in, size_t size, AfPtxt &pt)
+{
+  AfsealStats::Scope stats("load_plaintext");
+  return stats.bytes((size_t)_dyn_p(pt).load(*(this->get_context()), reinterpret_cast<const seal_byte *>(in), size));
+}
+size_t Afseal::save_ciphertext(uint8_t *out, size_t size, string &compr_mode, AfCtxt &ct)
+{
+  AfsealStats::Scope stats("save_ciphertext");
+  stats.ctxt(ct);
+  relin_operand(_dyn_c(ct));
+  return stats.bytes((size_t)_dyn_c(ct).save(reinterpret_cast<seal_byte *>(out), size, compr_mode_map[compr_mode]));
+}
+size_t Afseal::load_ciphertext(const uint8_t *in, size_t size, AfCtxt &ct)
+{
+  AfsealStats::Scope stats("load_ciphertext");
+  stats.ctxt(ct);
+  return stats.bytes((size_t)_dyn_c(ct).load(*(this->get_context()), reinterpret_cast<const seal_byte *>(in), size));
+}
+
+// RAW DATA
+namespace
+{
+  uint64_t _double_bits(double d)
+  {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return bits;
+  }
+  double _bits_double(uint64_t bits)
+  {
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+  }
+} // namespace
+
+vector<uint64_t> Afseal::raw_header(AfCtxt &ct)
+{
+  Ciphertext &c = _dyn_c(ct);
+  relin_operand(c);
+  const parms_id_type &pid = c.parms_id();
+  return {pid[0], pid[1], pid[2], pid[3], c.size(), c.coeff_modulus_size(),
+          c.poly_modulus_degree(), c.is_ntt_form(), c.correction_factor(),
+          _double_bits(c.scale())};
+}
+uint64_t *Afseal::raw_data(AfCtxt &ct)
+{
+  return _dyn_c(ct).data();
+}
+void Afseal::load_raw(AfCtxt &ct, vector<uint64_t> &header, const uint8_t *data, size_t n_bytes)
+{
+  if (header.size() != 10)
+  {
+    throw invalid_argument("<Afseal>: Raw ciphertext header must have 10 words");
+  }
+  parms_id_type pid = {header[0], header[1], header[2], header[3]};
+  auto context_data = this->get_context()->get_context_data(pid);
+  if (!context_data)
+  {
+    throw invalid_argument("<Afseal>: Raw ciphertext parms_id not in the context");
+  }
+  auto &parms = context_data->parms();
+  size_t count = header[4] * parms.coeff_modulus().size() * parms.poly_modulus_degree();
+  if (header[5] != parms.coeff_modulus().size() || header[6] != parms.poly_modulus_degree() ||
+      n_bytes != count * sizeof(uint64_t))
+  {
+    throw invalid_argument("<Afseal>: Raw ciphertext data does not match its header");
+  }
+  Ciphertext c(_pool());
+  c.resize(*(this->get_context()), pid, header[4]);
+  if (count)
+  {
+    memcpy(c.data(), data, n_bytes);
+  }
+  c.is_ntt_form() = (header[7] != 0);
+  c.correction_factor() = header[8];
+  c.scale() = _bits_double(header[9]);
+  if (!is_valid_for(c, *(this->get_context())))
+  {
+    throw invalid_argument("<Afseal>: Raw ciphertext data is not valid for the context");
+  }
+  static_cast<Ciphertext &>(_dyn_c(ct)) = std::move(c);
+}
+vector<uint64_t> Afseal::raw_header(AfPtxt &pt)
+{
+  Plaintext &p = _dyn_p(pt);
+  const parms_id_type &pid = p.parms_id();
+  return {pid[0], pid[1], pid[2], pid[3], p.coeff_count(), _double_bits(p.scale())};
+}
+uint64_t *Afseal::raw_data(AfPtxt &pt)
+{
+  return _dyn_p(pt).data();
+}
+void Afseal::load_raw(AfPtxt &pt, vector<uint64_t> &header, const uint8_t *data, size_t n_bytes)
+{
+  if (header.size() != 6)
+  {
+    throw invalid_argument("<Afseal>: Raw plaintext header must have 6 words");
+  }
+  if (n_bytes != header[4] * sizeof(uint64_t))
+  {
+    throw invalid_argument("<Afseal>: Raw plaintext data does not match its header");
+  }
+  parms_id_type pid = {header[0], header[1], header[2], header[3]};
+  Plaintext p(_pool());
+  p.resize(header[4]);   // Resized as non-NTT, before setting parms_id
+  if (n_bytes)
+  {
+    memcpy(p.data(), data, n_bytes);
+  }
+  p.parms_id() = pid;
+  p.scale() = _bits_double(header[5]);
+  if (!is_valid_for(p, *(this->get_context())))
+  {
+    throw invalid_argument("<Afseal>: Raw plaintext data is not valid for the context");
+  }
+  static_cast<Plaintext &>(_dyn_p(pt)) = std::move(p);
+}
+
+// SIZES
+size_t Afseal::sizeof_context(string &compr_mode){
+  return (size_t)this->get_context()->key_context_data()->parms().save_size(compr_mode_map[compr_mode]);
+}
+size_t Afseal::sizeof_public_key(string &compr_mode){
+  return (size_t)this->get_publicKey()->save_size(compr_mode_map[compr_mode]);
+}
+size_t Afseal::sizeof_secret_key(string &compr_mode){
+  return (size_t)this->get_secretKey()->save_size(compr_mode_map[compr_mode]);
+}
+size_t Afseal::sizeof_relin_keys(string &compr_mode){
+  return (size_t)this->get_relinKeys()->save_size(compr_mode_map[compr_mode]);
+}
+size_t Afseal::sizeof_rotate_keys(string &compr_mode){
+  if (rotateKeyStore) { rotateKeyStore->load_all(); }
+  return (size_t)this->get_rotateKeys()->save_size(compr_mode_map[compr_mode]);
+}
+size_t Afseal::key_bytes()
+{
+  auto bytes = [](const Ciphertext &c)
+  { return c.size() * c.poly_modulus_degree() * c.coeff_modulus_size() * sizeof(uint64_t); };
+  size_t total = (publicKey) ? bytes(publicKey->data()) : 0;
+  for (auto &key : (relinKeys) ? relinKeys->data() : vector<vector<PublicKey>>{})
+  {
+    for (auto &part : key) { total += bytes(part.data()); }
+  }
+  if (rotateKeyStore)
+  {
+    total += rotateKeyStore->n_loaded() * this->sizeof_galois_key();
+  }
+  else if (rotateKeys)
+  {
+    for (auto &key : rotateKeys->data())
+    {
+      for (auto &part : key) { total += bytes(part.data()); }
+    }
+  }
+  return total;
+}
+size_t Afseal::sizeof_galois_key(){
+  auto key_data = this->get_context()->key_context_data();
+  size_t n = key_data->parms().poly_modulus_degree();
+  size_t n_primes = key_data->parms().coeff_modulus().size();
+  // One size-2 ciphertext at the key level per decomposed data prime
+  return std::max<size_t>(n_primes - 1, 1) * 2 * n_primes * n * sizeof(uint64_t);
+}
+size_t Afseal::sizeof_plaintext(string &compr_mode, AfPtxt &pt){
+  return (size_t)_dyn_p(pt).save_size(compr_mode_map[compr_mode]);
+}
+size_t Afseal::sizeof_ciphertext(string &compr_mode, AfCtxt &ct){
+  relin_operand(_dyn_c(ct));
+  return (size_t)_dyn_c(ct).save_size(compr_mode_map[compr_mode]);
+}
+
+
+// -----------------------------------------------------------------------------
+// -------------------------------- AUXILIARY ----------------------------------
+// -----------------------------------------------------------------------------
+bool Afseal::batchEnabled()
+{
+  return this->get_context()->first_context_data()->qualifiers().using_batching;
+}
+long Afseal::maxBitCount(long poly_modulus_degree, int sec_level)
+{
+  return CoeffModulus::MaxBitCount(poly_modulus_degree, sec_map[sec_level]);
+}
+double Afseal::scale(AfCtxt &ctxt)
+{
+  return _dyn_c(ctxt).scale();
+}
+void Afseal::override_scale(AfCtxt &ctxt, double scale)
+{
+  _dyn_c(ctxt).scale() = scale;
+}
+int Afseal::get_sec()
+{
+  return static_cast<std::underlying_type<sec_level_type>::type>(
+      this->get_context()->first_context_data()->qualifiers().sec_level);
+}
+std::vector<uint64_t> Afseal::get_qi()
+{ 
+  return this->qi;
+}
+// GETTERS
+shared_ptr<SEALContext> inline Afseal::get_context()
+{
+  if (this->components == NULL)
+  {
+    throw std::logic_error("<Afseal>: Context not initialized");
+  }
+  return (this->components->context);
+}
+shared_ptr<Evaluator> inline Afseal::get_evaluator()
+{
+  auto context = this->get_context();
+  return _lazy(components->evaluator, [&context]()
+               { return make_shared<Evaluator>(*context); });
+}
+shared_ptr<Encryptor> inline Afseal::get_encryptor()
+{
+  return _lazy(this->encryptor, [this]()
+  {
+    if (this->publicKey == NULL)
+    {
+      throw std::logic_error("<Afseal>: Missing Public key");
+    }
+    return make_shared<Encryptor>(*(this->get_context()), *publicKey);
+  });
+}
+shared_ptr<Decryptor> inline Afseal::get_decryptor()
+{
+  if (this->decryptor == NULL)
+  {
+    throw std::logic_error("<Afseal>: Missing Secret key");
+  }
+  return (this->decryptor);
+}
+shared_ptr<BatchEncoder> inline Afseal::get_bfv_encoder()
+{
+  if (this->components == NULL || this->get_scheme() != scheme_t::bfv)
+  {
+    throw std::logic_error("<Afseal>: BFV context not initialized");
+  }
+  auto context = components->context;
+  return _lazy(components->batch_encoder, [&context]()
+               { return make_shared<BatchEncoder>(*context); });
+}
+shared_ptr<CKKSEncoder> inline Afseal::get_ckks_encoder()
+{
+  if (this->components == NULL || this->get_scheme() != scheme_t::ckks)
+  {
+    throw std::logic_error("<Afseal>: CKKS context not initialized");
+  }
+  auto context = components->context;
+  return _lazy(components->ckks_encoder, [&context]()
+               { return make_shared<CKKSEncoder>(*context); });
+}
+shared_ptr<BatchEncoder> inline Afseal::get_bgv_encoder()
+{
+  if (this->components == NULL || this->get_scheme() != scheme_t::bgv)
+  {
+    throw std::logic_error("<Afseal>: BGV context not initialized");
+  }
+  auto context = components->context;
+  return _lazy(components->batch_encoder, [&context]()
+               { return make_shared<BatchEncoder>(*context); });
+}
+shared_ptr<KeyGenerator> inline Afseal::get_keyGenObj()
+{
+  if (this->keyGenObj == NULL)
+  {
+    throw std::logic_error("<Afseal>: Context not initialized");
+  }
+  this->get_secretKey();
+  return (this->keyGenObj);
+}
+shared_ptr<SecretKey> inline Afseal::get_secretKey()
+{
+  if (this->secretKey == NULL)
+  {
+    throw std::logic_error("<Afseal>: Secret Key not initialized");
+  }
+  return (this->secretKey);
+}
+shared_ptr<PublicKey> inline Afseal::get_publicKey()
+{
+  if (this->publicKey == NULL)
+  {
+    throw std::logic_error("<Afseal>: Public Key not initialized");
+  }
+  return (this->publicKey);
+}
+shared_ptr<RelinKeys> inline Afseal::get_relinKeys()
+{
+  if (this->relinKeys == NULL)
+  {
+    throw std::logic_error("<Afseal>: Relinearization Keys not initialized");
+  }
+  return (this->relinKeys);
+}
+shared_ptr<GaloisKeys> inline Afseal::get_rotateKeys()
+{
+  if (this->rotateKeys == NULL)
+  {
+    throw std::logic_error("<Afseal>: Rotation Keys not initialized");
+  }
+  return (this->rotateKeys);
+}
+size_t Afseal::get_nSlots()
+{
+  scheme_t scheme = this->get_scheme();
+  if (scheme == scheme_t::bfv)
+  {
+    return this->get_bfv_encoder()->slot_count();
+  }
+  else if (scheme == scheme_t::ckks)
+  {
+    return this->get_ckks_encoder()->slot_count();
+  }
+  else if (scheme == scheme_t::bgv)
+  {
+    return this->get_bgv_encoder()->slot_count();
+  }
+  return -1;
+}
+uint64_t Afseal::get_plain_modulus()
+{
+  return this->get_context()->first_context_data()->parms().plain_modulus().value();
+}
+size_t Afseal::get_poly_modulus_degree()
+{
+  return this->get_context()->first_context_data()->parms().poly_modulus_degree();
+}
+
+scheme_t Afseal::get_scheme()
+{
+  return scheme_map_to_afhel[this->get_context()->first_context_data()->parms().scheme()];
+}
+
+int Afseal::total_coeff_modulus_bit_count()
+{
+  return this->get_context()->first_context_data()->total_coeff_modulus_bit_count();
+}
+// TODO: coeff_modulus?
+
+// -----------------------------------------------------------------------------
+// ----------------------------- VECTORIZATION ---------------------------------
+// -----------------------------------------------------------------------------
+namespace
+{
+// Runs one element of a batch traced as a task of the operation `op`
+template <class F>
+void _traced(const AfsealTracer::Span *op, AfCtxt &ctxt, F &&f)
+{
+  AfsealTracer::Span span(op);
+  if (op)
+  {
+    span.ctxt(_dyn_c(ctxt));
+  }
+  f();
+}
+}  // namespace
+
+void Afseal::vectorize(
+    vector<std::shared_ptr<AfCtxt>> &ctxtVInOut,
+    vector<std::shared_ptr<AfCtxt>> &ctxtV2,
+    function<void(AfCtxt&, AfCtxt&)> f)
+{
+  if (ctxtVInOut.size() != ctxtV2.size())
+  {
+    throw runtime_error("Vectors must be of same size to vectorize");
+  }
+  const AfsealTracer::Span *op = AfsealTracer::Span::current();
+  AfsealTaskPool::instance().parallel_for(ctxtVInOut.size(),
+    [&](size_t i){ _traced(op, *ctxtVInOut[i], [&]{ f(*ctxtVInOut[i], *ctxtV2[i]); }); });
+}
+void Afseal::vectorize(
+    vector<std::shared_ptr<AfCtxt>> &ctxtVInOut,
+    vector<std::shared_ptr<AfPtxt>> &ptxtV,
+    function<void(AfCtxt&, AfPtxt&)> f)
+{
+  if (ctxtVInOut.size() != ptxtV.size())
+  {
+    throw runtime_error("Vectors must be of same size to vectorize");
+  }
+  const AfsealTracer::Span *op = AfsealTracer::Span::current();
+  AfsealTaskPool::instance().parallel_for(ctxtVInOut.size(),
+    [&](size_t i){ _traced(op, *ctxtVInOut[i], [&]{ f(*ctxtVInOut[i], *ptxtV[i]); }); });
+}
+
+void Afseal::vectorize(
+    vector<std::shared_ptr<AfCtxt>> &ctxtVInOut,
+    function<void(AfCtxt&)> f)
+{
+  const AfsealTracer::Span *op = AfsealTracer::Span::current();
+  AfsealTaskPool::instance().parallel_for(ctxtVInOut.size(),
+    [&](size_t i){ _traced(op, *ctxtVInOut[i], [&]{ f(*ctxtVInOut[i]); }); });
+}
+
+void Afseal::vectorize(
+    vector<std::shared_ptr<AfPtxt>> &plainVInOut,
+    function<void(AfPtxt&)> f)
+{
+  const AfsealTracer::Span *op = AfsealTracer::Span::current();
+  AfsealTaskPool::instance().parallel_for(plainVInOut.size(),
+    [&](size_t i)
+    {
+      AfsealTracer::Span span(op);
+      f(*plainVInOut[i]);
+    });
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------- TASK ENGINE ---------------------------------
+// -----------------------------------------------------------------------------
+/// State shared by all the ranges of a single parallel_for call.
+struct AfsealTaskPool::Job
+{
+  const function<void(size_t)> *f;
+  atomic<size_t> remaining;   // Tasks not yet finished
+  mutex mtx;                  // Guards err & completion signaling
+  condition_variable cv;
+  atomic<bool> done{false};
+  exception_ptr err = nullptr;
+};
+
+AfsealTaskPool &AfsealTaskPool::instance()
+{
+  // Never destroyed: joining threads from static destructors at interpreter
+  //  exit (or library unload) can deadlock. The OS reclaims the workers.
+  static AfsealTaskPool *pool = []()
+  {
+    size_t n_threads = thread::hardware_concurrency();
+    if (const char *env = getenv("AFSEAL_NUM_THREADS"))
+    {
+      n_threads = (size_t)strtoul(env, nullptr, 10);
+    }
+    return new AfsealTaskPool(n_threads);
+  }();
+  return *pool;
+}
+
+AfsealTaskPool::AfsealTaskPool(size_t n_threads)
+{
+  size_t n_workers = (n_threads > 1) ? n_threads - 1 : 0;
+  for (size_t w = 0; w < n_workers; w++)
+  {
+    queues.emplace_back(new Queue());
+  }
+  for (size_t w = 0; w < n_workers; w++)
+  {
+    workers.emplace_back(&AfsealTaskPool::worker_loop, this, w);
+  }
+}
+
+AfsealTaskPool::~AfsealTaskPool()
+{
+  {
+    lock_guard<mutex> lk(idle_mtx);
+    stop = true;
+  }
+  idle_cv.notify_all();
+  for (auto &w : workers)
+  {
+    w.join();
+  }
+}
+
+void AfsealTaskPool::parallel_for(size_t n, const function<void(size_t)> &f)
+{
+  if (n == 0)
+  {
+    return;
+  }
+  if (n == 1 || workers.empty()) // Not worth dispatching
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      f(i);
+    }
+    return;
+  }
+  Job job;
+  job.f = &f;
+  job.remaining = n;
+  // Initial split: one contiguous range per worker. Stealing rebalances it.
+  size_t n_parts = std::min(n, workers.size());
+  for (size_t p = 0; p < n_parts; p++)
+  {
+    Queue &q = *queues[p];
+    lock_guard<mutex> lk(q.mtx);
+    q.ranges.push_back({&job, n * p / n_parts, n * (p + 1) / n_parts});
+  }
+  queued += n;
+  {
+    lock_guard<mutex> lk(idle_mtx);
+  }
+  idle_cv.notify_all();
+
+  // Help with the work (one task at a time, so workers keep most of it)
+  Range task;
+  while (!job.done && steal(queues.size(), task, false))
+  {
+    run(task);
+  }
+  unique_lock<mutex> lk(job.mtx);
+  job.cv.wait(lk, [&job] { return job.done.load(); });
+  if (job.err)
+  {
+    rethrow_exception(job.err);
+  }
+}
+
+void AfsealTaskPool::worker_loop(size_t id)
+{
+  Range task;
+  while (true)
+  {
+    if (pop_front(id, task) || steal(id, task, true))
+    {
+      run(task);
+      continue;
+    }
+    unique_lock<mutex> lk(idle_mtx);
+    idle_cv.wait(lk, [this] { return stop || queued.load() > 0; });
+    if (stop)
+    {
+      return;
+    }
+  }
+}
+
+bool AfsealTaskPool::pop_front(size_t q, Range &task)
+{
+  Queue &queue = *queues[q];
+  lock_guard<mutex> lk(queue.mtx);
+  if (queue.ranges.empty())
+  {
+    return false;
+  }
+  Range &front = queue.ranges.front();
+  task = {front.job, front.begin, front.begin + 1};
+  if (++front.begin == front.end)
+  {
+    queue.ranges.pop_front();
+  }
+  queued--;
+  return true;
+}
+
+bool AfsealTaskPool::steal(size_t thief, Range &task, bool whole_half)
+{
+  size_t n_queues = queues.size();
+  for (size_t v = 1; v <= n_queues; v++)
+  {
+    size_t victim = (thief + v) % n_queues;
+    if (victim == thief)
+    {
+      continue;
+    }
+    Queue &queue = *queues[victim];
+    unique_lock<mutex> lk(queue.mtx);
+    if (queue.ranges.empty())
+    {
+      continue;
+    }
+    Range &back = queue.ranges.back();
+    size_t left = back.end - back.begin;
+    size_t take = whole_half ? (left + 1) / 2 : 1;
+    task = {back.job, back.end - take, back.end};
+    back.end -= take;
+    if (back.begin == back.end)
+    {
+      queue.ranges.pop_back();
+    }
+    lk.unlock();
+    if (whole_half && take > 1) // Keep all but the first index in our queue
+    {
+      Queue &own = *queues[thief];
+      lock_guard<mutex> own_lk(own.mtx);
+      own.ranges.push_front({task.job, task.begin + 1, task.end});
+      task.end = task.begin + 1;
+    }
+    queued--;
+    return true;
+  }
+  return false;
+}
+
+void AfsealTaskPool::run(const Range &task)
+{
+  Job &job = *task.job;
+  for (size_t i = task.begin; i < task.end; i++)
+  {
+    try
+    {
+      (*job.f)(i);
+    }
+    catch (...)
+    {
+      lock_guard<mutex> lk(job.mtx);
+      if (!job.err)
+      {
+        job.err = current_exception();
+      }
+    }
+  }
+  size_t n_run = task.end - task.begin;
+  if (job.remaining.fetch_sub(n_run) == n_run) // Last one notifies the caller
+  {
+    lock_guard<mutex> lk(job.mtx);
+    job.done = true;
+    job.cv.notify_all();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------- MEMORY POOLS --------------------------------
+// -----------------------------------------------------------------------------
+namespace
+{
+// Pools of the live threads. Never destroyed, like the task pool: thread
+//  slots may be released after static destructors at interpreter exit.
+struct _PoolRegistry
+{
+  mutex mtx;
+  vector<MemoryPoolHandle> live;
+  size_t retired_peak = 0;
+};
+_PoolRegistry &_pool_registry()
+{
+  static _PoolRegistry *registry = new _PoolRegistry();
+  return *registry;
+}
+}  // namespace
+
+/// Owner of a thread pool, registering it on creation and retiring it when
+///  the thread exits. The registry lock is only taken at those two points.
+struct AfsealMemoryPools::Slot
+{
+  MemoryPoolHandle pool = MemoryPoolHandle::New();
+  Slot()
+  {
+    _PoolRegistry &r = _pool_registry();
+    lock_guard<mutex> lk(r.mtx);
+    r.live.push_back(pool);
+  }
+  ~Slot()
+  {
+    _PoolRegistry &r = _pool_registry();
+    lock_guard<mutex> lk(r.mtx);
+    r.retired_peak = std::max(r.retired_peak, pool.alloc_byte_count());
+    r.live.erase(std::find(r.live.begin(), r.live.end(), pool));
+  }
+};
+
+const MemoryPoolHandle &AfsealMemoryPools::local()
+{
+  thread_local Slot slot;
+  return slot.pool;
+}
+
+vector<size_t> AfsealMemoryPools::high_water()
+{
+  _PoolRegistry &r = _pool_registry();
+  lock_guard<mutex> lk(r.mtx);
+  vector<size_t> bytes;
+  for (const MemoryPoolHandle &pool : r.live)
+  {
+    bytes.push_back(pool.alloc_byte_count());
+  }
+  return bytes;
+}
+
+size_t AfsealMemoryPools::retired_high_water()
+{
+  _PoolRegistry &r = _pool_registry();
+  lock_guard<mutex> lk(r.mtx);
+  return r.retired_peak;
+}
+
+// -----------------------------------------------------------------------------
+// ---------------------------------- TRACING ----------------------------------
+// -----------------------------------------------------------------------------
+namespace
+{
+struct _TraceEvent
+{
+  const char *op;   // String literal naming the operation
+  long arg;
+  bool with_arg, task;
+  uint64_t level, size, begin_ns, end_ns;
+};
+
+// Events of one thread, written only by it. Rather than a lock, start/stop
+//  turn tracing off and wait until no event is `writing`: a thread only
+//  writes after checking, inside that flag, that tracing is still on.
+struct _TraceRing
+{
+  uint32_t tid = 0;
+  atomic<bool> writing{false};
+  uint64_t head = 0;              // Events pushed since the last start
+  vector<_TraceEvent> events;     // Sized by its thread on the first push
+};
+
+// Rings of the live threads, and of the exited ones until the next start.
+struct _TraceRegistry
+{
+  mutex mtx;
+  vector<_TraceRing *> live, retired;
+  uint32_t next_tid = 1;
+  atomic<size_t> capacity{1 << 16};
+  uint64_t origin_ns = 0;         // Time of the last start
+};
+_TraceRegistry &_trace_registry()
+{
+  static _TraceRegistry *registry = new _TraceRegistry();
+  return *registry;
+}
+
+_TraceRing &_trace_ring()
+{
+  struct Slot
+  {
+    _TraceRing *ring = new _TraceRing();
+    Slot()
+    {
+      _TraceRegistry &r = _trace_registry();
+      lock_guard<mutex> lk(r.mtx);
+      ring->tid = r.next_tid++;
+      r.live.push_back(ring);
+    }
+    ~Slot()
+    {
+      _TraceRegistry &r = _trace_registry();
+      lock_guard<mutex> lk(r.mtx);
+      r.live.erase(std::find(r.live.begin(), r.live.end(), ring));
+      if (ring->head)
+      {
+        r.retired.push_back(ring);
+      }
+      else
+      {
+        delete ring;
+      }
+    }
+  };
+  thread_local Slot slot;
+  return *slot.ring;
+}
+
+thread_local const AfsealTracer::Span *_trace_current = nullptr;
+
+uint64_t _trace_now()
+{
+  return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+      chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Waits until no thread is writing an event. Tracing must be off.
+void _trace_quiesce(_TraceRegistry &r)
+{
+  for (_TraceRing *ring : r.live)
+  {
+    while (ring->writing.load())
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+}  // namespace
+
+atomic<bool> AfsealTracer::on{false};
+
+void AfsealTracer::start(size_t capacity)
+{
+  if (capacity == 0)
+  {
+    throw std::invalid_argument("<Afseal>: Trace capacity must be positive");
+  }
+  _TraceRegistry &r = _trace_registry();
+  lock_guard<mutex> lk(r.mtx);
+  on.store(false);
+  _trace_quiesce(r);
+  for (_TraceRing *ring : r.retired) { delete ring; }
+  r.retired.clear();
+  for (_TraceRing *ring : r.live)
+  {
+    ring->head = 0;
+    ring->events = vector<_TraceEvent>();
+  }
+  r.capacity.store(capacity);
+  r.origin_ns = _trace_now();
+  on.store(true);
 }
 
-// SAVE/LOAD SECRETKEY
-size_t Afseal::save_secret_key(ostream &out_stream, string &compr_mode)
+size_t AfsealTracer::stop(const string &path)
 {
-  return (size_t)this->get_secretKey()->save(out_stream, compr_mode_map[compr_mode]);
+  _TraceRegistry &r = _trace_registry();
+  lock_guard<mutex> lk(r.mtx);
+  on.store(false);
+  _trace_quiesce(r);
+
+  std::ofstream file(path, std::ios::trunc);
+  if (!file)
+  {
+    throw std::invalid_argument("<Afseal>: Cannot open trace file " + path);
+  }
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+       << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+       << "\"args\":{\"name\":\"Afseal\"}}";
+  size_t n_events = 0;
+  uint64_t dropped = 0;
+  vector<_TraceRing *> rings(r.live);
+  rings.insert(rings.end(), r.retired.begin(), r.retired.end());
+  for (_TraceRing *ring : rings)
+  {
+    if (!ring->head)
+    {
+      continue;
+    }
+    file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+         << ",\"args\":{\"name\":\"thread " << ring->tid << "\"}}";
+    size_t cap = ring->events.size();
+    uint64_t first = ring->head > cap ? ring->head - cap : 0;
+    dropped += first;
+    for (uint64_t i = first; i < ring->head; i++)
+    {
+      const _TraceEvent &ev = ring->events[i % cap];
+      if (ev.begin_ns < r.origin_ns)   // Began before the trace started
+      {
+        continue;
+      }
+      file << ",\n{\"name\":\"" << ev.op;
+      if (ev.with_arg)
+      {
+        file << "[" << ev.arg << "]";
+      }
+      file << "\",\"cat\":\"" << (ev.task ? "task" : "op") << "\",\"ph\":\"X\",\"pid\":1,"
+           << "\"tid\":" << ring->tid << ",\"ts\":" << (ev.begin_ns - r.origin_ns) / 1e3
+           << ",\"dur\":" << (ev.end_ns - ev.begin_ns) / 1e3;
+      if (ev.size)
+      {
+        file << ",\"args\":{\"level\":" << ev.level << ",\"size\":" << ev.size << "}";
+      }
+      file << "}";
+      n_events++;
+    }
+  }
+  file << "\n],\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+  if (!file)
+  {
+    throw std::runtime_error("<Afseal>: Could not write trace file " + path);
+  }
+  return n_events;
 }
-size_t Afseal::load_secret_key(istream &in_stream)
+
+AfsealTracer::Span::Span(const char *op, long arg, bool with_arg)
+    : op(op), arg(arg), with_arg(with_arg), task(false), active(AfsealTracer::enabled())
 {
-  seal::SEALContext &context = *(this->get_context());
-  this->secretKey = make_shared<SecretKey>();
-  size_t loaded_bytes = (size_t)secretKey->load(context, in_stream);
-  this->decryptor = make_shared<Decryptor>(context, *secretKey);
-  return loaded_bytes;
+  if (active)
+  {
+    open();
+  }
 }
 
-// SAVE/LOAD RELINKEY
-size_t Afseal::save_relin_keys(ostream &out_stream, string &compr_mode)
+AfsealTracer::Span::Span(const Span *parent)
+    : op(parent ? parent->op : nullptr), arg(parent ? parent->arg : 0),
+      with_arg(parent && parent->with_arg), task(true),
+      active(parent != nullptr && AfsealTracer::enabled())
 {
-  return (size_t)this->get_relinKeys()->save(out_stream, compr_mode_map[compr_mode]);
+  if (active)
+  {
+    open();
+  }
 }
-size_t Afseal::load_relin_keys(istream &in_stream)
+
+void AfsealTracer::Span::open()
 {
-  this->relinKeys = make_shared<RelinKeys>();
-  return (size_t)relinKeys->load(*(this->get_context()), in_stream);
+  prev = _trace_current;
+  _trace_current = this;
+  begin_ns = _trace_now();
 }
 
-// SAVE/LOAD ROTKEYS
-size_t Afseal::save_rotate_keys(ostream &out_stream, string &compr_mode)
+const AfsealTracer::Span *AfsealTracer::Span::current()
 {
-  return (size_t)this->get_rotateKeys()->save(out_stream, compr_mode_map[compr_mode]);
+  return _trace_current;
 }
-size_t Afseal::load_rotate_keys(istream &in_stream)
+
+AfsealTracer::Span::~Span()
 {
-  this->rotateKeys = make_shared<GaloisKeys>();
-  return (size_t)rotateKeys->load(*(this->get_context()), in_stream);
+  if (!active)
+  {
+    return;
+  }
+  _trace_current = prev;
+  _TraceEvent ev{op, arg, with_arg, task, 0, 0, begin_ns, _trace_now()};
+  if (target)
+  {
+    ev.level = target->coeff_modulus_size();
+    ev.size = target->size();
+  }
+  _TraceRing *ring = nullptr;
+  try
+  {
+    ring = &_trace_ring();
+    ring->writing.store(true);
+    if (on.load())
+    {
+      if (ring->events.empty())
+      {
+        ring->events.resize(_trace_registry().capacity.load());
+      }
+      ring->events[ring->head % ring->events.size()] = ev;
+      ring->head++;
+    }
+    ring->writing.store(false);
+  }
+  catch (...)   // Never throw from a destructor, e.g. on bad_alloc
+  {
+    if (ring)
+    {
+      ring->writing.store(false);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// -------------------------------- STATISTICS ---------------------------------
+// -----------------------------------------------------------------------------
+namespace
+{
+const size_t _stats_buckets = 4 * 64;
+
+// Bucket of a latency: 4 per power of two, by the 2 bits after the leading one
+size_t _stats_bucket(uint64_t ns)
+{
+  if (ns < 4)
+  {
+    return static_cast<size_t>(ns);
+  }
+  size_t e = 0;
+  for (uint64_t v = ns; v >>= 1;) { e++; }
+  return 4 * (e - 1) + static_cast<size_t>((ns >> (e - 2)) & 3);
+}
+// Smallest latency of a bucket
+double _stats_bucket_floor(size_t b)
+{
+  if (b < 4)
+  {
+    return static_cast<double>(b);
+  }
+  size_t e = b / 4 + 1;
+  return std::ldexp(static_cast<double>(4 + b % 4), static_cast<int>(e) - 2);
+}
+
+struct _StatsEntry
+{
+  uint64_t count = 0, total_ns = 0, max_ns = 0, bytes = 0, pool_bytes = 0;
+  vector<uint64_t> hist = vector<uint64_t>(_stats_buckets, 0);
+
+  void merge(const _StatsEntry &other)
+  {
+    count += other.count;
+    total_ns += other.total_ns;
+    max_ns = std::max(max_ns, other.max_ns);
+    bytes += other.bytes;
+    pool_bytes += other.pool_bytes;
+    for (size_t b = 0; b < _stats_buckets; b++) { hist[b] += other.hist[b]; }
+  }
+  // Midpoint of the bucket holding the q-quantile
+  double percentile(double q) const
+  {
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * count)), seen = 0;
+    for (size_t b = 0; b < _stats_buckets; b++)
+    {
+      seen += hist[b];
+      if (seen >= rank && hist[b])
+      {
+        double mid = (_stats_bucket_floor(b) + _stats_bucket_floor(b + 1)) / 2;
+        return std::min(mid, static_cast<double>(max_ns));
+      }
+    }
+    return static_cast<double>(max_ns);
+  }
+};
+
+// Operations recorded by one thread, merged into the retired ones when the
+//  thread exits. Its lock is only contended by snapshots and resets.
+struct _StatsShard
+{
+  mutex mtx;
+  map<string, _StatsEntry> ops;
+};
+
+// Shards of the live threads. Never destroyed, like the memory pools.
+struct _StatsRegistry
+{
+  mutex mtx;
+  vector<_StatsShard *> live;
+  map<string, _StatsEntry> retired;
+};
+_StatsRegistry &_stats_registry()
+{
+  static _StatsRegistry *registry = new _StatsRegistry();
+  return *registry;
+}
+}  // namespace
+
+atomic<bool> AfsealStats::on{[]
+{
+  const char *env = std::getenv("AFSEAL_STATS");
+  return env != nullptr && std::atoi(env) != 0;
+}()};
+
+void AfsealStats::set_enabled(bool enabled)
+{
+  on.store(enabled);
+}
+
+void AfsealStats::record(const string &op, uint64_t ns, uint64_t bytes, uint64_t pool_bytes)
+{
+  struct Slot
+  {
+    _StatsShard shard;
+    Slot()
+    {
+      _StatsRegistry &r = _stats_registry();
+      lock_guard<mutex> lk(r.mtx);
+      r.live.push_back(&shard);
+    }
+    ~Slot()
+    {
+      _StatsRegistry &r = _stats_registry();
+      lock_guard<mutex> lk(r.mtx);
+      for (auto &it : shard.ops) { r.retired[it.first].merge(it.second); }
+      r.live.erase(std::find(r.live.begin(), r.live.end(), &shard));
+    }
+  };
+  thread_local Slot slot;
+  lock_guard<mutex> lk(slot.shard.mtx);
+  _StatsEntry &e = slot.shard.ops[op];
+  e.count++;
+  e.total_ns += ns;
+  e.max_ns = std::max(e.max_ns, ns);
+  e.bytes += bytes;
+  e.pool_bytes += pool_bytes;
+  e.hist[_stats_bucket(ns)]++;
+}
+
+void AfsealStats::reset()
+{
+  _StatsRegistry &r = _stats_registry();
+  lock_guard<mutex> lk(r.mtx);
+  r.retired.clear();
+  for (_StatsShard *shard : r.live)
+  {
+    lock_guard<mutex> slk(shard->mtx);
+    shard->ops.clear();
+  }
+}
+
+map<string, vector<double>> AfsealStats::snapshot()
+{
+  map<string, _StatsEntry> ops;
+  {
+    _StatsRegistry &r = _stats_registry();
+    lock_guard<mutex> lk(r.mtx);
+    ops = r.retired;
+    for (_StatsShard *shard : r.live)
+    {
+      lock_guard<mutex> slk(shard->mtx);
+      for (auto &it : shard->ops) { ops[it.first].merge(it.second); }
+    }
+  }
+  map<string, vector<double>> stats;
+  for (auto &it : ops)
+  {
+    const _StatsEntry &e = it.second;
+    stats[it.first] = {(double)e.count, (double)e.total_ns, (double)e.bytes, (double)e.pool_bytes,
+                       e.percentile(0.5), e.percentile(0.9), e.percentile(0.99), (double)e.max_ns};
+  }
+  return stats;
+}
+
+AfsealStats::Scope::Scope(const char *op, long arg, bool with_arg)
+    : span(op, arg, with_arg), op(op), arg(arg), with_arg(with_arg), active(AfsealStats::enabled())
+{
+  if (active)
+  {
+    pool_bytes = AfsealMemoryPools::local().alloc_byte_count();
+    start = chrono::steady_clock::now();
+  }
+}
+
+void AfsealStats::Scope::ctxt(AfCtxt &c)
+{
+  if (span.traced())
+  {
+    span.ctxt(_dyn_c(c));
+  }
+}
+
+AfsealStats::Scope::~Scope()
+{
+  if (!active)
+  {
+    return;
+  }
+  uint64_t ns = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+      chrono::steady_clock::now() - start).count());
+  size_t pool_now = AfsealMemoryPools::local().alloc_byte_count();
+  string name = with_arg ? string(op) + "[" + std::to_string(arg) + "]" : string(op);
+  try
+  {
+    record(name, ns, n_bytes, pool_now - pool_bytes);
+  }
+  catch (...)   // Never throw from a destructor, e.g. on bad_alloc
+  {
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------- CONTEXT CACHE -------------------------------
+// -----------------------------------------------------------------------------
+struct AfsealContextCache::State
+{
+  struct Entry
+  {
+    shared_ptr<AfsealComponents> components;
+    uint64_t last_use;
+  };
+  mutex mtx;
+  map<pair<parms_id_type, int>, Entry> entries;
+  size_t capacity = 16;
+  uint64_t hits = 0, misses = 0, clock = 0;
+  State()
+  {
+    if (const char *env = getenv("AFSEAL_CONTEXT_CACHE"))
+    {
+      capacity = (size_t)strtoul(env, nullptr, 10);
+    }
+  }
+  // Evicts the least recently used entries beyond capacity. Requires mtx.
+  void evict()
+  {
+    while (entries.size() > capacity)
+    {
+      auto lru = entries.begin();
+      for (auto it = entries.begin(); it != entries.end(); it++)
+      {
+        if (it->second.last_use < lru->second.last_use) { lru = it; }
+      }
+      entries.erase(lru);
+    }
+  }
+};
+
+AfsealContextCache::State &AfsealContextCache::state()
+{
+  static State *s = new State();  // Never destroyed, like the task pool
+  return *s;
+}
+
+shared_ptr<AfsealComponents> AfsealContextCache::get(const EncryptionParameters &parms,
+                                                     sec_level_type sec)
+{
+  State &s = state();
+  auto key = make_pair(parms.parms_id(), static_cast<int>(sec));
+  {
+    lock_guard<mutex> lk(s.mtx);
+    auto it = s.entries.find(key);
+    if (it != s.entries.end())
+    {
+      s.hits++;
+      it->second.last_use = ++s.clock;
+      return it->second.components;
+    }
+    s.misses++;
+  }
+  // Built without the lock. Concurrent misses on the same parameters may
+  //  each build a context, and all of them get the first one cached.
+  auto built = make_shared<AfsealComponents>();
+  built->context = make_shared<SEALContext>(parms, true, sec);
+  if (!built->context->parameters_set())
+  {
+    return built;
+  }
+  lock_guard<mutex> lk(s.mtx);
+  if (s.capacity == 0)
+  {
+    return built;
+  }
+  auto res = s.entries.emplace(key, State::Entry{built, ++s.clock});
+  s.evict();
+  return res.first->second.components;
+}
+
+void AfsealContextCache::set_capacity(size_t capacity)
+{
+  State &s = state();
+  lock_guard<mutex> lk(s.mtx);
+  s.capacity = capacity;
+  s.evict();
+}
+
+void AfsealContextCache::clear()
+{
+  State &s = state();
+  lock_guard<mutex> lk(s.mtx);
+  s.entries.clear();
+  s.hits = s.misses = 0;
+}
+
+vector<uint64_t> AfsealContextCache::stats()
+{
+  State &s = state();
+  lock_guard<mutex> lk(s.mtx);
+  return {s.hits, s.misses, s.entries.size(), s.capacity};
+}
+
+// -----------------------------------------------------------------------------
+// ------------------------------ TENANT REGISTRY ------------------------------
+// -----------------------------------------------------------------------------
+namespace
+{
+// Path in directory named `prefix` plus the FNV-1a hash of key
+string _hashed_path(const string &directory, const string &prefix, const string &key)
+{
+  uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : key)
+  {
+    h = (h ^ c) * 1099511628211ULL;
+  }
+  ostringstream path;
+  path << directory << "/" << prefix << std::hex << h;
+  return path.str();
+}
+}  // namespace
+
+struct AfsealTenantRegistry::State
+{
+  struct Entry
+  {
+    shared_ptr<Afseal> afseal;          /**< NULL while spilled.*/
+    size_t bytes = 0;                   /**< Key bytes while in memory.*/
+    uint64_t last_use = 0;
+    int sec = 128;
+    double scale = 1;                   /**< Default scale of the tenant.*/
+    vector<int> qi_sizes;
+    string spill_base;                  /**< Spill files, empty if none.*/
+    bool spilling = false;              /**< Being written, still in memory.*/
+    bool has_public = false, has_relin = false, has_rotate = false;
+  };
+  struct Victim
+  {
+    string tenant;
+    shared_ptr<Afseal> afseal;          /**< Held while spilling.*/
+    Entry entry;
+  };
+  mutex mtx;
+  map<string, Entry> entries;
+  size_t budget = 0;
+  string spill_dir;
+  uint64_t clock = 0, spills = 0, hits = 0, reloads = 0, evictions = 0;
+
+  // Evicts the least recently used tenants not in use until the keys in
+  //  memory fit in the budget. Tenants without spill files are written
+  //  without holding the lock, and evicted only if written and unchanged
+  //  meanwhile. Requires lk to hold mtx, and releases it.
+  void evict(unique_lock<mutex> &lk)
+  {
+    vector<shared_ptr<Afseal>> released;   // Destroyed after unlocking
+    vector<Victim> victims = pick(released);
+    if (victims.empty())
+    {
+      lk.unlock();
+      return;
+    }
+    lk.unlock();
+    vector<bool> written(victims.size());
+    for (size_t i = 0; i < victims.size(); i++)
+    {
+      written[i] = spill(*victims[i].afseal, victims[i].entry);
+    }
+    vector<Entry> stale;
+    lk.lock();
+    for (size_t i = 0; i < victims.size(); i++)
+    {
+      Victim &v = victims[i];
+      auto it = entries.find(v.tenant);
+      if (it == entries.end() || it->second.afseal != v.afseal)
+      {
+        stale.push_back(v.entry);   // Removed or replaced meanwhile
+        continue;
+      }
+      Entry &e = it->second;
+      e.spilling = false;
+      if (!written[i])
+      {
+        stale.push_back(v.entry);
+        continue;
+      }
+      e.spill_base = v.entry.spill_base;
+      if (e.afseal.use_count() == 2)   // Held by the registry and v only
+      {
+        e.afseal = NULL;
+        evictions++;
+      }
+    }
+    lk.unlock();
+    for (const Entry &e : stale)
+    {
+      remove_spill(e);
+    }
+  }
+
+  // Victims of evict() to be spilled, still in memory. Those with spill
+  //  files, or without a spill directory, are evicted right away, moving
+  //  their Afseal to released. Requires mtx.
+  vector<Victim> pick(vector<shared_ptr<Afseal>> &released)
+  {
+    vector<Victim> victims;
+    if (budget == 0)
+    {
+      return victims;
+    }
+    size_t total = 0;
+    for (auto &it : entries)
+    {
+      total += (it.second.afseal && !it.second.spilling) ? it.second.bytes : 0;
+    }
+    while (total > budget)
+    {
+      auto lru = entries.end();
+      for (auto it = entries.begin(); it != entries.end(); it++)
+      {
+        const Entry &e = it->second;
+        if (e.afseal && !e.spilling && e.afseal.use_count() == 1 &&
+            (lru == entries.end() || e.last_use < lru->second.last_use))
+        {
+          lru = it;
+        }
+      }
+      if (lru == entries.end())
+      {
+        break;   // Every tenant in memory is in use
+      }
+      Entry &e = lru->second;
+      total -= e.bytes;
+      if (spill_dir.empty())
+      {
+        evictions++;
+        released.push_back(std::move(e.afseal));
+        entries.erase(lru);
+        continue;
+      }
+      if (!e.spill_base.empty())
+      {
+        evictions++;
+        released.push_back(std::move(e.afseal));
+        e.afseal = NULL;
+        continue;
+      }
+      // Unique per spill, so that concurrent spills never share files
+      e.spilling = true;
+      Victim v{lru->first, e.afseal, e};
+      v.entry.spill_base = _hashed_path(spill_dir, "tenant_", lru->first) +
+                           "_" + to_string(++spills);
+      victims.push_back(std::move(v));
+    }
+    return victims;
+  }
+
+  // Writes the context and keys of a tenant, rotation keys as a key store.
+  //  Returns false, leaving no files, if any of them could not be written.
+  static bool spill(Afseal &afseal, const Entry &e)
+  {
+    string none = "none";
+    bool ok = true;
+    try
+    {
+      ofstream ctx_out(e.spill_base + ".ctx", ios::binary | ios::trunc);
+      afseal.save_context(ctx_out, none);
+      ok = ok && ctx_out.flush();
+      if (ok && e.has_public)
+      {
+        ofstream out(e.spill_base + ".pk", ios::binary | ios::trunc);
+        afseal.save_public_key(out, none);
+        ok = ok && out.flush();
+      }
+      if (ok && e.has_relin)
+      {
+        ofstream out(e.spill_base + ".rlk", ios::binary | ios::trunc);
+        afseal.save_relin_keys(out, none);
+        ok = ok && out.flush();
+      }
+      if (ok && e.has_rotate)
+      {
+        string rtk_path = e.spill_base + ".rtk";
+        afseal.save_rotate_keys_store(rtk_path);
+      }
+    }
+    catch (const exception &)
+    {
+      ok = false;
+    }
+    if (!ok)
+    {
+      remove_spill(e);
+    }
+    return ok;
+  }
+
+  // Evaluation-only Afseal from the spill files, mapping its rotation keys
+  static shared_ptr<Afseal> reload(const Entry &e)
+  {
+    auto afseal = make_shared<Afseal>();
+    afseal->set_eval_only(true);
+    ifstream ctx_in(e.spill_base + ".ctx", ios::binary);
+    afseal->load_context(ctx_in, e.sec);
+    if (e.has_public)
+    {
+      ifstream in(e.spill_base + ".pk", ios::binary);
+      afseal->load_public_key(in);
+    }
+    if (e.has_relin)
+    {
+      ifstream in(e.spill_base + ".rlk", ios::binary);
+      afseal->load_relin_keys(in);
+    }
+    if (e.has_rotate)
+    {
+      string rtk_path = e.spill_base + ".rtk";
+      afseal->load_rotate_keys_store(rtk_path);
+    }
+    return afseal;
+  }
+
+  static void remove_spill(const Entry &e)
+  {
+    for (const char *ext : {".ctx", ".pk", ".rlk", ".rtk"})
+    {
+      std::remove((e.spill_base + ext).c_str());
+    }
+  }
+};
+
+AfsealTenantRegistry::State &AfsealTenantRegistry::state()
+{
+  static State *s = new State();  // Never destroyed, like the task pool
+  return *s;
 }
 
-// SAVE/LOAD PLAINTEXT --> Could be achieved outside of Afseal
-size_t Afseal::save_plaintext(ostream &out_stream, string &compr_mode, AfPtxt &pt)
+void AfsealTenantRegistry::add(const string &tenant, const Afseal &afseal,
+                               double scale, const vector<int> &qi_sizes)
 {
-  return (size_t)_dyn_p(pt).save(out_stream, compr_mode_map[compr_mode]);
+  auto copy = make_shared<Afseal>(afseal);
+  copy->set_eval_only(true);
+  State::Entry entry;
+  entry.afseal = copy;
+  entry.bytes = copy->key_bytes();
+  entry.sec = copy->get_sec();
+  entry.scale = scale;
+  entry.qi_sizes = qi_sizes;
+  entry.has_public = !copy->is_publicKey_empty();
+  entry.has_relin = !copy->is_relinKeys_empty();
+  entry.has_rotate = !copy->is_rotKey_empty();
+  State &s = state();
+  unique_lock<mutex> lk(s.mtx);
+  auto it = s.entries.find(tenant);
+  if (it != s.entries.end() && !it->second.spill_base.empty())
+  {
+    State::remove_spill(it->second);
+  }
+  entry.last_use = ++s.clock;
+  s.entries[tenant] = entry;
+  s.evict(lk);
 }
-size_t Afseal::load_plaintext(istream &in_stream, AfPtxt &pt)
+
+shared_ptr<Afseal> AfsealTenantRegistry::get(const string &tenant)
 {
-  return (size_t)_dyn_p(pt).load(*context, in_stream);
+  double scale;
+  vector<int> qi_sizes;
+  return get(tenant, scale, qi_sizes);
 }
 
-// SAVE/LOAD CIPHERTEXT --> Could be achieved outside of Afseal
-size_t Afseal::save_ciphertext(ostream &out_stream, string &compr_mode, AfCtxt &ct)
+shared_ptr<Afseal> AfsealTenantRegistry::get(const string &tenant, double &scale,
+                                             vector<int> &qi_sizes)
 {
-  return (size_t)_dyn_c(ct).save(out_stream, compr_mode_map[compr_mode]);
+  State &s = state();
+  State::Entry spilled;
+  {
+    lock_guard<mutex> lk(s.mtx);
+    auto it = s.entries.find(tenant);
+    if (it == s.entries.end())
+    {
+      throw std::out_of_range("<Afseal>: Unknown tenant " + tenant);
+    }
+    State::Entry &e = it->second;
+    e.last_use = ++s.clock;
+    scale = e.scale;
+    qi_sizes = e.qi_sizes;
+    if (e.afseal)
+    {
+      s.hits++;
+      e.bytes = e.afseal->key_bytes();   // Rotation key stores grow with use
+      return e.afseal;
+    }
+    s.reloads++;
+    spilled = e;
+  }
+  // Reloaded without the lock. Concurrent reloads of a tenant may each
+  //  build one Afseal, and all of them get the first one stored.
+  auto afseal = State::reload(spilled);
+  unique_lock<mutex> lk(s.mtx);
+  auto it = s.entries.find(tenant);
+  if (it == s.entries.end())
+  {
+    throw std::out_of_range("<Afseal>: Unknown tenant " + tenant);
+  }
+  State::Entry &e = it->second;
+  if (!e.afseal)
+  {
+    e.afseal = afseal;
+    e.bytes = afseal->key_bytes();
+  }
+  afseal = e.afseal;   // Held, so not evicted right away
+  s.evict(lk);
+  return afseal;
 }
-size_t Afseal::load_ciphertext(istream &in_stream, AfCtxt &ct)
+
+void AfsealTenantRegistry::remove(const string &tenant)
 {
-  return (size_t)_dyn_c(ct).load(*context, in_stream);
+  State &s = state();
+  lock_guard<mutex> lk(s.mtx);
+  auto it = s.entries.find(tenant);
+  if (it != s.entries.end())
+  {
+    if (!it->second.spill_base.empty())
+    {
+      State::remove_spill(it->second);
+    }
+    s.entries.erase(it);
+  }
 }
 
-// SIZES
-size_t Afseal::sizeof_context(string &compr_mode){
-  return (size_t)this->get_context()->key_context_data()->parms().save_size(compr_mode_map[compr_mode]);
-}
-size_t Afseal::sizeof_public_key(string &compr_mode){
-  return (size_t)this->get_publicKey()->save_size(compr_mode_map[compr_mode]);
-}
-size_t Afseal::sizeof_secret_key(string &compr_mode){
-  return (size_t)this->get_secretKey()->save_size(compr_mode_map[compr_mode]);
-}
-size_t Afseal::sizeof_relin_keys(string &compr_mode){
-  return (size_t)this->get_relinKeys()->save_size(compr_mode_map[compr_mode]);
-}
-size_t Afseal::sizeof_rotate_keys(string &compr_mode){
-  return (size_t)this->get_rotateKeys()->save_size(compr_mode_map[compr_mode]);
-}
-size_t Afseal::sizeof_plaintext(string &compr_mode, AfPtxt &pt){
-  return (size_t)_dyn_p(pt).save_size(compr_mode_map[compr_mode]);
-}
-size_t Afseal::sizeof_ciphertext(string &compr_mode, AfCtxt &ct){
-  return (size_t)_dyn_c(ct).save_size(compr_mode_map[compr_mode]);
+void AfsealTenantRegistry::configure(size_t budget_bytes, const string &spill_dir)
+{
+  State &s = state();
+  unique_lock<mutex> lk(s.mtx);
+  s.budget = budget_bytes;
+  s.spill_dir = spill_dir;
+  s.evict(lk);
 }
 
+vector<uint64_t> AfsealTenantRegistry::stats()
+{
+  State &s = state();
+  lock_guard<mutex> lk(s.mtx);
+  uint64_t in_memory = 0, bytes = 0;
+  for (auto &it : s.entries)
+  {
+    in_memory += (it.second.afseal) ? 1 : 0;
+    bytes += (it.second.afseal) ? it.second.bytes : 0;
+  }
+  return {s.entries.size(), in_memory, bytes, s.budget, s.hits, s.reloads, s.evictions};
+}
 
 // -----------------------------------------------------------------------------
-// -------------------------------- AUXILIARY ----------------------------------
+// ----------------------------- GALOIS KEY STORE ------------------------------
 // -----------------------------------------------------------------------------
-bool Afseal::batchEnabled()
+namespace
 {
-  return this->get_context()->first_context_data()->qualifiers().using_batching;
-}
-long Afseal::maxBitCount(long poly_modulus_degree, int sec_level)
+// Store layout: magic, key parms_id, number of keys, one _StoreEntry per key,
+//  then the keys uncompressed. Each key starts at a page boundary, so loading
+//  one reads only its own pages.
+const char _store_magic[8] = {'A', 'F', 'G', 'K', 'S', 'v', '0', '1'};
+const uint64_t _store_align = 4096;
+struct _StoreEntry
 {
-  return CoeffModulus::MaxBitCount(poly_modulus_degree, sec_map[sec_level]);
-}
-double Afseal::scale(AfCtxt &ctxt)
+  uint32_t galois_elt;
+  uint32_t n_parts;   // PublicKeys in the key, one per decomposed prime
+  uint64_t offset;
+  uint64_t size;
+};
+const size_t _store_header = sizeof(_store_magic) + sizeof(parms_id_type) + sizeof(uint64_t);
+}  // namespace
+
+size_t AfsealGaloisKeyStore::save(const GaloisKeys &keys, const string &filename)
 {
-  return _dyn_c(ctxt).scale();
+  vector<_StoreEntry> entries;
+  for (size_t i = 0; i < keys.data().size(); i++)
+  {
+    if (!keys.data()[i].empty())
+    {
+      entries.push_back({static_cast<uint32_t>(2 * i + 1),
+                         static_cast<uint32_t>(keys.data()[i].size()), 0, 0});
+    }
+  }
+  ofstream out(filename, ios::binary | ios::trunc);
+  if (!out)
+  {
+    throw std::invalid_argument("<Afseal>: Cannot open rotation key store " + filename);
+  }
+  // Index first as a placeholder, rewritten once the offsets are known
+  uint64_t n = entries.size();
+  uint64_t pos = _store_header + n * sizeof(_StoreEntry);
+  vector<char> zeros(pos > _store_align ? pos : _store_align, 0);
+  out.write(zeros.data(), pos);
+  for (_StoreEntry &e : entries)
+  {
+    uint64_t pad = (_store_align - pos % _store_align) % _store_align;
+    out.write(zeros.data(), pad);
+    e.offset = pos + pad;
+    pos = e.offset;
+    for (const PublicKey &part : keys.data()[GaloisKeys::get_index(e.galois_elt)])
+    {
+      pos += part.save(out, compr_mode_type::none);
+    }
+    e.size = pos - e.offset;
+  }
+  out.seekp(0);
+  out.write(_store_magic, sizeof(_store_magic));
+  out.write(reinterpret_cast<const char *>(keys.parms_id().data()), sizeof(parms_id_type));
+  out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+  out.write(reinterpret_cast<const char *>(entries.data()), n * sizeof(_StoreEntry));
+  if (!out)
+  {
+    throw std::runtime_error("<Afseal>: Failed writing rotation key store " + filename);
+  }
+  return pos;
 }
-void Afseal::override_scale(AfCtxt &ctxt, double scale)
+
+AfsealGaloisKeyStore::AfsealGaloisKeyStore(const string &filename, shared_ptr<SEALContext> context)
+    : context(context), loaded_keys(make_shared<GaloisKeys>())
 {
-  _dyn_c(ctxt).scale() = scale;
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER size;
+  if (file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &size) && size.QuadPart > 0)
+  {
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping != NULL)
+    {
+      data = static_cast<const seal_byte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      data_size = static_cast<size_t>(size.QuadPart);
+    }
+  }
+  if (file != INVALID_HANDLE_VALUE) { CloseHandle(file); }
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+  {
+    void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED)
+    {
+      data = static_cast<const seal_byte *>(p);
+      data_size = static_cast<size_t>(st.st_size);
+    }
+  }
+  if (fd >= 0) { close(fd); }
+#endif
+  if (data == nullptr)
+  {
+    unmap();
+    throw std::invalid_argument("<Afseal>: Cannot map rotation key store " + filename);
+  }
+  try
+  {
+    read_index();
+  }
+  catch (...)
+  {
+    unmap();
+    throw;
+  }
 }
-int Afseal::get_sec()
+
+AfsealGaloisKeyStore::~AfsealGaloisKeyStore() { unmap(); }
+
+void AfsealGaloisKeyStore::unmap()
 {
-  return static_cast<std::underlying_type<sec_level_type>::type>(
-      this->get_context()->first_context_data()->qualifiers().sec_level);
-}
-std::vector<uint64_t> Afseal::get_qi()
-{ 
-  return this->qi;
+#ifdef _WIN32
+  if (data) { UnmapViewOfFile(data); }
+  if (mapping) { CloseHandle(mapping); }
+#else
+  if (data) { munmap(const_cast<seal_byte *>(data), data_size); }
+#endif
+  data = nullptr;
+  mapping = nullptr;
 }
-// GETTERS
-shared_ptr<SEALContext> inline Afseal::get_context()
+
+void AfsealGaloisKeyStore::read_index()
 {
-  if (this->context == NULL)
+  if (data_size < _store_header || memcmp(data, _store_magic, sizeof(_store_magic)) != 0)
   {
-    throw std::logic_error("<Afseal>: Context not initialized");
+    throw std::invalid_argument("<Afseal>: Not a rotation key store");
   }
-  return (this->context);
-}
-shared_ptr<Evaluator> inline Afseal::get_evaluator()
-{
-  if (this->evaluator == NULL)
+  parms_id_type parms_id;
+  uint64_t n;
+  memcpy(&parms_id, data + sizeof(_store_magic), sizeof(parms_id));
+  memcpy(&n, data + sizeof(_store_magic) + sizeof(parms_id), sizeof(n));
+  if (parms_id != context->key_parms_id())
   {
-    throw std::logic_error("<Afseal>: Context not initialized");
+    throw std::invalid_argument("<Afseal>: Rotation key store of a different context");
+  }
+  if (n > (data_size - _store_header) / sizeof(_StoreEntry))
+  {
+    throw std::invalid_argument("<Afseal>: Truncated rotation key store");
+  }
+  size_t n_indices = 0;
+  for (uint64_t i = 0; i < n; i++)
+  {
+    _StoreEntry e;
+    memcpy(&e, data + _store_header + i * sizeof(_StoreEntry), sizeof(e));
+    if (e.galois_elt % 2 == 0 || e.offset > data_size || e.size > data_size - e.offset)
+    {
+      throw std::invalid_argument("<Afseal>: Corrupted rotation key store");
+    }
+    index[e.galois_elt] = {e.offset, e.size, e.n_parts};
+    n_indices = std::max(n_indices, GaloisKeys::get_index(e.galois_elt) + 1);
   }
-  return (this->evaluator);
+  // Sized once, so loading a key never moves the others
+  loaded_keys->parms_id() = parms_id;
+  loaded_keys->data().resize(n_indices);
 }
-shared_ptr<Encryptor> inline Afseal::get_encryptor()
+
+void AfsealGaloisKeyStore::load(uint32_t galois_elt)
 {
-  if (this->encryptor == NULL)
+  auto it = index.find(galois_elt);
+  if (it == index.end() || loaded_keys->has_key(galois_elt))
+  {
+    return;
+  }
+  const Entry &e = it->second;
+  vector<PublicKey> key(e.n_parts);
+  size_t pos = e.offset, end = e.offset + e.size;
+  for (PublicKey &part : key)
   {
-    throw std::logic_error("<Afseal>: Missing Public key");
+    pos += static_cast<size_t>(part.load(*context, data + pos, end - pos));
   }
-  return (this->encryptor);
+  loaded_keys->data()[GaloisKeys::get_index(galois_elt)] = std::move(key);
 }
-shared_ptr<Decryptor> inline Afseal::get_decryptor()
+
+shared_lock<shared_mutex> AfsealGaloisKeyStore::use(uint32_t galois_elt)
 {
-  if (this->encryptor == NULL)
   {
-    throw std::logic_error("<Afseal>: Missing Public key");
+    shared_lock<shared_mutex> lk(mtx);
+    if (!contains(galois_elt) || loaded_keys->has_key(galois_elt))
+    {
+      return lk;
+    }
+  }
+  {
+    unique_lock<shared_mutex> lk(mtx);
+    load(galois_elt);
   }
-  return (this->decryptor);
+  return shared_lock<shared_mutex>(mtx);
 }
-shared_ptr<BatchEncoder> inline Afseal::get_bfv_encoder()
+
+void AfsealGaloisKeyStore::load_all()
 {
-  if (this->bfvEncoder == NULL)
+  unique_lock<shared_mutex> lk(mtx);
+  for (const auto &it : index)
   {
-    throw std::logic_error("<Afseal>: BFV context not initialized");
+    load(it.first);
   }
-  return (this->bfvEncoder);
 }
-shared_ptr<CKKSEncoder> inline Afseal::get_ckks_encoder()
+
+size_t AfsealGaloisKeyStore::n_loaded()
 {
-  if (this->ckksEncoder == NULL)
+  shared_lock<shared_mutex> lk(mtx);
+  size_t n = 0;
+  for (const auto &it : index)
   {
-    throw std::logic_error("<Afseal>: CKKS context not initialized");
+    n += loaded_keys->has_key(it.first) ? 1 : 0;
   }
-  return (this->ckksEncoder);
+  return n;
 }
-shared_ptr<BatchEncoder> inline Afseal::get_bgv_encoder()
+
+// -----------------------------------------------------------------------------
+// ----------------------------- CIPHERTEXT FILES ------------------------------
+// -----------------------------------------------------------------------------
+namespace
 {
-    if (this->bgvEncoder == NULL)
-        {
-        throw std::logic_error("<Afseal>: BGV context not initialized");
-        }
-    return (this->bgvEncoder);
+// File layout: magic, key parms_id, compression mode (as uint64_t), then one
+//  record per ciphertext: its size (uint64_t) and the SEAL ciphertext. Closing
+//  the file appends the offset of each record, their number, the offset of
+//  this index and the index magic.
+const char _ctxt_file_magic[8] = {'A', 'F', 'C', 'F', 'v', '0', '0', '1'};
+const char _ctxt_index_magic[8] = {'A', 'F', 'C', 'F', 'i', 'd', 'x', '1'};
+const uint64_t _ctxt_file_header = sizeof(_ctxt_file_magic) + sizeof(parms_id_type) + sizeof(uint64_t);
+const uint64_t _ctxt_file_footer = 2 * sizeof(uint64_t) + sizeof(_ctxt_index_magic);
+const uint64_t _ctxt_chunk_bytes = 64 << 20;   // Read at once by batch reads
+
+struct _CtxtFileIndex
+{
+  vector<uint64_t> offsets;
+  uint64_t data_end = _ctxt_file_header;
+  compr_mode_type compr = compr_mode_type::none;
+};
+
+template <class T>
+bool _read_pod(istream &in, T &value)
+{
+  return (bool)in.read(reinterpret_cast<char *>(&value), sizeof(T));
 }
-shared_ptr<SecretKey> inline Afseal::get_secretKey()
+
+// Reads the header and index of a ciphertext file. Without an index, records
+//  are scanned from the header on, dropping a truncated last one.
+_CtxtFileIndex _read_ctxt_index(istream &in, const parms_id_type &key_parms_id)
 {
-  if (this->secretKey == NULL)
+  in.seekg(0, ios::end);
+  uint64_t file_size = static_cast<uint64_t>(in.tellg());
+  in.seekg(0);
+  char magic[8];
+  parms_id_type parms_id;
+  uint64_t compr;
+  if (!in.read(magic, sizeof(magic)) || !_read_pod(in, parms_id) || !_read_pod(in, compr) ||
+      memcmp(magic, _ctxt_file_magic, sizeof(magic)) != 0)
   {
-    throw std::logic_error("<Afseal>: Secret Key not initialized");
+    throw std::invalid_argument("<Afseal>: Not a ciphertext file");
   }
-  return (this->secretKey);
-}
-shared_ptr<PublicKey> inline Afseal::get_publicKey()
-{
-  if (this->publicKey == NULL)
+  if (parms_id != key_parms_id)
   {
-    throw std::logic_error("<Afseal>: Public Key not initialized");
+    throw std::invalid_argument("<Afseal>: Ciphertext file of a different context");
   }
-  return (this->publicKey);
-}
-shared_ptr<RelinKeys> inline Afseal::get_relinKeys()
-{
-  if (this->relinKeys == NULL)
+  _CtxtFileIndex index;
+  index.compr = static_cast<compr_mode_type>(compr);
+  uint64_t n = 0, index_offset = 0;
+  if (file_size >= _ctxt_file_header + _ctxt_file_footer)
   {
-    throw std::logic_error("<Afseal>: Relinearization Keys not initialized");
+    in.seekg(file_size - _ctxt_file_footer);
+    if (_read_pod(in, n) && _read_pod(in, index_offset) && in.read(magic, sizeof(magic)) &&
+        memcmp(magic, _ctxt_index_magic, sizeof(magic)) == 0)
+    {
+      if (index_offset < _ctxt_file_header ||
+          index_offset + n * sizeof(uint64_t) + _ctxt_file_footer != file_size)
+      {
+        throw std::invalid_argument("<Afseal>: Corrupted ciphertext file index");
+      }
+      index.offsets.resize(n);
+      in.seekg(index_offset);
+      in.read(reinterpret_cast<char *>(index.offsets.data()), n * sizeof(uint64_t));
+      for (uint64_t i = 0; i < n; i++)
+      {
+        uint64_t lower = (i) ? index.offsets[i - 1] + sizeof(uint64_t) : _ctxt_file_header;
+        if (index.offsets[i] < lower || index.offsets[i] + sizeof(uint64_t) > index_offset)
+        {
+          throw std::invalid_argument("<Afseal>: Corrupted ciphertext file index");
+        }
+      }
+      index.data_end = index_offset;
+      return index;
+    }
   }
-  return (this->relinKeys);
-}
-shared_ptr<GaloisKeys> inline Afseal::get_rotateKeys()
-{
-  if (this->rotateKeys == NULL)
+  in.clear();
+  uint64_t pos = _ctxt_file_header, len;
+  while (pos + sizeof(uint64_t) <= file_size)
   {
-    throw std::logic_error("<Afseal>: Rotation Keys not initialized");
+    in.seekg(pos);
+    if (!_read_pod(in, len) || len == 0 || len > file_size - pos - sizeof(uint64_t))
+    {
+      break;
+    }
+    index.offsets.push_back(pos);
+    pos += sizeof(uint64_t) + len;
   }
-  return (this->rotateKeys);
+  index.data_end = pos;
+  return index;
 }
-size_t Afseal::get_nSlots()
+} // namespace
+
+AfsealCtxtFileWriter::AfsealCtxtFileWriter(const string &filename, Afseal &afseal,
+                                           const string &compr_mode, bool append)
+    : afseal(afseal), compr_mode(compr_mode)
 {
-  scheme_t scheme = this->get_scheme();
-  if (scheme == scheme_t::bfv)
+  ifstream existing(filename, ios::binary);
+  if (append && existing)
   {
-    return this->get_bfv_encoder()->slot_count();
+    _CtxtFileIndex index = _read_ctxt_index(existing, afseal.get_context()->key_parms_id());
+    existing.close();
+    auto mode = std::find_if(compr_mode_map.begin(), compr_mode_map.end(),
+                             [&](const auto &m) { return m.second == index.compr; });
+    if (mode == compr_mode_map.end())
+    {
+      throw std::invalid_argument("<Afseal>: Unsupported compression mode in " + filename);
+    }
+    this->compr_mode = mode->first;
+    offsets = std::move(index.offsets);
+    end = index.data_end;
+    // Records are appended over the index, written again on close
+    std::filesystem::resize_file(filename, end);
+    file.open(filename, ios::binary | ios::in | ios::out);
+    file.seekp(end);
   }
-  else if (scheme == scheme_t::ckks)
+  else
   {
-    return this->get_ckks_encoder()->slot_count();
+    existing.close();
+    if (compr_mode_map.count(compr_mode) == 0)
+    {
+      throw std::invalid_argument("<Afseal>: Unsupported compression mode " + compr_mode);
+    }
+    uint64_t compr = static_cast<uint64_t>(compr_mode_map[compr_mode]);
+    file.open(filename, ios::binary | ios::out | ios::trunc);
+    file.write(_ctxt_file_magic, sizeof(_ctxt_file_magic));
+    file.write(reinterpret_cast<const char *>(afseal.get_context()->key_parms_id().data()),
+               sizeof(parms_id_type));
+    file.write(reinterpret_cast<const char *>(&compr), sizeof(compr));
+    end = _ctxt_file_header;
   }
-  else if (scheme == scheme_t::bgv)
+  if (!file)
   {
-    return this->get_bgv_encoder()->slot_count();
+    throw std::invalid_argument("<Afseal>: Cannot open ciphertext file " + filename);
   }
-  return -1;
 }
-uint64_t Afseal::get_plain_modulus()
+
+AfsealCtxtFileWriter::~AfsealCtxtFileWriter()
 {
-  return this->get_context()->first_context_data()->parms().plain_modulus().value();
+  try
+  {
+    close();
+  }
+  catch (...)
+  {
+  }
 }
-size_t Afseal::get_poly_modulus_degree()
+
+vector<uint8_t> AfsealCtxtFileWriter::record(AfCtxt &ctxt)
 {
-  return this->get_context()->first_context_data()->parms().poly_modulus_degree();
+  uint64_t size = afseal.sizeof_ciphertext(compr_mode, ctxt);
+  vector<uint8_t> rec(sizeof(uint64_t) + size);
+  size = afseal.save_ciphertext(rec.data() + sizeof(uint64_t), size, compr_mode, ctxt);
+  memcpy(rec.data(), &size, sizeof(size));
+  rec.resize(sizeof(uint64_t) + size);
+  return rec;
 }
 
-scheme_t Afseal::get_scheme()
+void AfsealCtxtFileWriter::write(const vector<uint8_t> &rec)
 {
-  return scheme_map_to_afhel[this->get_context()->first_context_data()->parms().scheme()];
+  if (closed)
+  {
+    throw std::logic_error("<Afseal>: Ciphertext file already closed");
+  }
+  file.write(reinterpret_cast<const char *>(rec.data()), rec.size());
+  if (!file)
+  {
+    throw std::runtime_error("<Afseal>: Failed writing ciphertext file");
+  }
+  offsets.push_back(end);
+  end += rec.size();
 }
 
-int Afseal::total_coeff_modulus_bit_count()
+void AfsealCtxtFileWriter::append(AfCtxt &ctxt)
 {
-  return this->get_context()->first_context_data()->total_coeff_modulus_bit_count();
+  write(record(ctxt));
 }
-// TODO: coeff_modulus?
 
-// -----------------------------------------------------------------------------
-// ----------------------------- VECTORIZATION ---------------------------------
-// -----------------------------------------------------------------------------
-void Afseal::vectorize(
-    vector<std::shared_ptr<AfCtxt>> &ctxtVInOut,
-    vector<std::shared_ptr<AfCtxt>> &ctxtV2,
-    function<void(AfCtxt, AfCtxt)> f)
+void AfsealCtxtFileWriter::append(vector<shared_ptr<AfCtxt>> &ctxts)
 {
-  if (ctxtVInOut.size() != ctxtV2.size())
+  // Serialized a few per thread at a time, bounding the memory in flight
+  AfsealTaskPool &pool = AfsealTaskPool::instance();
+  size_t batch = 4 * pool.num_threads();
+  vector<vector<uint8_t>> recs;
+  for (size_t first = 0; first < ctxts.size(); first += batch)
   {
-    throw runtime_error("Vectors must be of same size to vectorize");
+    recs.assign(std::min(batch, ctxts.size() - first), {});
+    pool.parallel_for(recs.size(), [&](size_t i)
+                      { recs[i] = record(*ctxts[first + i]); });
+    for (const vector<uint8_t> &rec : recs)
+    {
+      write(rec);
+    }
   }
-#pragma omp parallel for
-  for (int i = 0; i < (int)ctxtVInOut.size(); i++)
+}
+
+void AfsealCtxtFileWriter::close()
+{
+  if (closed)
+  {
+    return;
+  }
+  closed = true;
+  uint64_t n = offsets.size();
+  file.write(reinterpret_cast<const char *>(offsets.data()), n * sizeof(uint64_t));
+  file.write(reinterpret_cast<const char *>(&n), sizeof(n));
+  file.write(reinterpret_cast<const char *>(&end), sizeof(end));
+  file.write(_ctxt_index_magic, sizeof(_ctxt_index_magic));
+  file.close();
+  if (!file)
   {
-    f(_dyn_c(*ctxtVInOut[i]), _dyn_c(*ctxtV2[i]));
+    throw std::runtime_error("<Afseal>: Failed writing ciphertext file index");
   }
 }
-void Afseal::vectorize(
-    vector<std::shared_ptr<AfCtxt>> &ctxtVInOut,
-    vector<std::shared_ptr<AfPtxt>> &ptxtV,
-    function<void(AfCtxt, AfPtxt)> f)
+
+AfsealCtxtFileReader::AfsealCtxtFileReader(const string &filename, Afseal &afseal)
+    : afseal(afseal), file(filename, ios::binary)
 {
-  if (ctxtVInOut.size() != ptxtV.size())
+  if (!file)
   {
-    throw runtime_error("Vectors must be of same size to vectorize");
+    throw std::invalid_argument("<Afseal>: Cannot open ciphertext file " + filename);
   }
-#pragma omp parallel for
-  for (int i = 0; i < (int)ctxtVInOut.size(); i++)
+  _CtxtFileIndex index = _read_ctxt_index(file, afseal.get_context()->key_parms_id());
+  offsets = std::move(index.offsets);
+  data_end = index.data_end;
+  compr = index.compr;
+}
+
+string AfsealCtxtFileReader::compr_mode() const
+{
+  for (const auto &m : compr_mode_map)
   {
-    f(_dyn_c(*ctxtVInOut[i]), _dyn_p(*ptxtV[i]));
+    if (m.second == compr)
+    {
+      return m.first;
+    }
   }
+  return "unknown";
 }
 
-void Afseal::vectorize(
-    vector<std::shared_ptr<AfCtxt>> &ctxtVInOut,
-    function<void(AfCtxt)> f)
+vector<uint8_t> AfsealCtxtFileReader::read_records(size_t begin, size_t end)
 {
-#pragma omp parallel for
-  for (int i = 0; i < (int)ctxtVInOut.size(); i++)
+  vector<uint8_t> chunk(record_end(end - 1) - offsets[begin]);
+  lock_guard<mutex> lk(mtx);
+  file.clear();
+  file.seekg(offsets[begin]);
+  if (!file.read(reinterpret_cast<char *>(chunk.data()), chunk.size()))
   {
-    f(_dyn_c(*ctxtVInOut[i]));
+    throw std::runtime_error("<Afseal>: Failed reading ciphertext file");
   }
+  return chunk;
 }
 
-void Afseal::vectorize(
-    vector<std::shared_ptr<AfPtxt>> &plainVInOut,
-    function<void(AfPtxt)> f)
+void AfsealCtxtFileReader::decode(const vector<uint8_t> &chunk, size_t first, size_t i, AfCtxt &ctxtOut)
 {
-#pragma omp parallel for
-  for (int i = 0; i < (int)plainVInOut.size(); i++)
+  const uint8_t *rec = chunk.data() + (offsets[i] - offsets[first]);
+  uint64_t len;
+  memcpy(&len, rec, sizeof(len));
+  if (len != record_end(i) - offsets[i] - sizeof(uint64_t))
+  {
+    throw std::invalid_argument("<Afseal>: Corrupted ciphertext file record");
+  }
+  afseal.load_ciphertext(rec + sizeof(uint64_t), len, ctxtOut);
+}
+
+void AfsealCtxtFileReader::read(size_t i, AfCtxt &ctxtOut)
+{
+  if (i >= offsets.size())
+  {
+    throw std::out_of_range("<Afseal>: Ciphertext index out of range of the file");
+  }
+  decode(read_records(i, i + 1), i, i, ctxtOut);
+}
+
+void AfsealCtxtFileReader::read(size_t begin, vector<shared_ptr<AfCtxt>> &ctxtVOut)
+{
+  size_t end = begin + ctxtVOut.size();
+  if (begin > end || end > offsets.size())
   {
-    f(_dyn_p(*plainVInOut[i]));
+    throw std::out_of_range("<Afseal>: Ciphertext range out of range of the file");
+  }
+  // Records read in chunks of up to _ctxt_chunk_bytes, each decoded in parallel
+  for (size_t first = begin, last; first < end; first = last)
+  {
+    last = first + 1;
+    while (last < end && record_end(last) - offsets[first] <= _ctxt_chunk_bytes)
+    {
+      last++;
+    }
+    vector<uint8_t> chunk = read_records(first, last);
+    AfsealTaskPool::instance().parallel_for(last - first, [&](size_t k)
+      { decode(chunk, first, first + k, *ctxtVOut[first - begin + k]); });
   }
 }
 
@@ -978,30 +4472,30 @@ AfsealPoly Afseal::get_secretKey_poly()
 
 // ----------------------------- CLASS MANAGEMENT -----------------------------
 
-AfsealPoly::AfsealPoly(Afseal &afseal) : parms_id(afseal.context->first_parms_id()),
-                                         mempool(seal::MemoryManager::GetPool()),
-                                         coeff_count(afseal.context->first_context_data()->parms().poly_modulus_degree()),
-                                         coeff_modulus(afseal.context->first_context_data()->parms().coeff_modulus()),
-                                         coeff_modulus_count(afseal.context->first_context_data()->parms().coeff_modulus().size())
+AfsealPoly::AfsealPoly(Afseal &afseal) : parms_id(afseal.get_context()->first_parms_id()),
+                                         mempool(_pool()),
+                                         coeff_count(afseal.get_context()->first_context_data()->parms().poly_modulus_degree()),
+                                         coeff_modulus(afseal.get_context()->first_context_data()->parms().coeff_modulus()),
+                                         coeff_modulus_count(afseal.get_context()->first_context_data()->parms().coeff_modulus().size())
 {
   eval_repr.resize(coeff_count * coeff_modulus_count, true);
 }
 
 AfsealPoly::AfsealPoly(Afseal &afseal, const AfsealCtxt &ref)
-    : parms_id(ref.parms_id()), mempool(seal::MemoryManager::GetPool()),
+    : parms_id(ref.parms_id()), mempool(_pool()),
       coeff_count(ref.poly_modulus_degree()),
-      coeff_modulus(afseal.context->get_context_data(parms_id)->parms().coeff_modulus()),
-      coeff_modulus_count(afseal.context->get_context_data(parms_id)->parms().coeff_modulus().size())
+      coeff_modulus(afseal.get_context()->get_context_data(parms_id)->parms().coeff_modulus()),
+      coeff_modulus_count(afseal.get_context()->get_context_data(parms_id)->parms().coeff_modulus().size())
 {
 
   eval_repr.resize(coeff_count * coeff_modulus_count, true);
 }
 
 AfsealPoly::AfsealPoly(Afseal &afseal, AfsealCtxt &ctxt, size_t index)
-    : parms_id(ctxt.parms_id()), mempool(seal::MemoryManager::GetPool()),
+    : parms_id(ctxt.parms_id()), mempool(_pool()),
       coeff_count(ctxt.poly_modulus_degree()),
-      coeff_modulus(afseal.context->get_context_data(parms_id)->parms().coeff_modulus()),
-      coeff_modulus_count(afseal.context->get_context_data(parms_id)->parms().coeff_modulus().size())
+      coeff_modulus(afseal.get_context()->get_context_data(parms_id)->parms().coeff_modulus()),
+      coeff_modulus_count(afseal.get_context()->get_context_data(parms_id)->parms().coeff_modulus().size())
 {
 
   // Copy coefficients from ctxt
@@ -1021,12 +4515,12 @@ AfsealPoly::AfsealPoly(Afseal &afseal, AfsealCtxt &ctxt, size_t index)
 }
 
 AfsealPoly::AfsealPoly(Afseal &afseal, AfsealPtxt &ptxt) : parms_id(ptxt.parms_id()),
-                                                           mempool(seal::MemoryManager::GetPool()),
+                                                           mempool(_pool()),
                                                            coeff_count(ptxt.coeff_count()),
-                                                           coeff_modulus(afseal.context->get_context_data(parms_id)
+                                                           coeff_modulus(afseal.get_context()->get_context_data(parms_id)
                                                                              ->parms()
                                                                              .coeff_modulus()),
-                                                           coeff_modulus_count(afseal.context
+                                                           coeff_modulus_count(afseal.get_context()
                                                                                    ->get_context_data(parms_id)
                                                                                    ->parms()
                                                                                    .coeff_modulus()
@@ -1062,7 +4556,7 @@ void AfsealPoly::generate_coeff_repr(Afseal &afseal)
     coeff_repr = eval_repr;
 
     // Now do the actual conversion
-    auto small_ntt_tables = afseal.context->get_context_data(parms_id)->small_ntt_tables();
+    auto small_ntt_tables = afseal.get_context()->get_context_data(parms_id)->small_ntt_tables();
 #pragma omp parallel for
     for (int j = 0; j < coeff_modulus_count; j++)
     {
@@ -42,6 +42,13 @@
 #include <fstream>      /* file management */
 #include <assert.h>     /* assert */
 #include <map>          /* map */
+#include <deque>        /* task pool queues */
+#include <atomic>       /* task pool counters */
+#include <mutex>        /* task pool locks */
+#include <shared_mutex> /* rotation key store */
+#include <functional>   /* std::function */
+#include <condition_variable> /* task pool sleep/wake */
+#include <chrono>       /* operation statistics */
 
 #include "Afhel.h"
 #include "seal/dynarray.h"
@@ -131,10 +138,10 @@ class AfsealPoly: public AfPoly {
   seal::MemoryPoolHandle mempool;
 
   /// The last generated coeff_representation
-  seal::DynArray<uint64_t> coeff_repr;
+  seal::DynArray<uint64_t> coeff_repr{mempool};
 
   /// The underlying ponomial
-  seal::DynArray<uint64_t> eval_repr;
+  seal::DynArray<uint64_t> eval_repr{mempool};
 
   /// True iff the last generated coeff_representaton is still valid
   /// (no operations were performed since the last generation)
@@ -225,6 +232,320 @@ class AfsealPoly: public AfPoly {
 };
 
 
+// =============================================================================
+// ================================ TASK ENGINE ================================
+// =============================================================================
+/// Persistent work-stealing thread pool running all the vectorized operations.
+///
+/// Every worker owns a queue of index ranges. Workers consume their own ranges
+/// one index at a time from the front, while idle workers steal the upper half
+/// of a range from the back of another queue. Work is thus split lazily, and
+/// chunk sizes adapt to the actual cost of each operation (e.g., a relinearize
+/// costs orders of magnitude more than an addition). The thread calling
+/// parallel_for also takes part in the work until its job is completed.
+class AfsealTaskPool {
+ public:
+  /// Process-wide pool, created on first use with AFSEAL_NUM_THREADS threads
+  /// (defaults to std::thread::hardware_concurrency()).
+  static AfsealTaskPool &instance();
+
+  /// Creates a pool with n_threads-1 workers (the caller is the n-th thread).
+  explicit AfsealTaskPool(size_t n_threads);
+  ~AfsealTaskPool();
+  AfsealTaskPool(const AfsealTaskPool &) = delete;
+  AfsealTaskPool &operator=(const AfsealTaskPool &) = delete;
+
+  /// Runs f(i) for every i in [0, n), returning once all calls have finished.
+  /// The first exception thrown by f is rethrown in the calling thread.
+  /// \param n number of tasks
+  /// \param f task body, called concurrently from several threads
+  void parallel_for(size_t n, const function<void(size_t)> &f);
+
+  /// Number of threads taking part in a parallel_for (workers + caller)
+  size_t num_threads() const { return workers.size() + 1; }
+
+ private:
+  struct Job;
+  struct Range { Job *job; size_t begin; size_t end; };
+  struct Queue { mutex mtx; deque<Range> ranges; };
+
+  vector<thread> workers;
+  vector<unique_ptr<Queue>> queues;   /**< One queue per worker. */
+  atomic<size_t> queued{0};           /**< Indexes waiting in the queues. */
+  mutex idle_mtx;
+  condition_variable idle_cv;
+  bool stop = false;
+
+  void worker_loop(size_t id);
+  bool pop_front(size_t q, Range &task);
+  bool steal(size_t thief, Range &task, bool whole_half);
+  void run(const Range &task);
+};
+
+
+// =============================================================================
+// ================================ MEMORY POOLS ===============================
+// =============================================================================
+/// Thread-local SEAL memory pools for the temporaries of all Afseal operations.
+///
+/// By default SEAL allocates every temporary from the global pool, whose mutex
+/// serializes the threads of a parallel batch. Instead, each thread gets its
+/// own pool on first use, and every evaluator, encoder and encryptor call goes
+/// through the pool of the calling thread. Pools never release memory, so the
+/// bytes allocated by a pool are its high-water mark.
+class AfsealMemoryPools {
+ public:
+  /// Pool of the calling thread, created on first use
+  static const seal::MemoryPoolHandle &local();
+
+  /// High-water mark (bytes) of the pool of each live thread that used one
+  static vector<size_t> high_water();
+
+  /// Largest high-water mark (bytes) among the pools of exited threads
+  static size_t retired_high_water();
+
+ private:
+  struct Slot;
+};
+
+
+// =============================================================================
+// ================================== TRACING ==================================
+// =============================================================================
+/// Timeline of the Afseal operations of every thread, written as Chrome trace
+/// JSON (chrome://tracing, ui.perfetto.dev).
+///
+/// Each thread appends its events to its own ring buffer without locks, which
+/// keeps the last `capacity` events once full. An event spans one operation
+/// (or one element of a vectorized batch, run by a task pool thread) and holds
+/// the level and size of the ciphertext it worked on.
+class AfsealTracer {
+ public:
+  static bool enabled() { return on.load(std::memory_order_relaxed); }
+
+  /// Drops the previous events and starts tracing.
+  /// \param capacity events kept per thread
+  static void start(size_t capacity = 1 << 16);
+
+  /// Stops tracing and writes the events of all threads to a JSON file.
+  /// \param path output file, overwritten
+  /// \return number of events written
+  static size_t stop(const string &path);
+
+  /// Traces its own lifetime on the calling thread, if enabled when created.
+  class Span {
+   public:
+    explicit Span(const char *op, long arg = 0, bool with_arg = false);
+    /// Element of a batch run on behalf of `parent` (from another thread)
+    explicit Span(const Span *parent);
+    ~Span();
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+    /// Reports the level (primes left) and size of `c` when the span ends
+    void ctxt(const Ciphertext &c) { if (active) { target = &c; } }
+    bool traced() const { return active; }
+    /// Innermost active span of the calling thread, or nullptr
+    static const Span *current();
+
+   private:
+    const char *op;
+    long arg;
+    bool with_arg, task, active;
+    const Ciphertext *target = nullptr;
+    const Span *prev = nullptr;
+    uint64_t begin_ns = 0;
+    void open();
+  };
+
+ private:
+  static atomic<bool> on;
+};
+
+
+// =============================================================================
+// ================================= STATISTICS ================================
+// =============================================================================
+/// Process-wide call counts and latencies of the Afseal operations.
+///
+/// Disabled by default (AFSEAL_STATS=1 enables them at startup): a disabled
+/// operation only pays for one relaxed atomic load. Each thread records into
+/// its own shard, merged on snapshot, so threads never contend. Latencies go
+/// to log-scale histograms (4 buckets per power of two), from which the
+/// percentiles are estimated within 10%. Vectorized operations (`*_v`) count
+/// one call per batch.
+class AfsealStats {
+ public:
+  static bool enabled() { return on.load(std::memory_order_relaxed); }
+  static void set_enabled(bool enabled);
+
+  /// Clears all the recorded operations
+  static void reset();
+
+  /// Per operation: {calls, total ns, bytes serialized, pool bytes allocated,
+  /// p50 ns, p90 ns, p99 ns, max ns}
+  static map<string, vector<double>> snapshot();
+
+  /// Times its own lifetime as one call of `op` (`op[arg]` with an argument,
+  /// e.g. the step of a rotation), if enabled when created. Also traced as a
+  /// span of AfsealTracer.
+  class Scope {
+   public:
+    explicit Scope(const char *op, long arg = 0, bool with_arg = false);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    /// Adds n to the bytes serialized by the operation, returning n
+    size_t bytes(size_t n) { n_bytes += n; return n; }
+    /// Ciphertext reported in the trace of the operation
+    void ctxt(AfCtxt &c);
+
+   private:
+    AfsealTracer::Span span;
+    const char *op;
+    long arg;
+    bool with_arg, active;
+    size_t n_bytes = 0, pool_bytes = 0;
+    chrono::steady_clock::time_point start;
+  };
+
+ private:
+  static atomic<bool> on;
+  static void record(const string &op, uint64_t ns, uint64_t bytes, uint64_t pool_bytes);
+};
+
+
+// =============================================================================
+// ============================== GALOIS KEY STORE =============================
+// =============================================================================
+/// Rotation keys in a file indexed by Galois element, loaded lazily.
+///
+/// The file is memory-mapped read-only, so processes opening the same store
+/// share its pages through the page cache, and only the keys of the rotations
+/// actually performed are ever read. A key is decoded into keys() on first
+/// use and kept. Rotations read keys() under a shared lock from use(), while
+/// loading a key takes the lock exclusively.
+class AfsealGaloisKeyStore {
+ public:
+  /// Writes every key in `keys` to `filename`, uncompressed. Returns the bytes
+  static size_t save(const seal::GaloisKeys &keys, const string &filename);
+
+  /// Maps the store in `filename`, checking that it matches `context`
+  AfsealGaloisKeyStore(const string &filename, shared_ptr<seal::SEALContext> context);
+  ~AfsealGaloisKeyStore();
+  AfsealGaloisKeyStore(const AfsealGaloisKeyStore &) = delete;
+  AfsealGaloisKeyStore &operator=(const AfsealGaloisKeyStore &) = delete;
+
+  /// Keys loaded so far, with room for all the keys in the store
+  shared_ptr<seal::GaloisKeys> keys() const { return loaded_keys; }
+
+  /// Whether the store holds the key of galois_elt, loaded or not
+  bool contains(uint32_t galois_elt) const { return index.count(galois_elt) > 0; }
+
+  /// Loads the key of galois_elt if needed. Returns the lock to read keys()
+  shared_lock<shared_mutex> use(uint32_t galois_elt);
+
+  /// Loads every key in the store
+  void load_all();
+
+  size_t n_keys() const { return index.size(); }
+  size_t n_loaded();
+
+ private:
+  struct Entry { uint64_t offset; uint64_t size; uint32_t n_parts; };
+  shared_ptr<seal::SEALContext> context;
+  shared_ptr<seal::GaloisKeys> loaded_keys;
+  map<uint32_t, Entry> index;          /**< Location of each key in the file.*/
+  shared_mutex mtx;
+  const seal::seal_byte *data = nullptr; /**< Mapped file.*/
+  size_t data_size = 0;
+  void *mapping = nullptr;             /**< Mapping handle, in Windows.*/
+
+  void read_index();
+  void load(uint32_t galois_elt);      // Requires the exclusive lock
+  void unmap();
+};
+
+
+// =============================================================================
+// =============================== CONTEXT CACHE ===============================
+// =============================================================================
+/// SEAL context of a parameter set, with its evaluator and encoder built on
+/// first use. All of them are immutable, so Afseal objects share them.
+struct AfsealComponents {
+  shared_ptr<seal::SEALContext> context;
+  shared_ptr<seal::Evaluator> evaluator;
+  shared_ptr<seal::BatchEncoder> batch_encoder;   /**< bfv and bgv.*/
+  shared_ptr<seal::CKKSEncoder> ckks_encoder;
+};
+
+/// Process-wide cache of AfsealComponents, keyed by parms_id and security.
+///
+/// Contexts with cached parameters skip the prime checks and the generation
+/// of NTT tables and of the modulus chain, and share the evaluator and
+/// encoders. The least recently used parameter sets are evicted beyond the
+/// capacity, AFSEAL_CONTEXT_CACHE (16 by default); 0 disables the cache.
+class AfsealContextCache {
+ public:
+  /// Components of parms, cached or newly built (and cached if valid)
+  static shared_ptr<AfsealComponents> get(const seal::EncryptionParameters &parms,
+                                          seal::sec_level_type sec);
+
+  /// Sets the number of cached parameter sets, evicting the excess
+  static void set_capacity(size_t capacity);
+
+  /// Drops every cached parameter set and resets the counters
+  static void clear();
+
+  /// {hits, misses, cached parameter sets, capacity}
+  static vector<uint64_t> stats();
+
+ private:
+  struct State;
+  static State &state();
+};
+
+
+// =============================================================================
+// ============================== TENANT REGISTRY ==============================
+// =============================================================================
+/// Process-wide registry of the evaluation state of the tenants of a server.
+///
+/// Each tenant ID maps to an evaluation-only Afseal with its context and its
+/// public, relinearization and rotation keys, shared with every holder of it
+/// (contexts are shared through the context cache). Past the memory budget,
+/// the least recently used tenants not in use are evicted: spilled to files
+/// in the spill directory, to be reloaded on next use with their rotation
+/// keys memory-mapped, or dropped if there is none.
+class AfsealTenantRegistry {
+ public:
+  /// Registers an evaluation-only copy of afseal, sharing its keys, with
+  /// the default scale and prime sizes of its context
+  static void add(const string &tenant, const Afseal &afseal,
+                  double scale = 1, const vector<int> &qi_sizes = {});
+
+  /// Afseal of a tenant, reloaded if spilled. Throws out_of_range if unknown.
+  /// The tenant is not evicted while the returned pointer is held.
+  static shared_ptr<Afseal> get(const string &tenant);
+  static shared_ptr<Afseal> get(const string &tenant, double &scale,
+                                vector<int> &qi_sizes);
+
+  /// Drops a tenant and its spill files
+  static void remove(const string &tenant);
+
+  /// Budget in bytes of the keys kept in memory (0: unlimited), and spill
+  /// directory (empty: evicted tenants are dropped)
+  static void configure(size_t budget_bytes, const string &spill_dir);
+
+  /// {tenants, tenants in memory, key bytes in memory, budget, hits,
+  ///  reloads, evictions}
+  static vector<uint64_t> stats();
+
+ private:
+  struct State;
+  static State &state();
+};
+
+
 // =============================================================================
 // ================== ABSTRACTION FOR HOMOMORPHIC ENCR. LIBS ===================
 // =============================================================================
@@ -233,26 +554,84 @@ class AfsealPoly: public AfPoly {
 inline AfsealCtxt& _dyn_c(AfCtxt& c){return dynamic_cast<AfsealCtxt&>(c);};
 inline AfsealPtxt& _dyn_p(AfPtxt& p){return dynamic_cast<AfsealPtxt&>(p);};
 
+// Counters of the deferred relinearization policy. Copyable so Afseal is.
+struct AfsealRelinStats {
+  atomic<uint64_t> deferred{0};     /**< Products left unrelinearized. */
+  atomic<uint64_t> performed{0};    /**< Automatic relinearizations. */
+  AfsealRelinStats() = default;
+  AfsealRelinStats(const AfsealRelinStats &o)
+    : deferred(o.deferred.load()), performed(o.performed.load()) {}
+  AfsealRelinStats &operator=(const AfsealRelinStats &o){
+    deferred = o.deferred.load(); performed = o.performed.load(); return *this;
+  }
+};
+
+// Rotation steps recorded for key planning, and the chains of key steps that
+//  compose steps without a key of their own. Copies start empty.
+struct AfsealRotPlan {
+  atomic<bool> record{false};       /**< Count the step of every rotation. */
+  atomic<bool> dry_run{false};      /**< Record rotations without running them. */
+  mutex mtx;                        /**< Guards steps and chains. */
+  map<int, uint64_t> steps;         /**< Rotations per step, 0 for flips. */
+  weak_ptr<seal::GaloisKeys> chains_keys; /**< Keys the chains refer to. */
+  vector<int> dist;                 /**< Rotations composing each row step. */
+  vector<int> last;                 /**< Key step of the last such rotation. */
+  AfsealRotPlan() = default;
+  AfsealRotPlan(const AfsealRotPlan &) {}
+  AfsealRotPlan &operator=(const AfsealRotPlan &) { return *this; }
+};
+
 class Afseal: public Afhel {
 
  private:
   // --------------------------- ATTRIBUTES -----------------------------
 
-  shared_ptr<seal::SEALContext> context = NULL;     /**< Context. Used for init*/
-  shared_ptr<seal::BatchEncoder> bfvEncoder = NULL; /**< Rotation in Batching. */
-  shared_ptr<seal::CKKSEncoder> ckksEncoder = NULL; /**< Rotation in Batching. */
-  shared_ptr<seal::BatchEncoder> bgvEncoder = NULL;  
-  
+  shared_ptr<AfsealComponents> components = NULL;  /**< Context, codec, evaluator*/
+
   shared_ptr<seal::KeyGenerator> keyGenObj = NULL;  /**< Key Generator Object.*/
   shared_ptr<seal::SecretKey> secretKey = NULL;     /**< Secret key.*/
   shared_ptr<seal::PublicKey> publicKey = NULL;     /**< Public key.*/
   shared_ptr<seal::RelinKeys> relinKeys = NULL;     /**< Relinearization object*/
   shared_ptr<seal::GaloisKeys> rotateKeys = NULL;   /**< Galois key for batching*/
+  shared_ptr<AfsealGaloisKeyStore> rotateKeyStore = NULL; /**< Lazy rotateKeys*/
 
   shared_ptr<seal::Encryptor> encryptor = NULL;     /**< Requires a Public Key.*/
-  shared_ptr<seal::Evaluator> evaluator = NULL;     /**< Requires a context.*/
   shared_ptr<seal::Decryptor> decryptor = NULL;     /**< Requires a Secret Key.*/
 
+  bool eval_only = false;           /**< No secret key nor key generator.*/
+  // Throws in evaluation-only mode, for operations requiring the secret key
+  void check_secret_allowed();
+  // Sets the context of parms, shared through the context cache
+  void set_context(const seal::EncryptionParameters &parms, int sec);
+
+  bool auto_relin = false;          /**< Defer relinearization until needed.*/
+  size_t relin_max_size = 3;        /**< Max ciphertext size in auto mode.*/
+  AfsealRelinStats relin_stats;
+
+  // Auto mode: relinearize an operand that must be of size 2
+  void relin_operand(Ciphertext &ctxt);
+  // Auto mode: a read-only operand, or its relinearized copy in tmp
+  const Ciphertext &relin_operand(const Ciphertext &ctxt, Ciphertext &tmp);
+  // Auto mode: relinearize a product only if it exceeds relin_max_size
+  void relin_product(Ciphertext &ctxt);
+
+  AfsealRotPlan rot_plan;
+
+  // Rotates the rows of `in` by k slots into `out` (may alias `in`). Steps
+  //  without a key are composed from the available ones. Recorded if enabled.
+  void rotate_to(const Ciphertext &in, int k, Ciphertext &out);
+  // Same for the column flip of bfv/bgv, recorded as step 0.
+  void flip_to(const Ciphertext &in, Ciphertext &out);
+  // Whether a rotation key exists, loaded or still in the key store
+  bool rot_has_key(uint32_t galois_elt);
+  // Lock to hold while rotating with the key of galois_elt, loading it from
+  //  the key store if needed. Empty without a store.
+  shared_lock<shared_mutex> rot_key_lock(uint32_t galois_elt);
+  // Records a rotation, returning true if it must be skipped (dry run)
+  bool rot_record(int step);
+  // Slots in a rotation row: n/2 in all schemes
+  size_t rot_row_size();
+
   // ------------------ STREAM OPERATORS OVERLOAD -----------------------
   friend ostream &operator<<(ostream &outs, Afseal const &af);
   friend istream &operator>>(istream &ins, Afseal const &af);
@@ -280,9 +659,15 @@ class Afseal: public Afhel {
   void relinKeyGen();
   void rotateKeyGen(vector<int> rot_steps = {});
 
+  // EVALUATION-ONLY MODE
+  void set_eval_only(bool eval_only);
+  bool is_eval_only() { return eval_only; }
+
   // ENCRYPTION
   void encrypt(AfPtxt &ptxt, AfCtxt &cipherOut);
   void encrypt_v(vector<shared_ptr<AfPtxt>> &ptxtV, vector<shared_ptr<AfCtxt>> &ctxtVOut);
+  void encrypt_symmetric(AfPtxt &ptxt, AfCtxt &cipherOut);
+  size_t save_encrypt_symmetric(ostream &out_stream, string &compr_mode, AfPtxt &ptxt);
 
   // DECRYPTION
   void decrypt(AfCtxt &ctxt, AfPtxt &plainOut);
@@ -295,20 +680,45 @@ class Afseal: public Afhel {
   // ENCODE
   // bfv
   void encode_i(vector<int64_t> &values, AfPtxt &plainOut);
+  void encode_i(const int64_t *values, size_t n_values, AfPtxt &plainOut);
   // ckks
   void encode_f(vector<double> &values, double scale, AfPtxt &ptxtVOut);
+  void encode_f(const double *values, size_t n_values, double scale, AfPtxt &ptxtVOut);
   void encode_c(vector<std::complex<double>> &values, double scale, AfPtxt &ptxtVOut);
+  void encode_c(const std::complex<double> *values, size_t n_values, double scale, AfPtxt &ptxtVOut);
   // bgv
   void encode_g(vector<int64_t> &values, AfPtxt &plainOut);
+  void encode_g(const int64_t *values, size_t n_values, AfPtxt &plainOut);
 
   // DECODE
+  // Pointer overloads write the first n_values slots straight into the
+  //  caller buffer (zero padded past nSlots), without any extra copy when
+  //  n_values == nSlots and SEAL is built with MSGSL.
   // bfv
   void decode_i(AfPtxt &ptxt, vector<int64_t> &valueVOut);
+  void decode_i(AfPtxt &ptxt, int64_t *valuesOut, size_t n_values);
   // ckks
   void decode_f(AfPtxt &ptxt, vector<double> &valueVOut);
+  void decode_f(AfPtxt &ptxt, double *valuesOut, size_t n_values);
   void decode_c(AfPtxt &ptxt, vector<std::complex<double>> &valueVOut);
+  void decode_c(AfPtxt &ptxt, std::complex<double> *valuesOut, size_t n_values);
   // bgv
   void decode_g(AfPtxt &ptxt, vector<int64_t> &valueVOut);
+  void decode_g(AfPtxt &ptxt, int64_t *valuesOut, size_t n_values);
+
+  // BATCHED CODEC
+  // `values` is a row-major n_rows x row_len array, encoded into one
+  //  plaintext per row. ptxtVOut is resized to n_rows if needed.
+  void encode_i_v(const int64_t *values, size_t n_rows, size_t row_len, vector<shared_ptr<AfPtxt>> &ptxtVOut);
+  void encode_f_v(const double *values, size_t n_rows, size_t row_len, double scale, vector<shared_ptr<AfPtxt>> &ptxtVOut);
+  void encode_c_v(const std::complex<double> *values, size_t n_rows, size_t row_len, double scale, vector<shared_ptr<AfPtxt>> &ptxtVOut);
+  void encode_g_v(const int64_t *values, size_t n_rows, size_t row_len, vector<shared_ptr<AfPtxt>> &ptxtVOut);
+  // `valuesOut` is a preallocated row-major ptxtV.size() x row_len array.
+  //  Each row gets the first row_len decoded slots (zero padded if fewer).
+  void decode_i_v(vector<shared_ptr<AfPtxt>> &ptxtV, int64_t *valuesOut, size_t row_len);
+  void decode_f_v(vector<shared_ptr<AfPtxt>> &ptxtV, double *valuesOut, size_t row_len);
+  void decode_c_v(vector<shared_ptr<AfPtxt>> &ptxtV, std::complex<double> *valuesOut, size_t row_len);
+  void decode_g_v(vector<shared_ptr<AfPtxt>> &ptxtV, int64_t *valuesOut, size_t row_len);
 
   // AUXILIARY
   void data(AfPtxt &ptxt, uint64_t *dest);
@@ -316,7 +726,13 @@ class Afseal: public Afhel {
   
   // -------------------------- RELINEARIZATION -------------------------
   void relinearize(AfCtxt &ctxt);
-  void relinearize_v(vector<shared_ptr<AfCtxt>> ctxtV);
+  void relinearize_v(vector<shared_ptr<AfCtxt>> &ctxtV);
+  // max_size is 2 or 3: relinearization keys only cover size 3 ciphertexts
+  void set_auto_relin(bool enabled, size_t max_size);
+  bool get_auto_relin();
+  size_t get_relin_max_size();
+  // {deferred products, automatic relinearizations, saved relinearizations}
+  vector<uint64_t> get_relin_stats(bool reset);
 
   // ---------------------- HOMOMORPHIC OPERATIONS ----------------------
   // NEGATE
@@ -350,10 +766,55 @@ class Afseal: public Afhel {
   void rotate_v(vector<shared_ptr<AfCtxt>> &ctxtV, int k);
   void flip(AfCtxt &ctxt);
   void flip_v(vector<shared_ptr<AfCtxt>> &ctxtV);
+  // Rotations of a single ciphertext by each of `steps`, run in parallel.
+  void rotate_many(AfCtxt &ctxt, vector<int> &steps, vector<shared_ptr<AfCtxt>> &ctxtVOut);
+  // In-place cumulative sum of the first n_elements slots into every slot,
+  //  using a single scratch ciphertext for all log2(n_elements) steps.
+  void cumul_add(AfCtxt &ctxt, size_t n_elements);
+
+  // REDUCTIONS
+  // Sum/product of all the ciphertexts of ctxtV into ctxtOut, as a balanced
+  //  tree whose levels run in parallel. Operands are brought to the lowest
+  //  level among them. Products are relinearized (and rescaled in ckks,
+  //  mod switched in bgv) at each tree level: ceil(log2(K)) levels for K.
+  //  In ckks sums, operands above are rescaled where their scale exceeds the
+  //  other's by the dropped prime, and scales must then share their rounded
+  //  log2 (invalid_argument otherwise).
+  void add_many(vector<shared_ptr<AfCtxt>> &ctxtV, AfCtxt &ctxtOut);
+  void multiply_many(vector<shared_ptr<AfCtxt>> &ctxtV, AfCtxt &ctxtOut);
+
+  // ROTATION KEY PLANNING
+  void set_rotation_record(bool enabled, bool dry_run);
+  map<int, uint64_t> get_rotation_record();
+  // Greedy: starting from one key per step (and from those plus the default
+  //  power-of-2 keys), drops keys while every step stays within reach.
+  vector<int> plan_rotation_keys(map<int, uint64_t> &steps, size_t max_extra);
+  // -1 if some step cannot be composed from key_steps
+  int64_t count_rotations(vector<int> &key_steps, map<int, uint64_t> &steps);
+
+  // LINEAR ALGEBRA
+  // Encodes the generalized diagonals of a row-major n_rows x n_cols matrix,
+  //  zero padded to a dim x dim square (dim: next power of 2), pre-rotated
+  //  for the baby-step giant-step product in matvec_plain.
+  void encode_matrix_i(const int64_t *matrix, size_t n_rows, size_t n_cols, vector<shared_ptr<AfPtxt>> &diagVOut);
+  void encode_matrix_f(const double *matrix, size_t n_rows, size_t n_cols, double scale, vector<shared_ptr<AfPtxt>> &diagVOut);
+  // Plaintext matrix x encrypted vector, in place. The vector lives in the
+  //  first dim slots (rest zero); the result in the first n_rows slots, with
+  //  zeros in the rest of the row. An all-zero matrix gives an encryption of 0.
+  void matvec_plain(AfCtxt &ctxt, vector<shared_ptr<AfPtxt>> &diagV);
 
   // POWER
   void exponentiate(AfCtxt &ctxt, uint64_t &expon);
   void exponentiate_v(vector<shared_ptr<AfCtxt>> &cipherV, uint64_t &expon);
+  // ckks polynomial evaluation in place, Paterson-Stockmeyer style. coeffs
+  //  are in the monomial basis, or in the Chebyshev basis over [x_min, x_max].
+  void eval_poly(AfCtxt &ctxt, vector<double> &coeffs, bool chebyshev, double x_min, double x_max);
+
+  // EXPRESSION GRAPH
+  // Evaluates a whole graph in one call: independent nodes run in parallel,
+  //  single-use intermediates are updated in place (fusing add chains), and
+  //  relinearization/rescaling are deferred until an operand requires them.
+  void eval_graph(vector<AfGraphNode> &nodes);
 
   // CKKS -> Rescaling and mod switching
   void rescale_to_next(AfCtxt &ctxt);
@@ -362,16 +823,25 @@ class Afseal: public Afhel {
   void mod_switch_to_next_v(vector<shared_ptr<AfCtxt>> &ctxtV);
   void mod_switch_to_next_plain(AfPtxt &ptxt);
   void mod_switch_to_next_plain_v(vector<shared_ptr<AfPtxt>> &ptxtV);
+
+  // NTT PLAINTEXTS
+  // Transforms a bfv/bgv plaintext to NTT form at the level reached after
+  //  dropping mod_level primes (ckks plaintexts, always in NTT form, are
+  //  mod-switched there). multiply_plain then skips the transform.
+  void plain_to_ntt(AfPtxt &ptxt, size_t mod_level);
+  // Number of primes dropped from the ciphertext's coefficient modulus.
+  size_t get_mod_level(AfCtxt &ctxt);
   
   // --------------------------- VECTORIZATION --------------------------
+  // Operands are passed by reference to f, and run in the AfsealTaskPool.
   void vectorize(vector<shared_ptr<AfCtxt>> &ctxtVInOut,
-                    function<void(AfCtxt)> f);
+                    function<void(AfCtxt&)> f);
   void vectorize(vector<shared_ptr<AfPtxt>> &ptxtVInOut,
-                    function<void(AfPtxt)> f);
+                    function<void(AfPtxt&)> f);
   void vectorize(vector<shared_ptr<AfCtxt>> &ctxtVInOut,vector<shared_ptr<AfCtxt>> &ctxtV2,
-                    function<void(AfCtxt, AfCtxt)> f);
+                    function<void(AfCtxt&, AfCtxt&)> f);
   void vectorize(vector<shared_ptr<AfCtxt>> &ctxtVInOut,vector<shared_ptr<AfPtxt>> &ptxtV2,
-                    function<void(AfCtxt, AfPtxt)> f);
+                    function<void(AfCtxt&, AfPtxt&)> f);
 
   // -------------------------------- I/O -------------------------------
   // AUX
@@ -383,7 +853,7 @@ class Afseal: public Afhel {
   size_t load_context(istream &in_stream, int sec=128);
 
   // SAVE/LOAD PUBLICKEY
-  size_t save_public_key(ostream &out_stream, string &compr_mode);
+  size_t save_public_key(ostream &out_stream, string &compr_mode, bool seeded=false);
   size_t load_public_key(istream &in_stream);
 
   // SAVE/LOAD SECRETKEY
@@ -391,12 +861,15 @@ class Afseal: public Afhel {
   size_t load_secret_key(istream &in_stream);
 
   // SAVE/LOAD RELINKEY
-  size_t save_relin_keys(ostream &out_stream, string &compr_mode);
+  size_t save_relin_keys(ostream &out_stream, string &compr_mode, bool seeded=false);
   size_t load_relin_keys(istream &in_stream);
 
   // SAVE/LOAD ROTKEYS
-  size_t save_rotate_keys(ostream &out_stream, string &compr_mode);
+  size_t save_rotate_keys(ostream &out_stream, string &compr_mode, bool seeded=false);
   size_t load_rotate_keys(istream &in_stream);
+  size_t save_rotate_keys_store(string &filename);
+  size_t load_rotate_keys_store(string &filename);
+  vector<size_t> get_rotate_keys_store_stats();
 
   // SAVE/LOAD PLAINTEXT --> Could be achieved outside of Afseal
   size_t save_plaintext(ostream &out_stream, string &compr_mode, AfPtxt &pt);
@@ -406,12 +879,30 @@ class Afseal: public Afhel {
   size_t save_ciphertext(ostream &out_stream, string &compr_mode, AfCtxt &ct);
   size_t load_ciphertext(istream &in_stream, AfCtxt &pt);
 
+  // SAVE/LOAD IN MEMORY
+  size_t save_plaintext(uint8_t *out, size_t size, string &compr_mode, AfPtxt &pt);
+  size_t load_plaintext(const uint8_t *in, size_t size, AfPtxt &pt);
+  size_t save_ciphertext(uint8_t *out, size_t size, string &compr_mode, AfCtxt &ct);
+  size_t load_ciphertext(const uint8_t *in, size_t size, AfCtxt &ct);
+
+  // RAW DATA
+  vector<uint64_t> raw_header(AfCtxt &ct);
+  uint64_t *raw_data(AfCtxt &ct);
+  void load_raw(AfCtxt &ct, vector<uint64_t> &header, const uint8_t *data, size_t n_bytes);
+  vector<uint64_t> raw_header(AfPtxt &pt);
+  uint64_t *raw_data(AfPtxt &pt);
+  void load_raw(AfPtxt &pt, vector<uint64_t> &header, const uint8_t *data, size_t n_bytes);
+
   // SIZES
   size_t sizeof_context(string &compr_mode);
   size_t sizeof_public_key(string &compr_mode);
   size_t sizeof_secret_key(string &compr_mode);
   size_t sizeof_relin_keys(string &compr_mode);
   size_t sizeof_rotate_keys(string &compr_mode);
+  // Uncompressed size of a single rotation key, without generating it
+  size_t sizeof_galois_key();
+  // Memory held by the public, relinearization and (loaded) rotation keys
+  size_t key_bytes();
   size_t sizeof_plaintext(string &compr_mode, AfPtxt &pt);
   size_t sizeof_ciphertext(string &compr_mode, AfCtxt &ct);
 
@@ -436,7 +927,7 @@ class Afseal: public Afhel {
   bool is_publicKey_empty() { return publicKey==NULL; }
   bool is_rotKey_empty() { return rotateKeys==NULL; }
   bool is_relinKeys_empty() { return relinKeys==NULL; }
-  bool is_context_empty() { return context==NULL; }
+  bool is_context_empty() { return components==NULL; }
 
   //KEY GETTERS/SETTERS
   inline shared_ptr<SEALContext>  get_context();
@@ -450,6 +941,8 @@ class Afseal: public Afhel {
   inline shared_ptr<PublicKey>  get_publicKey();
   inline shared_ptr<RelinKeys>  get_relinKeys();
   inline shared_ptr<GaloisKeys>  get_rotateKeys();
+  /// Key generator of the current secret key (required to generate seeded keys)
+  inline shared_ptr<KeyGenerator>  get_keyGenObj();
   void setpublicKey(seal::PublicKey &pubKey) { this->publicKey = make_shared<seal::PublicKey>(pubKey); }
   void setsecretKey(seal::SecretKey &secKey) { this->secretKey = make_shared<seal::SecretKey>(secKey); }
   void setrelinKeys(seal::RelinKeys &relKey) { this->relinKeys = make_shared<seal::RelinKeys>(relKey); }
@@ -475,4 +968,78 @@ class Afseal: public Afhel {
   void set_coeff(AfPoly& poly, complex<double> &val, size_t i);
   vector<complex<double>> to_coeff_list(AfPoly& poly);
 };
+
+
+// =============================================================================
+// ============================= CIPHERTEXT FILES ==============================
+// =============================================================================
+/// Container file of many ciphertexts of the same context.
+///
+/// A header with the hash (key parms_id) of the context and the compression
+/// mode is followed by length-prefixed SEAL ciphertexts, and closed by an
+/// index with the offset of each one. Writers append in a stream, serializing
+/// batches in parallel; readers access any range of ciphertexts by index,
+/// reading it in large chunks that are decoded in parallel. Files left without
+/// an index by an interrupted writer are indexed by scanning their records.
+class AfsealCtxtFileWriter {
+ public:
+  /// Creates `filename`, or appends to it keeping its compression mode
+  AfsealCtxtFileWriter(const string &filename, Afseal &afseal,
+                       const string &compr_mode, bool append = false);
+  /// Closes the file if not done yet, ignoring errors
+  ~AfsealCtxtFileWriter();
+  AfsealCtxtFileWriter(const AfsealCtxtFileWriter &) = delete;
+  AfsealCtxtFileWriter &operator=(const AfsealCtxtFileWriter &) = delete;
+
+  void append(AfCtxt &ctxt);
+  /// Appends ctxts in order, serializing them in parallel
+  void append(vector<shared_ptr<AfCtxt>> &ctxts);
+
+  /// Writes the index. Throws logic_error on later appends
+  void close();
+
+  /// Ciphertexts in the file
+  size_t size() const { return offsets.size(); }
+
+ private:
+  Afseal afseal;                  /**< Shares the context of the caller.*/
+  string compr_mode;
+  fstream file;
+  vector<uint64_t> offsets;       /**< Start of each record.*/
+  uint64_t end = 0;               /**< End of the last record.*/
+  bool closed = false;
+
+  vector<uint8_t> record(AfCtxt &ctxt);
+  void write(const vector<uint8_t> &rec);
+};
+
+class AfsealCtxtFileReader {
+ public:
+  /// Opens `filename`, checking that it matches the context of afseal
+  AfsealCtxtFileReader(const string &filename, Afseal &afseal);
+  AfsealCtxtFileReader(const AfsealCtxtFileReader &) = delete;
+  AfsealCtxtFileReader &operator=(const AfsealCtxtFileReader &) = delete;
+
+  /// Ciphertexts in the file
+  size_t size() const { return offsets.size(); }
+  string compr_mode() const;
+
+  void read(size_t i, AfCtxt &ctxtOut);
+  /// Reads ctxtVOut.size() ciphertexts from index `begin`, decoding them in
+  /// parallel. Throws out_of_range past the end of the file.
+  void read(size_t begin, vector<shared_ptr<AfCtxt>> &ctxtVOut);
+
+ private:
+  Afseal afseal;
+  ifstream file;
+  mutex mtx;                      /**< Guards file.*/
+  vector<uint64_t> offsets;
+  uint64_t data_end = 0;
+  seal::compr_mode_type compr = seal::compr_mode_type::none;
+
+  uint64_t record_end(size_t i) const
+  { return (i + 1 < offsets.size()) ? offsets[i + 1] : data_end; }
+  vector<uint8_t> read_records(size_t begin, size_t end);
+  void decode(const vector<uint8_t> &chunk, size_t first, size_t i, AfCtxt &ctxtOut);
+};
 #endif
@@ -0,0 +1,322 @@
+#include "../Afseal.h"
+
+#include <chrono>	// Measure time
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+// Wall-clock benchmark of every Afseal operation, its vectorized (_v) variant
+//  and the serialization paths, over a sweep of parameters:
+//   - scheme:  bfv, bgv, ckks
+//   - n:       poly_modulus_degree
+//   - depth:   number of middle primes in the coefficient modulus chain
+//   - threads: size of the task pool running the _v operations. Each value
+//              runs in a child process with AFSEAL_NUM_THREADS set.
+// Per operation, reports the latency percentiles over `reps` repetitions and
+//  the throughput in operations (batch elements) per second, as one JSON
+//  object per line on stdout. Progress goes to stderr.
+// Usage: bench_afseal [--schemes bfv,ckks] [--n 8192,16384] [--depth 2,4]
+//                     [--threads 1,4] [--reps 20] [--batch 16] [--out file]
+
+vector<string> split(const string &s)
+{
+	vector<string> out;
+	std::stringstream ss(s);
+	for (string item; std::getline(ss, item, ',');)
+	{
+		if (!item.empty()) { out.push_back(item); }
+	}
+	return out;
+}
+
+struct Config
+{
+	vector<string> schemes = {"bfv", "ckks"};
+	vector<string> ns = {"8192", "16384"};
+	vector<string> depths = {"2", "4"};
+	vector<string> threads;     // Empty: pool size of this process
+	size_t reps = 20;
+	size_t batch = 16;
+	string out;
+};
+
+class Bench
+{
+	public:
+	Bench(const string &scheme, size_t n, size_t depth, size_t reps, size_t batch)
+		: scheme(scheme), n(n), depth(depth), reps(reps), batch(batch) {}
+
+	// Times `op` reps times (plus a warm-up run), calling `setup` untimed
+	//  before each run. `items` are the elements processed per run, `bytes`
+	//  the bytes serialized per run.
+	void run(const string &name, std::function<void()> setup, std::function<void()> op,
+			 size_t items = 1, std::function<size_t()> bytes = nullptr)
+	{
+		vector<double> us;
+		try
+		{
+			setup();
+			op();
+			for (size_t r = 0; r < reps; r++)
+			{
+				setup();
+				auto start = std::chrono::steady_clock::now();
+				op();
+				std::chrono::duration<double, std::micro> d = std::chrono::steady_clock::now() - start;
+				us.push_back(d.count());
+			}
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << "  " << name << ": skipped (" << e.what() << ")" << endl;
+			return;
+		}
+		std::sort(us.begin(), us.end());
+		double total = 0;
+		for (double t : us) { total += t; }
+		double mean = total / us.size();
+		std::ostringstream line;
+		line << "{\"scheme\":\"" << scheme << "\",\"n\":" << n << ",\"depth\":" << depth
+			 << ",\"threads\":" << AfsealTaskPool::instance().num_threads()
+			 << ",\"op\":\"" << name << "\",\"items\":" << items << ",\"reps\":" << us.size()
+			 << ",\"mean_us\":" << mean << ",\"min_us\":" << us.front()
+			 << ",\"p50_us\":" << percentile(us, 0.5) << ",\"p90_us\":" << percentile(us, 0.9)
+			 << ",\"p99_us\":" << percentile(us, 0.99) << ",\"max_us\":" << us.back()
+			 << ",\"items_per_s\":" << items * 1e6 / mean;
+		if (bytes)
+		{
+			size_t b = bytes();
+			line << ",\"bytes\":" << b << ",\"mb_per_s\":" << b / mean;
+		}
+		line << "}";
+		std::cout << line.str() << endl;
+		std::cerr << "  " << name << ": p50 " << percentile(us, 0.5) << " us" << endl;
+	}
+
+	// Nearest rank of a sorted sample
+	static double percentile(const vector<double> &sorted, double q)
+	{
+		size_t rank = (size_t)std::ceil(q * sorted.size());
+		return sorted[std::max(rank, (size_t)1) - 1];
+	}
+
+	string scheme;
+	size_t n, depth, reps, batch;
+};
+
+void bench_params(Bench &b)
+{
+	scheme_t scheme = (b.scheme == "ckks") ? scheme_t::ckks
+					: (b.scheme == "bgv") ? scheme_t::bgv : scheme_t::bfv;
+	bool ckks = (scheme == scheme_t::ckks);
+	double scale = std::pow(2.0, 40);
+	vector<int> qi_sizes(b.depth + 2, 40);
+	qi_sizes.front() = qi_sizes.back() = 60;
+
+	Afseal he;
+	he.ContextGen(scheme, b.n, ckks ? 0 : 20, 0, 128, qi_sizes);
+	he.KeyGen();
+	he.relinKeyGen();
+	he.rotateKeyGen({1});
+	size_t slots = he.get_nSlots();
+
+	vector<int64_t> vi(slots);
+	vector<double> vf(slots);
+	for (size_t i = 0; i < slots; i++)
+	{
+		vi[i] = (int64_t)(i % 100);
+		vf[i] = (double)(i % 100) / 100;
+	}
+	auto encode = [&](AfPtxt &p)
+	{
+		if (ckks) { he.encode_f(vf, scale, p); }
+		else if (scheme == scheme_t::bgv) { he.encode_g(vi, p); }
+		else { he.encode_i(vi, p); }
+	};
+	AfsealPtxt p, p_out;
+	AfsealCtxt c, c2, c_in, c_prod;
+	encode(p);
+	he.encrypt(p, c_in);
+	he.encrypt(p, c2);
+	c_prod = c_in;
+	he.multiply(c_prod, c2);
+
+	vector<shared_ptr<AfPtxt>> pv, pv_out;
+	vector<shared_ptr<AfCtxt>> cv, cv2, cv_in;
+	for (size_t i = 0; i < b.batch; i++)
+	{
+		pv.push_back(make_shared<AfsealPtxt>(p));
+		pv_out.push_back(make_shared<AfsealPtxt>());
+		cv.push_back(make_shared<AfsealCtxt>());
+		cv2.push_back(make_shared<AfsealCtxt>(c2));
+		cv_in.push_back(make_shared<AfsealCtxt>(c_in));
+	}
+	auto fresh = [&]() { c = c_in; };
+	auto fresh_v = [&]()
+	{
+		for (size_t i = 0; i < b.batch; i++) { _dyn_c(*cv[i]) = c_in; }
+	};
+	auto none = []() {};
+	size_t B = b.batch;
+
+	// CODEC AND ENCRYPTION
+	b.run("encode", none, [&]() { encode(p_out); });
+	b.run("decode", none, [&]()
+	{
+		if (ckks) { vector<double> out; he.decode_f(p, out); }
+		else { vector<int64_t> out; he.decode_i(p, out); }
+	});
+	b.run("encrypt", none, [&]() { he.encrypt(p, c); });
+	b.run("encrypt_v", none, [&]() { he.encrypt_v(pv, cv); }, B);
+	b.run("encrypt_symmetric", none, [&]() { he.encrypt_symmetric(p, c); });
+	b.run("decrypt", none, [&]() { he.decrypt(c_in, p_out); });
+	b.run("decrypt_v", fresh_v, [&]() { he.decrypt_v(cv, pv_out); }, B);
+
+	// ARITHMETIC
+	b.run("negate", fresh, [&]() { he.negate(c); });
+	b.run("negate_v", fresh_v, [&]() { he.negate_v(cv); }, B);
+	b.run("add", fresh, [&]() { he.add(c, c2); });
+	b.run("add_v", fresh_v, [&]() { he.add_v(cv, cv2); }, B);
+	b.run("add_plain", fresh, [&]() { he.add_plain(c, p); });
+	b.run("add_plain_v", fresh_v, [&]() { he.add_plain_v(cv, pv); }, B);
+	b.run("sub", fresh, [&]() { he.sub(c, c2); });
+	b.run("sub_v", fresh_v, [&]() { he.sub_v(cv, cv2); }, B);
+	b.run("sub_plain", fresh, [&]() { he.sub_plain(c, p); });
+	b.run("sub_plain_v", fresh_v, [&]() { he.sub_plain_v(cv, pv); }, B);
+	b.run("multiply", fresh, [&]() { he.multiply(c, c2); });
+	b.run("multiply_v", fresh_v, [&]() { he.multiply_v(cv, cv2); }, B);
+	b.run("multiply_plain", fresh, [&]() { he.multiply_plain(c, p); });
+	b.run("multiply_plain_v", fresh_v, [&]() { he.multiply_plain_v(cv, pv); }, B);
+	b.run("square", fresh, [&]() { he.square(c); });
+	b.run("square_v", fresh_v, [&]() { he.square_v(cv); }, B);
+	b.run("relinearize", [&]() { c = c_prod; }, [&]() { he.relinearize(c); });
+	b.run("relinearize_v", [&]()
+	{
+		for (size_t i = 0; i < B; i++) { _dyn_c(*cv[i]) = c_prod; }
+	}, [&]() { he.relinearize_v(cv); }, B);
+	b.run("rotate", fresh, [&]() { he.rotate(c, 1); });
+	b.run("rotate_v", fresh_v, [&]() { he.rotate_v(cv, 1); }, B);
+	if (!ckks)
+	{
+		b.run("flip", fresh, [&]() { he.flip(c); });
+		b.run("flip_v", fresh_v, [&]() { he.flip_v(cv); }, B);
+		uint64_t expon = 2;
+		b.run("exponentiate", fresh, [&]() { he.exponentiate(c, expon); });
+	}
+	if (ckks)
+	{
+		b.run("rescale_to_next", [&]() { c = c_prod; }, [&]() { he.rescale_to_next(c); });
+		b.run("rescale_to_next_v", [&]()
+		{
+			for (size_t i = 0; i < B; i++) { _dyn_c(*cv[i]) = c_prod; }
+		}, [&]() { he.rescale_to_next_v(cv); }, B);
+	}
+	b.run("mod_switch_to_next", fresh, [&]() { he.mod_switch_to_next(c); });
+	b.run("mod_switch_to_next_v", fresh_v, [&]() { he.mod_switch_to_next_v(cv); }, B);
+
+	// SERIALIZATION
+	for (string compr : {"none", "zstd"})
+	{
+		if (compr_mode_map.find(compr) == compr_mode_map.end()) { continue; }
+		std::stringstream ss;
+		size_t saved = 0;
+		b.run("save_ciphertext_" + compr, [&]() { ss.str(""); ss.clear(); },
+			  [&]() { saved = he.save_ciphertext(ss, compr, c_in); },
+			  1, [&]() { return saved; });
+		string blob = ss.str();
+		b.run("load_ciphertext_" + compr, [&]() { ss.str(blob); ss.clear(); },
+			  [&]() { he.load_ciphertext(ss, c); },
+			  1, [&]() { return blob.size(); });
+		vector<uint8_t> buf(he.sizeof_ciphertext(compr, c_in));
+		b.run("save_ciphertext_mem_" + compr, none,
+			  [&]() { saved = he.save_ciphertext(buf.data(), buf.size(), compr, c_in); },
+			  1, [&]() { return saved; });
+		b.run("load_ciphertext_mem_" + compr, none,
+			  [&]() { he.load_ciphertext(buf.data(), saved, c); },
+			  1, [&]() { return saved; });
+		b.run("save_plaintext_" + compr, [&]() { ss.str(""); ss.clear(); },
+			  [&]() { saved = he.save_plaintext(ss, compr, p); },
+			  1, [&]() { return saved; });
+	}
+}
+
+// Runs the sweep of `cfg` once per thread count, each in a child process
+int run_children(const Config &cfg, const string &self, int argc, char **argv)
+{
+	string args;
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--threads" || string(argv[i]) == "--out") { i++; continue; }
+		args += string(" ") + argv[i];
+	}
+	int rc = 0;
+	for (const string &t : cfg.threads)
+	{
+		std::cerr << " Afseal bench - " << t << " threads" << endl;
+#ifdef _WIN32
+		string cmd = "set AFSEAL_NUM_THREADS=" + t + "&& \"" + self + "\"" + args;
+#else
+		string cmd = "AFSEAL_NUM_THREADS=" + t + " \"" + self + "\"" + args;
+#endif
+		if (!cfg.out.empty()) { cmd += " >> \"" + cfg.out + "\""; }
+		std::cout.flush();
+		rc |= std::system(cmd.c_str());
+	}
+	return rc != 0;
+}
+
+int main(int argc, char **argv)
+{
+	Config cfg;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		string flag = argv[i], value = argv[i + 1];
+		if (flag == "--schemes") { cfg.schemes = split(value); }
+		else if (flag == "--n") { cfg.ns = split(value); }
+		else if (flag == "--depth") { cfg.depths = split(value); }
+		else if (flag == "--threads") { cfg.threads = split(value); }
+		else if (flag == "--reps") { cfg.reps = strtoul(value.c_str(), nullptr, 10); }
+		else if (flag == "--batch") { cfg.batch = strtoul(value.c_str(), nullptr, 10); }
+		else if (flag == "--out") { cfg.out = value; }
+		else
+		{
+			std::cerr << "Unknown option " << flag << endl;
+			return 1;
+		}
+	}
+	if (!cfg.threads.empty())
+	{
+		if (!cfg.out.empty()) { std::remove(cfg.out.c_str()); }
+		return run_children(cfg, argv[0], argc, argv);
+	}
+	if (!cfg.out.empty() && !std::freopen(cfg.out.c_str(), "w", stdout))
+	{
+		std::cerr << "Cannot open " << cfg.out << endl;
+		return 1;
+	}
+
+	for (const string &scheme : cfg.schemes)
+	{
+		for (const string &n : cfg.ns)
+		{
+			for (const string &depth : cfg.depths)
+			{
+				std::cerr << " Afseal bench - " << scheme << " n=" << n << " depth=" << depth
+						  << ", " << AfsealTaskPool::instance().num_threads() << " threads" << endl;
+				Bench b(scheme, strtoul(n.c_str(), nullptr, 10), strtoul(depth.c_str(), nullptr, 10),
+						cfg.reps, cfg.batch);
+				try
+				{
+					bench_params(b);
+				}
+				catch (std::exception &e)   // e.g. modulus chain too long for n
+				{
+					std::cerr << "  skipped: " << e.what() << endl;
+				}
+			}
+		}
+	}
+	return 0;
+}
@@ -19,21 +19,22 @@ class timing_map {
 	std::map<std::string, double> timings;
 };
 
+// Wall-clock seconds: std::clock() adds up the CPU time of all threads
 class timer {
 	public:
 	timer(timing_map& newtmap, std::string newname)
 		: tmap(newtmap),
 		name(newname),
-		start(std::clock()) {}
+		start(std::chrono::steady_clock::now()) {}
 
 	~timer() {
-		tmap.timings[name] = static_cast<double>(std::clock() - start) 
-		/ static_cast<double>(CLOCKS_PER_SEC);
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+		tmap.timings[name] = d.count();
 		}
 
 	timing_map& tmap;
 	std::string name;
-	std::clock_t start;
+	std::chrono::steady_clock::time_point start;
 };
 
 timing_map ctx;
@@ -61,7 +62,7 @@ int main(int argc, char **argv)
 
 	std::cout << " Afseal - Generating Keys" << endl;
     {timer t(ctx, "keygen"); he->KeyGen();}
-    {timer t(ctx, "rotkeygen"); he->rotateKeyGen();}
+    {timer t(ctx, "rotkeygen"); he->rotateKeyGen({});}
 	std::cout << " Afseal - Keys Generated" << endl;
     
 	vector<int64_t> v1;
@@ -163,7 +164,7 @@ int main(int argc, char **argv)
     size_t saved1 =he->save_context(f, compr_mode);
 	f.close();
 	ofstream f2("obj_pubkey.pypk", ios::binary);
-	size_t saved2 =he->save_public_key(f2, compr_mode);
+	size_t saved2 =he->save_public_key(f2, compr_mode, false);
 	f2.close();
 	ofstream f3("obj_seckey.pysk", ios::binary);
     size_t saved3 = he->save_secret_key(f3, compr_mode);
@@ -24,14 +24,19 @@ cdef class PyCtxt:
     cdef scheme_t _scheme
     cdef backend_t _backend
     cdef int _mod_level
+    cdef object _expr            # (op, lhs, rhs, k) of an unevaluated lazy result
     cpdef PyCtxt copy(self)
+    cpdef PyCtxt eval(self)
+    cdef bool _is_lazy(self)
+    cdef PyCtxt _lazy_op(self, graph_op_t op, object other=*, int k=*)
+    cdef PyCtxt _lazy_pow(self, object exponent)
     cpdef int size(self)
     cpdef void set_scale(self, double scale)
     cpdef void round_scale(self)
     cpdef size_t save(self, str fileName, str compr_mode=*)
     cpdef size_t load(self, str fileName, object scheme=*)
     cpdef bytes to_bytes(self, str compr_mode=*)
-    cpdef void from_bytes(self, bytes content, object scheme=*)
+    cpdef void from_bytes(self, const uint8_t[::1] content, object scheme=*)
     cpdef size_t sizeof_ciphertext(self, str compr_mode=*)
 
 # ---------------------------- VECTOR/ARRAY CLASS ------------------------------
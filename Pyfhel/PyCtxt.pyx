@@ -8,8 +8,13 @@ from .utils import Scheme_t, Backend_t, _to_valid_file_str
 
 # Dereferencing pointers in Cython in a secure way
 from cython.operator cimport dereference as deref
+from cpython.bytes cimport PyBytes_FromStringAndSize, PyBytes_AS_STRING
+from cpython.buffer cimport PyBUF_FORMAT, PyBUF_WRITABLE
+from cpython.mem cimport PyMem_Malloc, PyMem_Free
+from libc.string cimport memcpy
 
 import numpy as np
+from pickle import PickleBuffer
 from typing import Union, Tuple
 from warnings import warn
 
@@ -20,6 +25,16 @@ cdef class PyCtxt:
 
     This class references SEAL and PALISADE ciphertexts, using the one 
     corresponding to the backend selected in Pyfhel. By default, it is SEAL.   
+
+    Thread safety:
+        A PyCtxt can be read (used as an operand, saved, serialized) from several
+        threads at once, but must not be modified in-place (in-place ops, load,
+        from_bytes) while other threads access it. See :class:`~Pyfhel.Pyfhel`.
+
+    Lazy evaluation:
+        If the Pyfhel instance has `lazy` enabled, operators return unevaluated
+        ciphertexts holding an expression graph, computed on first use or with
+        :func:`eval`. See :attr:`~Pyfhel.Pyfhel.lazy`.
     """
     def __cinit__(self,
                   PyCtxt copy_ctxt=None,
@@ -30,6 +45,7 @@ cdef class PyCtxt:
         self._mod_level = 0
         self._scheme = scheme_t.none
         if copy_ctxt: # If there is a PyCtxt to copy, override other args
+            _ready(copy_ctxt)
             self._ptr_ctxt = make_shared[AfsealCtxt](deref(dyn_cast[AfsealCtxt,AfCtxt](copy_ctxt._ptr_ctxt)))
             self._mod_level = copy_ctxt._mod_level
             self._scheme = copy_ctxt._scheme
@@ -91,6 +107,20 @@ cdef class PyCtxt:
         """
         return PyCtxt(copy_ctxt=self)
 
+    cpdef PyCtxt eval(self):
+        """eval() -> PyCtxt
+
+        Evaluates the lazy expression of this ciphertext, if any.
+
+        Return:
+            PyCtxt: this same ciphertext, evaluated.
+
+        See Also:
+            :func:`~Pyfhel.Pyfhel.eval_lazy`
+        """
+        _ready(self)
+        return self
+
     @property
     def scheme(self):
         """scheme: returns the FHE scheme of this ciphertext.
@@ -115,6 +145,7 @@ cdef class PyCtxt:
         
         Only usable in ckks.
         """
+        _ready(self)
         return self._mod_level
     @mod_level.setter
     def mod_level(self, newlevel):  
@@ -141,16 +172,19 @@ cdef class PyCtxt:
         
         Return:
             int: size of this ciphertext"""
+        _ready(self)
         return <int>(deref(_dyn_c(self._ptr_ctxt))).size()
 
     @property    
     def capacity(self):
         """int: Maximum size the ciphertext can hold."""
+        _ready(self)
         return <int>(deref(_dyn_c(self._ptr_ctxt))).size_capacity()
 
     @property
     def scale(self):
         """double: multiplying factor to encode values in ckks."""
+        _ready(self)
         return (deref(_dyn_c(self._ptr_ctxt))).scale()
     @scale.setter
     def scale(self, new_scale):
@@ -159,6 +193,7 @@ cdef class PyCtxt:
     @property
     def scale_bits(self):
         """int: number of bits in scale to encode values in ckks"""
+        _ready(self)
         return <int>np.log2( (deref(_dyn_c(self._ptr_ctxt))).scale() )
 
     @property
@@ -181,6 +216,7 @@ cdef class PyCtxt:
         Args:
             scale (double): new scale of the ciphertext.
         """
+        _ready(self)
         (deref(_dyn_c(self._ptr_ctxt))).set_scale(new_scale)
 
     cpdef void round_scale(self):
@@ -188,6 +224,7 @@ cdef class PyCtxt:
 
         Rounds the scale of the ciphertext to the nearest power of 2.
         """
+        _ready(self)
         self.set_scale( pow(2, <int>np.round(np.log2( (deref(_dyn_c(self._ptr_ctxt))).scale() ))) )
 
     # =========================================================================
@@ -202,6 +239,63 @@ cdef class PyCtxt:
         """
         return (PyCtxt, (None, self._pyfhel, None, self.to_bytes(), self.scheme.name))
 
+    def __reduce_ex__(self, protocol):
+        """__reduce_ex__(protocol)
+
+        Pickling with protocol 5 hands the raw RNS data as an out-of-band
+        `PickleBuffer` (see :func:`to_raw`), so that multiprocessing, shared
+        memory or sockets given a `buffer_callback` ship it without serializing.
+        Older protocols fall back to :func:`__reduce__`.
+        """
+        if protocol < 5 or self._pyfhel is None:
+            return self.__reduce__()
+        header, data = self.to_raw()
+        if header[4] == 0:      # Empty ciphertext, no RNS data
+            return self.__reduce__()
+        return (_ctxt_from_raw, (self._pyfhel, header, PickleBuffer(data), self.scheme.name))
+
+    def __getbuffer__(self, Py_buffer *buffer, int flags):
+        """Exposes the RNS coefficients, shaped (size, n_moduli, n), as uint64.
+
+        The buffer is a read-only snapshot owned by the view, copied once from
+        the ciphertext: later in-place operations, which may reallocate the
+        SEAL storage, leave it untouched.
+        """
+        if self._pyfhel is None:
+            raise ValueError("<Pyfhel ERROR> ciphertext buffer export requires a Pyfhel instance")
+        if flags & PyBUF_WRITABLE:
+            raise BufferError("<Pyfhel ERROR> ciphertext buffers are read-only")
+        _ready(self)
+        cdef vector[uint64_t] header = self._pyfhel.afseal.raw_header(deref(self._ptr_ctxt))
+        cdef size_t nbytes = header[4] * header[5] * header[6] * sizeof(uint64_t)
+        # shape and strides are stored in the same block, ahead of the data
+        cdef Py_ssize_t *dims = <Py_ssize_t*>PyMem_Malloc(6 * sizeof(Py_ssize_t) + nbytes)
+        if dims == NULL:
+            raise MemoryError()
+        dims[0] = header[4]
+        dims[1] = header[5]
+        dims[2] = header[6]
+        dims[5] = sizeof(uint64_t)
+        dims[4] = header[6] * sizeof(uint64_t)
+        dims[3] = header[5] * header[6] * sizeof(uint64_t)
+        memcpy(&dims[6], self._pyfhel.afseal.raw_data(deref(self._ptr_ctxt)), nbytes)
+        buffer.buf = &dims[6]
+        buffer.format = NULL
+        if flags & PyBUF_FORMAT:
+            buffer.format = 'Q'
+        buffer.internal = dims
+        buffer.itemsize = sizeof(uint64_t)
+        buffer.len = nbytes
+        buffer.ndim = 3
+        buffer.obj = self
+        buffer.readonly = 1
+        buffer.shape = dims
+        buffer.strides = &dims[3]
+        buffer.suboffsets = NULL
+
+    def __releasebuffer__(self, Py_buffer *buffer):
+        PyMem_Free(buffer.internal)
+
     cpdef size_t save(self, str fileName, str compr_mode="zstd"):
         """save(str fileName)
         
@@ -217,14 +311,16 @@ cdef class PyCtxt:
         """
         if self._pyfhel is None:
             raise ValueError("<Pyfhel ERROR> ciphertext saving requires a Pyfhel instance")
+        _ready(self)
         cdef ofstream* outputter
         cdef size_t size
         cdef string bFileName = _to_valid_file_str(fileName).encode('utf8')
         cdef string bcompr_mode = compr_mode.lower().encode('utf8')
         outputter = new ofstream(bFileName, binary)
         try:
-            size = self._pyfhel.afseal.save_ciphertext(
-                deref(outputter), bcompr_mode, deref(self._ptr_ctxt))
+            with nogil:
+                size = self._pyfhel.afseal.save_ciphertext(
+                    deref(outputter), bcompr_mode, deref(self._ptr_ctxt))
         finally:
             del outputter
         return size
@@ -242,10 +338,17 @@ cdef class PyCtxt:
         """
         if self._pyfhel is None:
             raise ValueError("<Pyfhel ERROR> ciphertext serializing requires a Pyfhel instance")
-        cdef ostringstream outputter
+        _ready(self)
         cdef string bcompr_mode = compr_mode.encode('utf8')
-        self._pyfhel.afseal.save_ciphertext(outputter, bcompr_mode, deref(self._ptr_ctxt))
-        return outputter.str()
+        cdef size_t size, written
+        # Serialized straight into the bytes object, sized to an upper bound
+        size = self._pyfhel.afseal.sizeof_ciphertext(bcompr_mode, deref(self._ptr_ctxt))
+        cdef bytes out = PyBytes_FromStringAndSize(NULL, size)
+        cdef uint8_t* out_ptr = <uint8_t*>PyBytes_AS_STRING(out)
+        with nogil:
+            written = self._pyfhel.afseal.save_ciphertext(
+                out_ptr, size, bcompr_mode, deref(self._ptr_ctxt))
+        return out if written == size else out[:written]
 
     cpdef size_t load(self, str fileName, object scheme=None):
         """load(self, str fileName, scheme)
@@ -273,21 +376,24 @@ cdef class PyCtxt:
         cdef string bFileName = _to_valid_file_str(fileName, check=True).encode('utf8')
         inputter = new ifstream(bFileName, binary)
         try:
-            size = self._pyfhel.afseal.load_ciphertext(
-                deref(inputter), deref(self._ptr_ctxt))
+            with nogil:
+                size = self._pyfhel.afseal.load_ciphertext(
+                    deref(inputter), deref(self._ptr_ctxt))
         finally:
             del inputter
+        self._expr = None
         if scheme is not None:
             self._scheme = to_Scheme_t(scheme).value
         return size
 
-    cpdef void from_bytes(self, bytes content, object scheme=None):
+    cpdef void from_bytes(self, const uint8_t[::1] content, object scheme=None):
         """from_bytes(bytes content, scheme)
 
         Recover the serialized ciphertext from a binary/bytes string.
 
         Args:
-            content (bytes):  Python bytes object containing the PyCtxt.
+            content (bytes, bytearray, memoryview):  bytes-like object containing
+                the PyCtxt, read in place.
             scheme (str, type, int, Scheme_t): One of the following:
 
                 * ('int', 'INTEGER', int, 1, Scheme_t.bfv) -> integer scheme.
@@ -301,9 +407,54 @@ cdef class PyCtxt:
         """
         if self._pyfhel is None:
             raise ValueError("<Pyfhel ERROR> ciphertext loading requires a Pyfhel instance")
-        cdef stringstream inputter
-        inputter.write(content,len(content))
-        self._pyfhel.afseal.load_ciphertext(inputter, deref(self._ptr_ctxt))
+        cdef const uint8_t* in_ptr = &content[0] if content.shape[0] else NULL
+        with nogil:
+            self._pyfhel.afseal.load_ciphertext(in_ptr, content.shape[0], deref(self._ptr_ctxt))
+        self._expr = None
+        if scheme is not None:
+            self._scheme = to_Scheme_t(scheme).value
+
+    def to_raw(self):
+        """to_raw() -> Tuple[tuple, memoryview]
+
+        Raw RNS data of the ciphertext, copied once and without serializing.
+
+        Return:
+            Tuple[tuple, memoryview]: header with the parameters, size, level
+                and scale of the ciphertext, and a read-only uint64 snapshot of
+                its RNS coefficients shaped (size, n_moduli, n)
+                (see :func:`__getbuffer__`).
+
+        See Also:
+            :func:`from_raw`
+        """
+        if self._pyfhel is None:
+            raise ValueError("<Pyfhel ERROR> ciphertext serializing requires a Pyfhel instance")
+        _ready(self)
+        return tuple(self._pyfhel.afseal.raw_header(deref(self._ptr_ctxt))), memoryview(self)
+
+    def from_raw(self, tuple header, data, object scheme=None):
+        """from_raw(tuple header, data, scheme=None)
+
+        Recover the ciphertext from the output of :func:`to_raw`, copying the
+        data once. The parameters must be those of the Pyfhel context.
+
+        Args:
+            header (tuple): header returned by :func:`to_raw`.
+            data (bytes-like): contiguous RNS coefficients.
+            scheme (str, type, int, Scheme_t, optional): scheme of the ciphertext.
+
+        Return:
+            None
+        """
+        if self._pyfhel is None:
+            raise ValueError("<Pyfhel ERROR> ciphertext loading requires a Pyfhel instance")
+        cdef vector[uint64_t] vheader = header
+        cdef const uint8_t[::1] content = memoryview(data).cast('B')
+        cdef const uint8_t* in_ptr = &content[0] if content.shape[0] else NULL
+        with nogil:
+            self._pyfhel.afseal.load_raw(deref(self._ptr_ctxt), vheader, in_ptr, content.shape[0])
+        self._expr = None
         if scheme is not None:
             self._scheme = to_Scheme_t(scheme).value
 
@@ -318,6 +469,7 @@ cdef class PyCtxt:
         """
         if self._pyfhel is None:
             raise ValueError("<Pyfhel ERROR> ciphertext sizing requires a Pyfhel instance")
+        _ready(self)
         cdef string bcompr_mode = compr_mode.lower().encode('utf8')
         return self._pyfhel.afseal.sizeof_ciphertext(bcompr_mode, deref(self._ptr_ctxt))
 
@@ -325,11 +477,45 @@ cdef class PyCtxt:
     # =========================================================================
     # ============================= OPERATIONS ================================
     # =========================================================================          
+    cdef bool _is_lazy(self):
+        return self._pyfhel is not None and self._pyfhel._lazy
+
+    cdef PyCtxt _lazy_op(self, graph_op_t op, object other=None, int k=0):
+        """Records `op` in a new lazy ciphertext instead of computing it.
+
+        Numeric operands are kept as raw values, encoded by the backend at the
+        level and scale of the other operand when the graph is evaluated.
+        """
+        if isinstance(other, (PyCtxt, PyPtxt)):
+            if other.scheme != self.scheme:
+                raise RuntimeError(f"<Pyfhel ERROR> scheme type mistmatch in lazy operands"
+                                   f" ({self.scheme} VS {other.scheme})")
+        elif other is not None:
+            other = np.asarray(other)
+            if np.issubdtype(other.dtype, np.complexfloating):
+                other = self.encode_operand(other)
+            elif other.ndim > 1 or not np.issubdtype(other.dtype, np.number):
+                raise TypeError("<Pyfhel ERROR> operand must be numeric, 1D array, "
+                                "PyCtxt or PyPtxt (is %s instead)"%(type(other)))
+            else:
+                nslots = self._pyfhel.get_nSlots()
+                if other.ndim == 0:
+                    other = np.repeat(other, nslots)
+                other = np.ascontiguousarray(other[:nslots],
+                    dtype=np.float64 if self._scheme == scheme_t.ckks else np.int64)
+        cdef PyCtxt res = PyCtxt(pyfhel=self._pyfhel)
+        res._scheme = self._scheme
+        res._mod_level = self._mod_level
+        res._expr = (<uint8_t>op, self, other, k)
+        return res
+
     def __neg__(self):
         """__neg__()
         
         Negates this ciphertext.
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.negate)
         return self._pyfhel.negate(self, in_new_ctxt=True)
         
     def __add__(self, other):
@@ -351,6 +537,8 @@ cdef class PyCtxt:
         See Also:
             :func:`~Pyfhel.Pyfhel.add`
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.add, other)
         other_ = self.encode_operand(other)
         self_, other_ = self._pyfhel.align_mod_n_scale(self, other_, 
                                     copy_other=(other_ is other))
@@ -373,6 +561,8 @@ cdef class PyCtxt:
         Raise:
             TypeError: if other doesn't have a valid type.
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.add, other)
         other_ = self.encode_operand(other)
         _, other_ = self._pyfhel.align_mod_n_scale(self, other_,
                                 copy_this=False, copy_other=(other_ is other))
@@ -409,6 +599,8 @@ cdef class PyCtxt:
         See Also:
             :func:`~Pyfhel.Pyfhel.sub`
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.sub, other)
         other_ = self.encode_operand(other)
         self_, other_ = self._pyfhel.align_mod_n_scale(self, other_, 
                                     copy_other=(other_ is other))
@@ -431,6 +623,8 @@ cdef class PyCtxt:
         Raise:
             TypeError: if other doesn't have a valid type.
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.sub, other)
         other_ = self.encode_operand(other)
         _, other_ = self._pyfhel.align_mod_n_scale(self, other_,
                                 copy_this=False, copy_other=(other_ is other))
@@ -459,6 +653,8 @@ cdef class PyCtxt:
         See Also:
             :func:`~Pyfhel.Pyfhel.multiply`
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.multiply, other)
         other_ = self.encode_operand(other)
         this, other_ = self._pyfhel.align_mod_n_scale(self, other_, copy_this=True,
                                 copy_other=(other_ is other), only_mod=True)
@@ -485,6 +681,8 @@ cdef class PyCtxt:
         Raise:
             TypeError: if other doesn't have a valid type.
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.multiply, other)
         other_ = self.encode_operand(other)
         _, other_ = self._pyfhel.align_mod_n_scale(self, other_,copy_this=False,
                                 copy_other=(other_ is other), only_mod=True)
@@ -573,6 +771,8 @@ cdef class PyCtxt:
             divisor = divisor.decode()
         # Compute inverse. Int: https://stackoverflow.com/questions/4798654
         inversePtxt = self.get_multiplicative_inverse(divisor)
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.multiply, inversePtxt)
         self_, _ = self._pyfhel.align_mod_n_scale(self, inversePtxt,
                                           copy_this=True, copy_other=False)
         return self_._pyfhel.multiply_plain(self_, inversePtxt, in_new_ctxt=False)
@@ -598,11 +798,26 @@ cdef class PyCtxt:
         if isinstance(divisor, PyPtxt): # If ptxt, decode to get inverse
             divisor = divisor.decode()
         inversePtxt = self.get_multiplicative_inverse(divisor)
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.multiply, inversePtxt)
         self_, _ = self._pyfhel.align_mod_n_scale(self, inversePtxt,
                                           copy_this=False, copy_other=False)
         return self_._pyfhel.multiply_plain(self_, inversePtxt, in_new_ctxt=False)
 
                                     
+    cdef PyCtxt _lazy_pow(self, object exponent):
+        """Lazy exponentiation by squaring, as a chain of multiply nodes"""
+        if exponent < 1:
+            raise ValueError("<Pyfhel ERROR> exponent must be a positive integer")
+        cdef PyCtxt result = None, base = self
+        while True:
+            if exponent & 1:
+                result = base if result is None else result._lazy_op(graph_op_t.multiply, base)
+            exponent >>= 1
+            if not exponent:
+                return result
+            base = base._lazy_op(graph_op_t.multiply, base)
+
     def __pow__(self, exponent, modulo):
         """__pow__(exponent)
         
@@ -616,6 +831,8 @@ cdef class PyCtxt:
         See Also:
             :func:`~Pyfhel.Pyfhel.power`
         """
+        if self._is_lazy():
+            return self._lazy_pow(exponent)
         if(exponent==2):
             return self._pyfhel.square(self, in_new_ctxt=True)  
         else:
@@ -629,6 +846,8 @@ cdef class PyCtxt:
         Args:
             exponent (int): Exponent for the power.
         """
+        if self._is_lazy():
+            return self._lazy_pow(exponent)
         if(exponent==2):
             self._pyfhel.square(self, in_new_ctxt=False)  
         else:
@@ -643,6 +862,8 @@ cdef class PyCtxt:
         Args:
             k (int): Number of positions to rotate.
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.rotate, None, -k)
         return self._pyfhel.rotate(self, -k, in_new_ctxt=True)
 
     def __irshift__(self, k):
@@ -651,6 +872,8 @@ cdef class PyCtxt:
         Args:
             k (int): Number of positions to rotate.
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.rotate, None, -k)
         self._pyfhel.rotate(self, -k, in_new_ctxt=False)
         return self
 
@@ -660,6 +883,8 @@ cdef class PyCtxt:
         Args:
             k (int): Number of positions to rotate.
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.rotate, None, k)
         return self._pyfhel.rotate(self, k, in_new_ctxt=True)
 
     def __ilshift__(self, k):
@@ -668,6 +893,8 @@ cdef class PyCtxt:
         Args:
             k (int): Number of positions to rotate.
         """
+        if self._is_lazy():
+            return self._lazy_op(graph_op_t.rotate, None, k)
         self._pyfhel.rotate(self, k, in_new_ctxt=False)
         return self
 
@@ -681,6 +908,8 @@ cdef class PyCtxt:
         See Also:
             :func:`~Pyfhel.Pyfhel.relinearize`
         """
+        if self._is_lazy():
+            return self     # relinearized when evaluated
         self._pyfhel.relinearize(self)
         return self
     def __xor__(self, k):
@@ -694,6 +923,8 @@ cdef class PyCtxt:
             :func:`~Pyfhel.Pyfhel.flip`
         """
         if self.scheme == Scheme_t.bfv:
+            if self._is_lazy():
+                return self._lazy_op(graph_op_t.flip)
             return self._pyfhel.flip(self, in_new_ctxt=True)
         else:
             return self
@@ -708,6 +939,8 @@ cdef class PyCtxt:
             :func:`~Pyfhel.Pyfhel.flip`
         """
         if self.scheme == Scheme_t.bfv:
+            if self._is_lazy():
+                return self._lazy_op(graph_op_t.flip)
             return self._pyfhel.flip(self, in_new_ctxt=False)
         else:
             return self
@@ -724,12 +957,16 @@ cdef class PyCtxt:
         See Also:
             :func:`~Pyfhel.PyCtxt.size`
         """
+        _ready(self)
         return <int64_t>(deref(_dyn_c(self._ptr_ctxt))).size()
     
     def __repr__(self):
         """__repr__()
         
         Prints information about the current ciphertext"""
+        if self._expr is not None:
+            return "<Pyfhel Ciphertext at {}, scheme={}, lazy>".format(
+                hex(id(self)), self.scheme.name)
         if self.scheme==Scheme_t.bfv or self.scheme==Scheme_t.bgv:
             scheme_dep_info = 'noiseBudget=' + str(self.noiseBudget) \
                                             if self.noiseBudget!=-1 else "?"
@@ -772,6 +1009,7 @@ cdef class PyCtxt:
         See Also:
             :func:`~Pyfhel.Pyfhel.encrypt`
         """
+        self._expr = None
         self._pyfhel.encrypt(ptxt=value, ctxt=self, scale=self.scale)
     
     def decrypt(self):
@@ -852,6 +1090,12 @@ cdef class PyCtxt:
 
 
 
+def _ctxt_from_raw(Pyfhel pyfhel, tuple header, data, scheme):
+    """Unpickles a PyCtxt pickled out-of-band with protocol 5."""
+    cdef PyCtxt ctxt = PyCtxt(pyfhel=pyfhel)
+    ctxt.from_raw(header, data, scheme)
+    return ctxt
+
 # cdef class PyArrCtxt:
 #     cdef Py_ssize_t ncols
 #     cdef Py_ssize_t shape[2]
@@ -35,7 +35,7 @@ cdef class PyPoly:
                 self._pyfhel = ref._pyfhel
             elif ptxt is not None:  # Construct from Poly in PyPtxt `ptxt`
                 self._afpoly =\
-                    new AfsealPoly(deref(<Afseal*>ref._pyfhel.afseal), deref(<AfsealPtxt*>ptxt._ptr_ptxt), deref(_dyn_c(ref._ptr_ctxt)))  
+                    new AfsealPoly(deref(<Afseal*>ref._pyfhel.afseal), deref(<AfsealPtxt*>ptxt._ptr_ptxt.get()), deref(_dyn_c(ref._ptr_ctxt)))  
                 self._pyfhel = ptxt._pyfhel
             else:                   # Base constructor
                 self._afpoly =\
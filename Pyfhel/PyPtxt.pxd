@@ -5,6 +5,7 @@
 # Import from Cython libs required C/C++ types for the Afhel API
 from libcpp.string cimport string
 from libcpp cimport bool
+from libcpp.memory cimport shared_ptr, make_shared, dynamic_pointer_cast as dyn_cast
 
 # Used for all kinds of operations
 from Pyfhel.Pyfhel cimport *
@@ -18,16 +19,18 @@ from Pyfhel.Afhel.Afhel cimport AfPtxt, AfsealPtxt, scheme_t, backend_t
 # ------------------------------- DECLARATION ---------------------------------
 
 cdef class PyPtxt:
-    cdef AfPtxt* _ptr_ptxt
+    cdef shared_ptr[AfPtxt] _ptr_ptxt
     cdef Pyfhel _pyfhel
     cdef scheme_t _scheme
     cdef backend_t _backend
     cdef int _mod_level
+    cdef bool _ntt_cache         # multiply_plain uses per-level NTT copies
+    cdef dict _ntt               # mod_level -> NTT PyPtxt, dropped on rewrite
     cpdef bool is_zero(self)
     cpdef bool is_ntt_form(self)
     cpdef string to_poly_string(self)
     cpdef void save(self, str fileName, str compr_mode=*)
     cpdef void load(self, str fileName, object scheme=*)
     cpdef bytes to_bytes(self, str compr_mode=*)
-    cpdef void from_bytes(self, bytes content, object scheme=*)
+    cpdef void from_bytes(self, const uint8_t[::1] content, object scheme=*)
     cpdef void set_scale (self, double new_scale)
\ No newline at end of file
@@ -7,11 +7,16 @@ from .utils import Scheme_t, Backend_t, _to_valid_file_str
 
 # Dereferencing pointers in Cython in a secure way
 from cython.operator cimport dereference as deref
+from cpython.bytes cimport PyBytes_FromStringAndSize, PyBytes_AS_STRING
+from cpython.buffer cimport PyBUF_FORMAT, PyBUF_WRITABLE
+from cpython.mem cimport PyMem_Malloc, PyMem_Free
+from libc.string cimport memcpy
 
 # Import Abstract Plaintext class
 from Pyfhel.Afhel.Afhel cimport *
 
 import numpy as np
+from pickle import PickleBuffer
 
 # ----------------------------- IMPLEMENTATION --------------------------------
 cdef class PyPtxt:
@@ -22,7 +27,11 @@ cdef class PyPtxt:
 
     Attributes:
         other_ptxt (PyPtxt, optional): Other PyPtxt to deep copy
-    
+
+    Thread safety:
+        A PyPtxt can be read (used as an operand, saved, serialized) from several
+        threads at once, but must not be modified (encode, load, from_bytes)
+        while other threads access it. See :class:`~Pyfhel.Pyfhel`.
     """
     
     def __cinit__(self, 
@@ -32,12 +41,12 @@ cdef class PyPtxt:
                   bytestring=None,
                   scheme=None):
         if (copy_ptxt): # If there is a PyPtxt to copy, override all arguments and copy
-            self._ptr_ptxt = new AfsealPtxt(deref(<AfsealPtxt*>copy_ptxt._ptr_ptxt))
+            self._ptr_ptxt = make_shared[AfsealPtxt](deref(dyn_cast[AfsealPtxt,AfPtxt](copy_ptxt._ptr_ptxt)))
             self._scheme = copy_ptxt._scheme
             if (copy_ptxt._pyfhel):
                 self._pyfhel = copy_ptxt._pyfhel
         else:
-            self._ptr_ptxt = new AfsealPtxt()
+            self._ptr_ptxt = make_shared[AfsealPtxt]()
             if pyfhel:
                 self._pyfhel = pyfhel
                 self._scheme = self._pyfhel.afseal.get_scheme()
@@ -76,10 +85,6 @@ cdef class PyPtxt:
         """
         pass
 
-    def __dealloc__(self):
-        if self._ptr_ptxt != NULL:
-            del self._ptr_ptxt
-            
     @property
     def scheme(self):
         """scheme: returns the scheme type.
@@ -101,7 +106,7 @@ cdef class PyPtxt:
     @property
     def scale(self):
         """double: multiplying factor to encode values in ckks."""
-        return (<AfsealPtxt*>(self._ptr_ptxt)).scale()
+        return (<AfsealPtxt*>(self._ptr_ptxt.get())).scale()
     @scale.setter
     def scale(self, new_scale):
         self.set_scale(new_scale)
@@ -109,7 +114,7 @@ cdef class PyPtxt:
     @property
     def scale_bits(self):
         """int: number of bits in scale to encode values in ckks"""
-        return <int>np.log2( (<AfsealPtxt*>(self._ptr_ptxt)).scale() )
+        return <int>np.log2( (<AfsealPtxt*>(self._ptr_ptxt.get())).scale() )
         
     @property
     def _pyfhel(self):
@@ -137,15 +142,35 @@ cdef class PyPtxt:
 
     cpdef bool is_zero(self):
         """bool: Flag to quickly check if it is empty"""
-        return (<AfsealPtxt*>self._ptr_ptxt).is_zero()
+        return (<AfsealPtxt*>self._ptr_ptxt.get()).is_zero()
 
     cpdef string to_poly_string(self):
         """str: Polynomial representation of the plaintext"""
-        return (<AfsealPtxt*>self._ptr_ptxt).to_string()
+        return (<AfsealPtxt*>self._ptr_ptxt.get()).to_string()
     
     cpdef bool is_ntt_form(self):
         """bool: Flag to quickly check if it is in NTT form"""
-        return (<AfsealPtxt*>self._ptr_ptxt).is_ntt_form()
+        return (<AfsealPtxt*>self._ptr_ptxt.get()).is_ntt_form()
+
+    @property
+    def ntt_cache(self):
+        """bool: Cache the NTT form of this plaintext at each level.
+
+        When set, multiply_plain transforms the plaintext to NTT form at the
+        ciphertext's level once, and reuses it in every later product at that
+        level (bfv/bgv). In ckks the mod-switched copies are cached instead,
+        and also align the plaintext with lower-level ciphertexts in the
+        PyCtxt operators (see :func:`~Pyfhel.Pyfhel.align_mod_n_scale`).
+        Re-encoding, decrypting into or loading the plaintext clears the cache.
+
+        See Also:
+            :func:`~Pyfhel.Pyfhel.plain_to_ntt`
+        """
+        return self._ntt_cache
+    @ntt_cache.setter
+    def ntt_cache(self, value):
+        self._ntt_cache = True if value else False
+        self._ntt = None
     
     
     # =========================================================================
@@ -159,6 +184,56 @@ cdef class PyPtxt:
             - A tuple of arguments for the callable object.
         """
         return (PyPtxt, (None, self._pyfhel, None, self.to_bytes(), self.scheme.name))
+
+    def __reduce_ex__(self, protocol):
+        """__reduce_ex__(protocol)
+
+        Pickling with protocol 5 hands the raw coefficients as an out-of-band
+        `PickleBuffer` (see :func:`to_raw`). Older protocols fall back to
+        :func:`__reduce__`.
+        """
+        if protocol < 5 or self._pyfhel is None:
+            return self.__reduce__()
+        header, data = self.to_raw()
+        if header[4] == 0:      # Empty plaintext, no coefficients
+            return self.__reduce__()
+        return (_ptxt_from_raw, (self._pyfhel, header, PickleBuffer(data), self.scheme.name))
+
+    def __getbuffer__(self, Py_buffer *buffer, int flags):
+        """Exposes the plaintext coefficients as uint64.
+
+        The buffer is a read-only snapshot owned by the view, so that later
+        encodings or loads into the plaintext leave it untouched.
+        """
+        if self._pyfhel is None:
+            raise ValueError("<Pyfhel ERROR> plaintext buffer export requires a Pyfhel instance")
+        if flags & PyBUF_WRITABLE:
+            raise BufferError("<Pyfhel ERROR> plaintext buffers are read-only")
+        cdef vector[uint64_t] header = self._pyfhel.afseal.raw_header(deref(self._ptr_ptxt))
+        cdef size_t nbytes = header[4] * sizeof(uint64_t)
+        # shape and strides are stored in the same block, ahead of the data
+        cdef Py_ssize_t *dims = <Py_ssize_t*>PyMem_Malloc(2 * sizeof(Py_ssize_t) + nbytes)
+        if dims == NULL:
+            raise MemoryError()
+        dims[0] = header[4]
+        dims[1] = sizeof(uint64_t)
+        memcpy(&dims[2], self._pyfhel.afseal.raw_data(deref(self._ptr_ptxt)), nbytes)
+        buffer.buf = &dims[2]
+        buffer.format = NULL
+        if flags & PyBUF_FORMAT:
+            buffer.format = 'Q'
+        buffer.internal = dims
+        buffer.itemsize = sizeof(uint64_t)
+        buffer.len = nbytes
+        buffer.ndim = 1
+        buffer.obj = self
+        buffer.readonly = 1
+        buffer.shape = dims
+        buffer.strides = &dims[1]
+        buffer.suboffsets = NULL
+
+    def __releasebuffer__(self, Py_buffer *buffer):
+        PyMem_Free(buffer.internal)
     
     
     
@@ -182,7 +257,8 @@ cdef class PyPtxt:
         cdef string bcompr_mode = compr_mode.encode('utf8')
         outputter = new ofstream(bFileName, binary)
         try:
-            self._pyfhel.afseal.save_plaintext(deref(outputter), bcompr_mode, deref(self._ptr_ptxt))
+            with nogil:
+                self._pyfhel.afseal.save_plaintext(deref(outputter), bcompr_mode, deref(self._ptr_ptxt))
         finally:
             del outputter
 
@@ -199,10 +275,16 @@ cdef class PyPtxt:
         """
         if self._pyfhel is None:
             raise ValueError("<Pyfhel ERROR> plaintext serialization requires a Pyfhel instance")
-        cdef ostringstream outputter
         cdef string bcompr_mode = compr_mode.encode('utf8')
-        self._pyfhel.afseal.save_plaintext(outputter, bcompr_mode, deref(self._ptr_ptxt))
-        return outputter.str()
+        cdef size_t size, written
+        # Serialized straight into the bytes object, sized to an upper bound
+        size = self._pyfhel.afseal.sizeof_plaintext(bcompr_mode, deref(self._ptr_ptxt))
+        cdef bytes out = PyBytes_FromStringAndSize(NULL, size)
+        cdef uint8_t* out_ptr = <uint8_t*>PyBytes_AS_STRING(out)
+        with nogil:
+            written = self._pyfhel.afseal.save_plaintext(
+                out_ptr, size, bcompr_mode, deref(self._ptr_ptxt))
+        return out if written == size else out[:written]
 
     cpdef void load(self, str fileName, object scheme=None):
         """load(self, str fileName, scheme)
@@ -224,19 +306,22 @@ cdef class PyPtxt:
         cdef string bFileName = _to_valid_file_str(fileName, check=True).encode('utf8')
         inputter = new ifstream(bFileName, binary)
         try:
-            self._pyfhel.afseal.load_plaintext(deref(inputter), deref(self._ptr_ptxt))
+            with nogil:
+                self._pyfhel.afseal.load_plaintext(deref(inputter), deref(self._ptr_ptxt))
         finally:
             del inputter
+        self._ntt = None
         if scheme is not None:
             self.scheme = to_Scheme_t(scheme)
 
-    cpdef void from_bytes(self, bytes content, object scheme=None):
+    cpdef void from_bytes(self, const uint8_t[::1] content, object scheme=None):
         """from_bytes(bytes content)
 
         Recover the serialized plaintext from a binary/bytes string.
 
         Args:
-            content: (:obj:`bytes`) Python bytes object containing the PyPtxt.
+            content: (:obj:`bytes`) bytes-like object containing the PyPtxt,
+              read in place.
             scheme: (:obj: `str`) String or type describing the scheme:
               * ('int', 'integer', int, 1, scheme_t.bfv) -> integer scheme.
               * ('float', 'double', float, 2, scheme_t.ckks) -> fractional scheme.
@@ -244,9 +329,49 @@ cdef class PyPtxt:
         """
         if self._pyfhel is None:
             raise ValueError("<Pyfhel ERROR> plaintext loading requires a Pyfhel instance")
-        cdef stringstream inputter
-        inputter.write(content,len(content))
-        self._pyfhel.afseal.load_plaintext(inputter, deref(self._ptr_ptxt))
+        cdef const uint8_t* in_ptr = &content[0] if content.shape[0] else NULL
+        with nogil:
+            self._pyfhel.afseal.load_plaintext(in_ptr, content.shape[0], deref(self._ptr_ptxt))
+        self._ntt = None
+        if scheme is not None:
+            self.scheme = to_Scheme_t(scheme)
+
+    def to_raw(self):
+        """to_raw() -> Tuple[tuple, memoryview]
+
+        Raw coefficients of the plaintext, copied once and without serializing.
+
+        Return:
+            Tuple[tuple, memoryview]: header with the parameters, coefficient
+                count and scale of the plaintext, and a read-only uint64
+                snapshot of its coefficients.
+
+        See Also:
+            :func:`from_raw`
+        """
+        if self._pyfhel is None:
+            raise ValueError("<Pyfhel ERROR> plaintext serialization requires a Pyfhel instance")
+        return tuple(self._pyfhel.afseal.raw_header(deref(self._ptr_ptxt))), memoryview(self)
+
+    def from_raw(self, tuple header, data, object scheme=None):
+        """from_raw(tuple header, data, scheme=None)
+
+        Recover the plaintext from the output of :func:`to_raw`, copying the
+        data once. The parameters must be those of the Pyfhel context.
+
+        Args:
+            header (tuple): header returned by :func:`to_raw`.
+            data (bytes-like): contiguous coefficients.
+            scheme (str, type, int, Scheme_t, optional): scheme of the plaintext.
+        """
+        if self._pyfhel is None:
+            raise ValueError("<Pyfhel ERROR> plaintext loading requires a Pyfhel instance")
+        cdef vector[uint64_t] vheader = header
+        cdef const uint8_t[::1] content = memoryview(data).cast('B')
+        cdef const uint8_t* in_ptr = &content[0] if content.shape[0] else NULL
+        with nogil:
+            self._pyfhel.afseal.load_raw(deref(self._ptr_ptxt), vheader, in_ptr, content.shape[0])
+        self._ntt = None
         if scheme is not None:
             self.scheme = to_Scheme_t(scheme)
 
@@ -322,4 +447,11 @@ cdef class PyPtxt:
         Args:
             scale (double): new scale of the ciphertext.
         """
-        (<AfsealPtxt*>(self._ptr_ptxt)).set_scale(new_scale)
+        (<AfsealPtxt*>(self._ptr_ptxt.get())).set_scale(new_scale)
+
+
+def _ptxt_from_raw(Pyfhel pyfhel, tuple header, data, scheme):
+    """Unpickles a PyPtxt pickled out-of-band with protocol 5."""
+    cdef PyPtxt ptxt = PyPtxt(pyfhel=pyfhel)
+    ptxt.from_raw(header, data, scheme)
+    return ptxt
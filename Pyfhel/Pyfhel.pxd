@@ -10,6 +10,7 @@ from libcpp.vector cimport vector
 from libcpp.string cimport string
 from libcpp.cast cimport reinterpret_cast
 from libcpp.memory cimport shared_ptr, make_shared, dynamic_pointer_cast as dyn_cast
+from libcpp.map cimport map as cpp_map
 from libcpp cimport bool
 
 ctypedef long long int64_t
@@ -31,6 +32,9 @@ cdef class Pyfhel:
     cdef int _sec
     cdef vector[int] _qi_sizes
     cdef double _scale
+    cdef bool _lazy              # PyCtxt operators build expression graphs
+    cdef bool _rot_dry_run       # Rotations are only recorded, not performed
+    cdef shared_ptr[Afseal] _tenant  # Registry entry, not evicted while held
     # =========================== CRYPTOGRAPHY =================================
     # CONTEXT & KEY GENERATION
     cpdef string contextGen(self,
@@ -40,6 +44,8 @@ cdef class Pyfhel:
     cpdef void keyGen(self) 
     cpdef void relinKeyGen(self) 
     cpdef void rotateKeyGen(self, vector[int] rot_steps =*) 
+    cpdef void start_rotation_record(self, bool dry_run=*)
+    cpdef dict stop_rotation_record(self)
     
     # ENCRYPTION
     cpdef PyCtxt encryptInt(self, int64_t[:] arr, PyCtxt ctxt=*)
@@ -48,6 +54,8 @@ cdef class Pyfhel:
     cpdef PyCtxt encryptComplex(self, complex[:] arr, PyCtxt ctxt=*, 
                                         double scale=*, int scale_bits=*) 
     cpdef PyCtxt encryptPtxt(self, PyPtxt ptxt, PyCtxt ctxt=*) 
+    cpdef PyCtxt encrypt_symmetric(self, object ptxt, PyCtxt ctxt=*)
+    cpdef bytes encrypt_symmetric_bytes(self, object ptxt, str compr_mode=*)
     cpdef PyCtxt encryptBGV(self, int64_t[:] arr, PyCtxt ctxt=*)
     # vectorized
     cpdef np.ndarray[object, ndim=1] encryptAInt(self, int64_t[:,::1] arr) 
@@ -55,21 +63,21 @@ cdef class Pyfhel:
                                         double scale=*, int scale_bits=*) 
     cpdef np.ndarray[object, ndim=1] encryptAComplex(self, complex[:,::1] arr,
                                         double scale=*, int scale_bits=*) 
-    cpdef np.ndarray[object, ndim=1] encryptAPtxt(self, PyPtxt[:] ptxt)
+    cpdef np.ndarray[object, ndim=1] encryptAPtxt(self, object ptxt)
     cpdef np.ndarray[object, ndim=1] encryptABGV(self, int64_t[:,::1] arr)
 
     # DECRYPTION
-    cpdef np.ndarray[int64_t, ndim=1] decryptInt(self, PyCtxt ctxt) 
-    cpdef np.ndarray[double, ndim=1] decryptFrac(self, PyCtxt ctxt) 
-    cpdef np.ndarray[complex, ndim=1] decryptComplex(self, PyCtxt ctxt) 
+    cpdef np.ndarray[int64_t, ndim=1] decryptInt(self, PyCtxt ctxt, object out=*) 
+    cpdef np.ndarray[double, ndim=1] decryptFrac(self, PyCtxt ctxt, object out=*) 
+    cpdef np.ndarray[complex, ndim=1] decryptComplex(self, PyCtxt ctxt, object out=*) 
     cpdef PyPtxt decryptPtxt(self, PyCtxt ctxt, PyPtxt ptxt=*) 
-    cpdef np.ndarray[int64_t, ndim=1] decryptBGV(self, PyCtxt ctxt)
+    cpdef np.ndarray[int64_t, ndim=1] decryptBGV(self, PyCtxt ctxt, object out=*)
     # vectorized
-    cpdef np.ndarray[int64_t, ndim=2] decryptAInt(self, PyCtxt ctxt) 
-    cpdef np.ndarray[double, ndim=2] decryptAFrac(self, PyCtxt ctxt) 
-    cpdef np.ndarray[double, ndim=2] decryptAComplex(self, PyCtxt ctxt) 
-    cpdef np.ndarray[object, ndim=1] decryptAPtxt(self, PyCtxt ctxt) 
-    cpdef np.ndarray[int64_t, ndim=2] decryptABGV(self, PyCtxt ctxt)
+    cpdef np.ndarray[int64_t, ndim=2] decryptAInt(self, object ctxt) 
+    cpdef np.ndarray[double, ndim=2] decryptAFrac(self, object ctxt) 
+    cpdef np.ndarray[complex, ndim=2] decryptAComplex(self, object ctxt) 
+    cpdef np.ndarray[object, ndim=1] decryptAPtxt(self, object ctxt) 
+    cpdef np.ndarray[int64_t, ndim=2] decryptABGV(self, object ctxt)
     
     # NOISE LEVEL    
     cpdef int noise_level(self, PyCtxt ctxt)
@@ -91,15 +99,15 @@ cdef class Pyfhel:
     cpdef np.ndarray[object, ndim=1] encodeABGV(self, int64_t[:,::1] arr)
 
     # DECODE
-    cpdef np.ndarray[int64_t, ndim=1] decodeInt(self, PyPtxt ptxt) 
-    cpdef np.ndarray[double, ndim=1] decodeFrac(self, PyPtxt ptxt) 
-    cpdef np.ndarray[complex, ndim=1] decodeComplex(self, PyPtxt ptxt) 
-    cpdef np.ndarray[int64_t, ndim=1] decodeBGV(self, PyPtxt ptxt)
+    cpdef np.ndarray[int64_t, ndim=1] decodeInt(self, PyPtxt ptxt, object out=*) 
+    cpdef np.ndarray[double, ndim=1] decodeFrac(self, PyPtxt ptxt, object out=*) 
+    cpdef np.ndarray[complex, ndim=1] decodeComplex(self, PyPtxt ptxt, object out=*) 
+    cpdef np.ndarray[int64_t, ndim=1] decodeBGV(self, PyPtxt ptxt, object out=*)
     # vectorized
-    cpdef np.ndarray[int64_t, ndim=2] decodeAInt(self, PyPtxt[:] ptxt) 
-    cpdef np.ndarray[double, ndim=2] decodeAFrac(self, PyPtxt[:] ptxt) 
-    cpdef np.ndarray[complex, ndim=2] decodeAComplex(self, PyPtxt[:] ptxt) 
-    cpdef np.ndarray[int64_t, ndim=2] decodeABGV(self, PyPtxt[:] ptxt)
+    cpdef np.ndarray[int64_t, ndim=2] decodeAInt(self, object ptxt) 
+    cpdef np.ndarray[double, ndim=2] decodeAFrac(self, object ptxt) 
+    cpdef np.ndarray[complex, ndim=2] decodeAComplex(self, object ptxt) 
+    cpdef np.ndarray[int64_t, ndim=2] decodeABGV(self, object ptxt)
     
     # RELINEARIZE
     cpdef void relinearize(self, PyCtxt ctxt) 
@@ -110,6 +118,8 @@ cdef class Pyfhel:
     cpdef PyCtxt add(self, PyCtxt ctxt, PyCtxt ctxt_other, bool in_new_ctxt=*) 
     cpdef PyCtxt add_plain(self, PyCtxt ctxt, PyPtxt ptxt, bool in_new_ctxt=*)
     cpdef PyCtxt cumul_add(self, PyCtxt ctxt, bool in_new_ctxt=*, size_t n_elements=*) 
+    cpdef PyCtxt add_many(self, object ctxts)
+    cpdef PyCtxt multiply_many(self, object ctxts)
     cpdef PyCtxt sub(self, PyCtxt ctxt, PyCtxt ctxt_other, bool in_new_ctxt=*) 
     cpdef PyCtxt sub_plain(self, PyCtxt ctxt, PyPtxt ptxt, bool in_new_ctxt=*) 
     cpdef PyCtxt multiply(self, PyCtxt ctxt, PyCtxt ctxt_other, bool in_new_ctxt=*) 
@@ -118,44 +128,51 @@ cdef class Pyfhel:
         bool in_new_ctxt=*, bool with_relin=*, bool with_mod_switch=*, size_t n_elements=*)
     cpdef PyCtxt scalar_prod_plain(self, PyCtxt ctxt, PyPtxt ptxt_other,
         bool in_new_ctxt=*, bool with_relin=*, bool with_mod_switch=*, size_t n_elements=*)
+    cpdef np.ndarray[object, ndim=1] encode_matrix(self, object matrix, double scale=*, int scale_bits=*)
+    cpdef PyCtxt matvec_plain(self, PyCtxt ctxt, object matrix, bool in_new_ctxt=*)
     cpdef PyCtxt rotate(self, PyCtxt ctxt, int k, bool in_new_ctxt=*)
     cpdef PyCtxt flip(self, PyCtxt ctxt, bool in_new_ctxt=*)
+    cpdef np.ndarray[object, ndim=1] rotate_many(self, PyCtxt ctxt, vector[int] steps)
     cpdef PyCtxt power(self, PyCtxt ctxt, uint64_t expon, bool in_new_ctxt=*) 
+    cpdef void eval_lazy(self, object ctxts)
     # ckks
     cpdef void rescale_to_next(self, PyCtxt ctxt) 
     cpdef PyCtxt mod_switch_to_next_ctxt(self, PyCtxt ctxt, bool in_new_ctxt=*)
     cpdef PyPtxt mod_switch_to_next_ptxt(self, PyPtxt ptxt, bool in_new_ptxt=*)
+    cpdef PyPtxt plain_to_ntt(self, PyPtxt ptxt, object mod_level=*, bool in_new_ptxt=*)
     # ================================ I/O =====================================
     # FILES
     cpdef size_t save_context(self, fileName, str compr_mode=*) 
     cpdef size_t load_context(self, fileName) 
 
-    cpdef size_t save_public_key(self, fileName, str compr_mode=*) 
+    cpdef size_t save_public_key(self, fileName, str compr_mode=*, bool seeded=*)
     cpdef size_t load_public_key(self, fileName) 
 
     cpdef size_t save_secret_key(self, fileName, str compr_mode=*) 
     cpdef size_t load_secret_key(self, fileName) 
 
-    cpdef size_t save_relin_key(self, fileName, str compr_mode=*) 
+    cpdef size_t save_relin_key(self, fileName, str compr_mode=*, bool seeded=*)
     cpdef size_t load_relin_key(self, fileName) 
 
-    cpdef size_t save_rotate_key(self, fileName, str compr_mode=*) 
+    cpdef size_t save_rotate_key(self, fileName, str compr_mode=*, bool seeded=*)
     cpdef size_t load_rotate_key(self, fileName) 
+    cpdef size_t save_rotate_key_store(self, fileName)
+    cpdef size_t load_rotate_key_store(self, fileName)
 
     # BYTES
     cpdef bytes to_bytes_context(self, str compr_mode=*) 
     cpdef size_t from_bytes_context(self, bytes content) 
 
-    cpdef bytes to_bytes_public_key(self, str compr_mode=*) 
+    cpdef bytes to_bytes_public_key(self, str compr_mode=*, bool seeded=*)
     cpdef size_t from_bytes_public_key(self, bytes content) 
 
     cpdef bytes to_bytes_secret_key(self, str compr_mode=*) 
     cpdef size_t from_bytes_secret_key(self, bytes content) 
 
-    cpdef bytes to_bytes_relin_key(self, str compr_mode=*) 
+    cpdef bytes to_bytes_relin_key(self, str compr_mode=*, bool seeded=*)
     cpdef size_t from_bytes_relin_key(self, bytes content) 
 
-    cpdef bytes to_bytes_rotate_key(self, str compr_mode=*) 
+    cpdef bytes to_bytes_rotate_key(self, str compr_mode=*, bool seeded=*)
     cpdef size_t from_bytes_rotate_key(self, bytes content) 
 
     # SIZES
@@ -208,4 +225,11 @@ cdef void _read_cy_attributes(Pyfhel he, istream& istr)
 cpdef np.ndarray[dtype=np.int64_t, ndim=1] vec_to_array_i(vector[int64_t] vec)
 cpdef np.ndarray[dtype=np.uint64_t, ndim=1] vec_to_array_u(vector[uint64_t] vec)
 cpdef np.ndarray[dtype=double, ndim=1] vec_to_array_f(vector[double] vec)
-cdef shared_ptr[AfsealCtxt] _dyn_c(shared_ptr[AfCtxt] c)
\ No newline at end of file
+cdef shared_ptr[AfsealCtxt] _dyn_c(shared_ptr[AfCtxt] c)
+cdef np.ndarray _out_array(object out, size_t n, object dtype)
+cdef np.ndarray _new_ctxt_array(Pyfhel he, size_t n, scheme_t scheme, vector[shared_ptr[AfCtxt]]& ctxtV)
+cdef np.ndarray _new_ptxt_array(Pyfhel he, size_t n, scheme_t scheme, vector[shared_ptr[AfPtxt]]& ptxtV)
+cdef void _ready(PyCtxt c) except *
+cdef PyPtxt _ntt_for(Pyfhel he, PyPtxt ptxt, PyCtxt ctxt)
+cdef vector[shared_ptr[AfCtxt]] _ctxt_vector(object ctxts, scheme_t scheme) except *
+cdef vector[shared_ptr[AfPtxt]] _ptxt_vector(object ptxts, scheme_t scheme) except *
\ No newline at end of file
@@ -42,6 +42,7 @@ INT_T =   (int, np.int16, np.int32, np.int64, np.int_, np.intc)
 
 # Import utility functions
 from Pyfhel.utils import _to_valid_file_str
+from Pyfhel.utils.poly_approx import chebyshev_approx
 include "utils/cy_utils.pxi"
 include "utils/cy_type_converters.pxi"
 
@@ -53,22 +54,43 @@ cdef class Pyfhel:
     integers/doubles. Implementation of homomorphic encryption using 
     SEAL/PALISADE as backend. Pyfhel works with PyPtxt as plaintext class
     and PyCtxt as cyphertext class.
+
+    Thread safety:
+        All calls into the backend release the GIL, so several Python threads
+        sharing one Pyfhel object run their homomorphic operations in parallel.
+
+        - Safe to call concurrently: encryption/decryption, encoding/decoding,
+          arithmetic (add, multiply, rotate, relinearize, power, rescale...),
+          and saving/serializing keys, context, ciphertexts and plaintexts.
+          Each thread must operate in-place only on its own PyCtxt/PyPtxt
+          objects; operands that are only read may be shared. Under
+          `auto_relin`, serializing a size 3 ciphertext relinearizes it
+          in-place, so serialize it once before sharing it.
+        - Not safe to call concurrently with anything else on the same object:
+          contextGen, keyGen, relinKeyGen, rotateKeyGen and every load_*/from_bytes_*
+          method, since they replace the context or keys used by the rest.
+          Generate all required keys before spawning worker threads: relinearize,
+          rotate, flip and power generate missing keys on the fly.
     """
     def __cinit__(self,
                   context_params=None,
                   key_gen=False,
                   pub_key_file=None,
-                  sec_key_file=None):
+                  sec_key_file=None,
+                  eval_only=False):
         self.afseal = new Afseal()
         self._qi_sizes = []
         self._scale = 1
         self._sec = 128   # Default security: 128 bits
+        self._lazy = False
+        self._rot_dry_run = False
     
     def __init__(self,
                   context_params=None,
                   key_gen=False,
                   pub_key_file=None,
-                  sec_key_file=None):
+                  sec_key_file=None,
+                  eval_only=False):
         """Initializes an empty Pyfhel object, the base for all operations.
         
         To fill the Pyfhel object during initialization you can:
@@ -83,7 +105,10 @@ cdef class Pyfhel:
             key_gen (bool, optional): generate a new public/secret key pair
             pub_key_file (str|pathlib.Path, optional): Load public key from this file.
             sec_key_file (str|pathlib.Path, optional): Load secret key from this file.
+            eval_only (bool, optional): evaluation-only mode, see `eval_only`.
         """
+        if eval_only:
+            self.eval_only = True
         if context_params is not None:
             if isinstance(context_params, dict):
                 self.contextGen(**context_params)
@@ -102,6 +127,7 @@ cdef class Pyfhel:
     def __dealloc__(self):
         if self.afseal != NULL:
             del self.afseal
+        self._tenant.reset()
 
     def __repr__(self):
         """A printable string with all the information about the Pyfhel object
@@ -176,6 +202,100 @@ cdef class Pyfhel:
         if not isinstance(value, Real) or value < 0:
             raise ValueError("scale must be a real number")
         self._scale = value
+
+    @property
+    def lazy(self):
+        """Lazy evaluation of PyCtxt operators. Disabled by default.
+
+        When enabled, PyCtxt operators (+, -, *, **, negation, <<, >>, ^) return
+        unevaluated ciphertexts that record an expression graph. The graph is
+        run in one native call on first use (decryption, serialization, any
+        Pyfhel operation) or explicitly with PyCtxt.eval / eval_lazy. In-place
+        operators rebind the name to a new lazy ciphertext.
+
+        See Also:
+            :func:`~Pyfhel.Pyfhel.eval_lazy`
+        """
+        return self._lazy
+    @lazy.setter
+    def lazy(self, value):
+        self._lazy = True if value else False
+
+    @property
+    def eval_only(self):
+        """Evaluation-only mode, for servers that never hold a secret key.
+
+        No key generator is ever built, so loading a context does not sample
+        a throwaway secret key, and encoders and the evaluator are built on
+        first use. Enabling it drops the secret key; generating keys or
+        loading a secret key then raise a RuntimeError.
+
+        See Also:
+            :func:`~Pyfhel.Pyfhel.eval_copy`
+        """
+        return self.afseal.is_eval_only()
+    @eval_only.setter
+    def eval_only(self, value):
+        self.afseal.set_eval_only(True if value else False)
+
+    def eval_copy(self):
+        """Evaluation-only copy, sharing the context and the keys.
+
+        Nothing is copied nor rebuilt: the copy shares the context, encoders,
+        evaluator, public, relinearization and rotation keys, and holds no
+        secret key. Meant to hand a fresh Pyfhel to each request of a server
+        that restores its context and keys only once.
+
+        Return:
+            Pyfhel: the copy, in evaluation-only mode.
+        """
+        cdef Pyfhel he = Pyfhel.__new__(Pyfhel)
+        cdef Afseal* shared = new Afseal(deref(<Afseal*>self.afseal))
+        del he.afseal
+        he.afseal = shared
+        he.afseal.set_eval_only(True)
+        he._sec = self._sec
+        he._qi_sizes = self._qi_sizes
+        he._scale = self._scale
+        he._lazy = self._lazy
+        he._tenant = self._tenant
+        return he
+
+    @property
+    def auto_relin(self):
+        """Deferred relinearization. Disabled by default.
+
+        When enabled, products are left at size 3 and relinearized only when
+        required: before a multiplication whose result would exceed
+        `relin_max_size`, a rotation, or serialization. Summing several products
+        then costs a single relinearization. The ciphertext operated in-place
+        (and a serialized one) is relinearized in-place, while the second
+        operand of a product is relinearized on a copy and left untouched, so
+        it may be shared across threads.
+
+        See Also:
+            :func:`~Pyfhel.Pyfhel.relin_stats`
+        """
+        return self.afseal.get_auto_relin()
+    @auto_relin.setter
+    def auto_relin(self, value):
+        if value and self.is_relin_key_empty() and not self.is_secret_key_empty():
+            warn("<Pyfhel Warning> relin_key empty, generating it for relinearization.", RuntimeWarning)
+            self.relinKeyGen()
+        self.afseal.set_auto_relin(True if value else False, self.afseal.get_relin_max_size())
+
+    @property
+    def relin_max_size(self):
+        """Max ciphertext size kept under `auto_relin` (2 or 3, default 3).
+
+        Use 2 to relinearize right after every product. Larger sizes would
+        need relinearization keys for higher powers of the secret key, which
+        relinKeyGen does not generate.
+        """
+        return self.afseal.get_relin_max_size()
+    @relin_max_size.setter
+    def relin_max_size(self, value):
+        self.afseal.set_auto_relin(self.afseal.get_auto_relin(), value)
        
     @property
     def scheme(self):
@@ -285,7 +405,11 @@ cdef class Pyfhel:
         self._sec = sec
         self._qi_sizes = qi_sizes if not qi_sizes.empty() else \
                          [<int>round(np.log2(_qi)) for _qi in qi] if not qi.empty() else {}
-        return self.afseal.ContextGen(<scheme_t>s.value, n, t_bits, t, sec, qi_sizes, qi)
+        cdef scheme_t c_scheme = <scheme_t>s.value
+        cdef string res
+        with nogil:
+            res = self.afseal.ContextGen(c_scheme, n, t_bits, t, sec, qi_sizes, qi)
+        return res
         
     cpdef void keyGen(self):
         """Generates a pair of secret/Public Keys.
@@ -298,7 +422,8 @@ cdef class Pyfhel:
         Return:
             None
         """
-        self.afseal.KeyGen()
+        with nogil:
+            self.afseal.KeyGen()
         
     cpdef void rotateKeyGen(self, vector[int] rot_steps ={}):
         """Generates a rotation Key.
@@ -318,7 +443,98 @@ cdef class Pyfhel:
         Return:
             None
         """
-        self.afseal.rotateKeyGen(rot_steps)
+        with nogil:
+            self.afseal.rotateKeyGen(rot_steps)
+
+    cpdef void start_rotation_record(self, bool dry_run=False):
+        """Starts recording the rotation steps used, for `plan_rotation_keys`.
+
+        Every rotation is counted by its step (0 for column flips), including
+        those inside cumul_add, matvec_plain, rotate_many and lazy graphs.
+        Restarting clears the previous record.
+
+        Args:
+            dry_run (bool): only record the rotations, without performing them
+                nor requiring rotation keys. Rotated ciphertexts are then left
+                unrotated, so their contents are meaningless.
+
+        Return:
+            None
+        """
+        self._rot_dry_run = dry_run
+        self.afseal.set_rotation_record(True, dry_run)
+
+    cpdef dict stop_rotation_record(self):
+        """Stops recording rotations, returning the recorded steps.
+
+        Return:
+            dict[int, int]: number of rotations per step, 0 meaning column flips.
+        """
+        self._rot_dry_run = False
+        self.afseal.set_rotation_record(False, False)
+        return dict(self.afseal.get_rotation_record())
+
+    def plan_rotation_keys(self, steps=None, int max_extra=1, bool generate=True):
+        """Plans the rotation keys of a workload, and generates them.
+
+        Picks the fewest key steps that reach every step with at most
+        `max_extra` additional rotations. Rotations by steps without their own
+        key are then composed from the generated ones, trading a few extra
+        rotations for a smaller set of keys than one key per step.
+
+        Args:
+            steps (dict[int, int], list[int], optional): number of rotations
+                per step (0 for column flips), or a list of the steps used.
+                Defaults to the steps of the last `start_rotation_record`.
+            max_extra (int): additional rotations allowed to compose a step.
+            generate (bool): generate exactly the planned keys.
+
+        Return:
+            dict: `steps` of the planned keys, `n_keys` and `key_bytes` (their
+                uncompressed size), `rotations` needed with them and
+                `direct_rotations` with one key per step; `default_n_keys`,
+                `default_key_bytes` and `default_rotations` for the default
+                keys of `rotateKeyGen()`.
+
+        Raise:
+            ValueError: if there are no steps to plan.
+        """
+        cdef cpp_map[int, uint64_t] counts
+        if steps is None:
+            counts = self.afseal.get_rotation_record()
+        else:
+            if not isinstance(steps, dict):
+                steps_list, steps = steps, {}
+                for k in steps_list:
+                    steps[k] = steps.get(k, 0) + 1
+            counts = {int(k): int(v) for k, v in steps.items()}
+        if counts.empty():
+            raise ValueError("<Pyfhel ERROR> no rotation steps to plan, "
+                             "record them with start_rotation_record")
+        cdef vector[int] plan
+        with nogil:
+            plan = self.afseal.plan_rotation_keys(counts, max_extra)
+        # Default keys: powers of two in both directions, plus column flips
+        cdef size_t row = self.get_nSlots() if self.afseal.get_scheme()==scheme_t.ckks \
+                          else self.get_nSlots() // 2
+        cdef vector[int] default = [0]
+        cdef int p = 1
+        while p < row:
+            default.push_back(p)
+            default.push_back(-p)
+            p *= 2
+        cdef size_t key_size = self.afseal.sizeof_galois_key()
+        cdef uint64_t direct = sum(dict(counts).values())
+        if generate and not plan.empty():
+            self.rotateKeyGen(plan)
+        return {"steps": list(plan),
+                "n_keys": plan.size(),
+                "key_bytes": plan.size() * key_size,
+                "rotations": self.afseal.count_rotations(plan, counts),
+                "direct_rotations": direct,
+                "default_n_keys": default.size(),
+                "default_key_bytes": default.size() * key_size,
+                "default_rotations": self.afseal.count_rotations(default, counts)}
         
     cpdef void relinKeyGen(self):
         """Generates a relinearization Key.
@@ -336,7 +552,8 @@ cdef class Pyfhel:
         Return:
             None
         """
-        self.afseal.relinKeyGen()        
+        with nogil:
+            self.afseal.relinKeyGen()
   
     
     # .............................. ENCYRPTION ...............................
@@ -354,11 +571,14 @@ cdef class Pyfhel:
         """
         if ctxt is None:
             ctxt = PyCtxt(pyfhel=self)
-        cdef vector[int64_t] vec
+        if not arr.is_c_contig():
+            arr = arr.copy()
+        cdef const int64_t* values = &arr[0]
+        cdef size_t n_values = arr.shape[0]
         cdef AfsealPtxt ptxt
-        vec.assign(&arr[0], &arr[0]+<Py_ssize_t>arr.size)
-        self.afseal.encode_i(vec, ptxt)
-        self.afseal.encrypt(ptxt, deref(ctxt._ptr_ctxt))
+        with nogil:
+            self.afseal.encode_i(values, n_values, ptxt)
+            self.afseal.encrypt(ptxt, deref(ctxt._ptr_ctxt))
         ctxt._scheme = scheme_t.bfv
         ctxt._pyfhel = self
         return ctxt
@@ -384,11 +604,14 @@ cdef class Pyfhel:
         scale = _get_valid_scale(scale_bits, scale, self._scale)
         if ctxt is None:
             ctxt = PyCtxt(pyfhel=self)
-        cdef vector[double] vec
-        vec.assign(&arr[0], &arr[0] + <Py_ssize_t>arr.size)
+        if not arr.is_c_contig():
+            arr = arr.copy()
+        cdef const double* values = &arr[0]
+        cdef size_t n_values = arr.shape[0]
         cdef AfsealPtxt ptxt
-        self.afseal.encode_f(vec, scale, ptxt)
-        self.afseal.encrypt(ptxt, deref(ctxt._ptr_ctxt))
+        with nogil:
+            self.afseal.encode_f(values, n_values, scale, ptxt)
+            self.afseal.encrypt(ptxt, deref(ctxt._ptr_ctxt))
         ctxt._scheme = scheme_t.ckks
         ctxt._pyfhel = self
         return ctxt
@@ -415,11 +638,14 @@ cdef class Pyfhel:
         scale = _get_valid_scale(scale_bits, scale, self._scale)
         if ctxt is None:
             ctxt = PyCtxt(pyfhel=self)
-        cdef vector[cy_complex] vec
-        vec.assign(&arr[0], &arr[0] + <Py_ssize_t>arr.size)
+        if not arr.is_c_contig():
+            arr = arr.copy()
+        cdef const cy_complex* values = <cy_complex*>&arr[0]
+        cdef size_t n_values = arr.shape[0]
         cdef AfsealPtxt ptxt
-        self.afseal.encode_c(vec, scale, ptxt)
-        self.afseal.encrypt(ptxt, deref(ctxt._ptr_ctxt))
+        with nogil:
+            self.afseal.encode_c(values, n_values, scale, ptxt)
+            self.afseal.encrypt(ptxt, deref(ctxt._ptr_ctxt))
         ctxt._scheme = scheme_t.ckks
         ctxt._pyfhel = self
         return ctxt
@@ -442,15 +668,66 @@ cdef class Pyfhel:
         Raise:
             TypeError: if the plaintext doesn't have a valid type.
         """
-        if (ptxt._ptr_ptxt == NULL or ptxt is None):
+        if (ptxt is None or ptxt._ptr_ptxt.get() == NULL):
             raise TypeError("<Pyfhel ERROR> PyPtxt Plaintext is empty")
         if ctxt is None:
             ctxt = PyCtxt(pyfhel=self)
-        self.afseal.encrypt(deref(ptxt._ptr_ptxt), deref(ctxt._ptr_ctxt))
+        with nogil:
+            self.afseal.encrypt(deref(ptxt._ptr_ptxt), deref(ctxt._ptr_ctxt))
         ctxt._scheme = ptxt._scheme
         ctxt._pyfhel = self
         return ctxt
 
+    cpdef PyCtxt encrypt_symmetric(self, object ptxt, PyCtxt ctxt=None):
+        """Encrypts a value or PyPtxt plaintext with the secret key.
+
+        Symmetric ciphertexts decrypt the same way and carry slightly less
+        noise than public key ones. To send them, `encrypt_symmetric_bytes`
+        produces their seeded form at about half the size.
+
+        Args:
+            ptxt (PyPtxt, int, double, np.ndarray): plaintext to encrypt.
+            ctxt (PyCtxt, optional): Optional destination ciphertext.
+
+        Return:
+            PyCtxt: the ciphertext containing the encrypted plaintext
+        """
+        cdef PyPtxt p = ptxt if isinstance(ptxt, PyPtxt) else self.encode(ptxt)
+        if p._ptr_ptxt.get() == NULL:
+            raise TypeError("<Pyfhel ERROR> PyPtxt Plaintext is empty")
+        if ctxt is None:
+            ctxt = PyCtxt(pyfhel=self)
+        with nogil:
+            self.afseal.encrypt_symmetric(deref(p._ptr_ptxt), deref(ctxt._ptr_ctxt))
+        ctxt._expr = None
+        ctxt._scheme = p._scheme
+        ctxt._pyfhel = self
+        return ctxt
+
+    cpdef bytes encrypt_symmetric_bytes(self, object ptxt, str compr_mode="zstd"):
+        """Encrypts with the secret key directly into a seeded ciphertext.
+
+        The uniform half of the ciphertext is replaced by the seed of the
+        generator, which roughly halves its size. The seed is expanded when
+        loading it with `PyCtxt.from_bytes`, so the ciphertext only exists in
+        seeded form as bytes.
+
+        Args:
+            ptxt (PyPtxt, int, double, np.ndarray): plaintext to encrypt.
+            compr_mode (str): Compression. One of "none", "zlib", "zstd"
+
+        Return:
+            bytes: Serialized seeded ciphertext.
+        """
+        cdef PyPtxt p = ptxt if isinstance(ptxt, PyPtxt) else self.encode(ptxt)
+        if p._ptr_ptxt.get() == NULL:
+            raise TypeError("<Pyfhel ERROR> PyPtxt Plaintext is empty")
+        cdef ostringstream ostr
+        cdef string bcompr = compr_mode.encode()
+        with nogil:
+            self.afseal.save_encrypt_symmetric(ostr, bcompr, deref(p._ptr_ptxt))
+        return ostr.str()
+
     cpdef PyCtxt encryptBGV(self, int64_t[:] arr, PyCtxt ctxt=None):
         """Encrypts a 1D vector of int values into a PyCtxt ciphertext.
         If provided a ciphertext, encrypts the value inside it.
@@ -462,31 +739,134 @@ cdef class Pyfhel:
         """
         if ctxt is None:
             ctxt = PyCtxt(pyfhel=self)
-        cdef vector[int64_t] vec
+        if not arr.is_c_contig():
+            arr = arr.copy()
+        cdef const int64_t* values = &arr[0]
+        cdef size_t n_values = arr.shape[0]
         cdef AfsealPtxt ptxt
-        vec.assign(&arr[0], &arr[0]+<Py_ssize_t>arr.size)
-        self.afseal.encode_g(vec, ptxt)
-        self.afseal.encrypt(ptxt, deref(ctxt._ptr_ctxt))
+        with nogil:
+            self.afseal.encode_g(values, n_values, ptxt)
+            self.afseal.encrypt(ptxt, deref(ctxt._ptr_ctxt))
         ctxt._scheme = scheme_t.bgv
         ctxt._pyfhel = self
         return ctxt
 
 
     # vectorized
+    @cython.boundscheck(False)
     cpdef np.ndarray[object, ndim=1] encryptAInt(self, int64_t[:,::1] arr):
-        raise NotImplementedError("<Pyfhel ERROR> encryptAInt not implemented")
+        """Encrypts each row of a 2D array of ints into a PyCtxt ciphertext.
+
+        All rows are encoded and encrypted in parallel by the backend, in a
+        single call that releases the GIL.
 
+        Args:
+            arr (int64_t[:,::1]): C-contiguous 2D array, one row per ciphertext.
+
+        Return:
+            np.ndarray[PyCtxt]: 1D array with one ciphertext per row.
+        """
+        cdef size_t n_rows = arr.shape[0], row_len = arr.shape[1]
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        cdef vector[shared_ptr[AfCtxt]] ctxtV
+        ctxts = _new_ctxt_array(self, n_rows, scheme_t.bfv, ctxtV)
+        with nogil:
+            self.afseal.encode_i_v(&arr[0,0], n_rows, row_len, ptxtV)
+            self.afseal.encrypt_v(ptxtV, ctxtV)
+        return ctxts
+
+    @cython.boundscheck(False)
     cpdef np.ndarray[object, ndim=1] encryptAFrac(self, double[:,::1] arr, double scale=0, int scale_bits=0):
-        raise NotImplementedError("<Pyfhel ERROR> encryptAFrac not implemented")
-        
+        """Encrypts each row of a 2D array of floats into a PyCtxt ciphertext.
+
+        All rows are encoded and encrypted in parallel by the backend, in a
+        single call that releases the GIL.
+
+        Args:
+            arr (double[:,::1]): C-contiguous 2D array, one row per ciphertext.
+            scale (double): scale factor to apply to the values.
+            scale_bits (int): overrides scale, sets it to 2**scale_bits.
+
+        Return:
+            np.ndarray[PyCtxt]: 1D array with one ciphertext per row.
+        """
+        scale = _get_valid_scale(scale_bits, scale, self._scale)
+        cdef size_t n_rows = arr.shape[0], row_len = arr.shape[1]
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        cdef vector[shared_ptr[AfCtxt]] ctxtV
+        ctxts = _new_ctxt_array(self, n_rows, scheme_t.ckks, ctxtV)
+        with nogil:
+            self.afseal.encode_f_v(&arr[0,0], n_rows, row_len, scale, ptxtV)
+            self.afseal.encrypt_v(ptxtV, ctxtV)
+        return ctxts
+        
+    @cython.boundscheck(False)
     cpdef np.ndarray[object, ndim=1] encryptAComplex(self, complex[:,::1] arr, double scale=0, int scale_bits=0):
-        raise NotImplementedError("<Pyfhel ERROR> encryptAComplex not implemented")
+        """Encrypts each row of a 2D array of complex into a PyCtxt ciphertext.
+
+        All rows are encoded and encrypted in parallel by the backend, in a
+        single call that releases the GIL.
 
-    cpdef np.ndarray[object, ndim=1] encryptAPtxt(self, PyPtxt[:] ptxt):
-        raise NotImplementedError("<Pyfhel ERROR> encryptAPtxt not implemented")
+        Args:
+            arr (complex[:,::1]): C-contiguous 2D array, one row per ciphertext.
+            scale (double): scale factor to apply to the values.
+            scale_bits (int): overrides scale, sets it to 2**scale_bits.
 
+        Return:
+            np.ndarray[PyCtxt]: 1D array with one ciphertext per row.
+        """
+        scale = _get_valid_scale(scale_bits, scale, self._scale)
+        cdef size_t n_rows = arr.shape[0], row_len = arr.shape[1]
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        cdef vector[shared_ptr[AfCtxt]] ctxtV
+        ctxts = _new_ctxt_array(self, n_rows, scheme_t.ckks, ctxtV)
+        with nogil:
+            self.afseal.encode_c_v(<cy_complex*>&arr[0,0], n_rows, row_len, scale, ptxtV)
+            self.afseal.encrypt_v(ptxtV, ctxtV)
+        return ctxts
+
+    cpdef np.ndarray[object, ndim=1] encryptAPtxt(self, object ptxt):
+        """Encrypts a sequence of PyPtxt plaintexts in parallel.
+
+        Args:
+            ptxt (list[PyPtxt], np.ndarray[PyPtxt]): plaintexts to encrypt.
+
+        Return:
+            np.ndarray[PyCtxt]: 1D array with one ciphertext per plaintext.
+        """
+        ptxt = list(ptxt)
+        cdef vector[shared_ptr[AfPtxt]] ptxtV = _ptxt_vector(ptxt, scheme_t.none)
+        cdef vector[shared_ptr[AfCtxt]] ctxtV
+        ctxts = _new_ctxt_array(self, ptxtV.size(), self.afseal.get_scheme(), ctxtV)
+        cdef size_t i = 0
+        for p in ptxt:        # Each ciphertext inherits its plaintext scheme
+            (<PyCtxt>ctxts[i])._scheme = (<PyPtxt>p)._scheme
+            i += 1
+        with nogil:
+            self.afseal.encrypt_v(ptxtV, ctxtV)
+        return ctxts
+
+    @cython.boundscheck(False)
     cpdef np.ndarray[object, ndim=1] encryptABGV(self, int64_t[:,::1] arr):
-        raise NotImplementedError("<Pyfhel ERROR> encryptABGV not implemented")
+        """Encrypts each row of a 2D array of ints into a PyCtxt ciphertext (BGV).
+
+        All rows are encoded and encrypted in parallel by the backend, in a
+        single call that releases the GIL.
+
+        Args:
+            arr (int64_t[:,::1]): C-contiguous 2D array, one row per ciphertext.
+
+        Return:
+            np.ndarray[PyCtxt]: 1D array with one ciphertext per row.
+        """
+        cdef size_t n_rows = arr.shape[0], row_len = arr.shape[1]
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        cdef vector[shared_ptr[AfCtxt]] ctxtV
+        ctxts = _new_ctxt_array(self, n_rows, scheme_t.bgv, ctxtV)
+        with nogil:
+            self.afseal.encode_g_v(&arr[0,0], n_rows, row_len, ptxtV)
+            self.afseal.encrypt_v(ptxtV, ctxtV)
+        return ctxts
 
     def encrypt(self, ptxt not None, PyCtxt ctxt=None, scale=None):
         """Encrypts any valid value into a PyCtxt ciphertext.
@@ -499,7 +879,9 @@ cdef class Pyfhel:
         If provided a ciphertext, encrypts the plaintext inside it. 
         
         Args:
-            ptxt (PyPtxt, int, double, np.ndarray): plaintext to encrypt.
+            ptxt (PyPtxt, int, double, np.ndarray): plaintext to encrypt. 2D
+                arrays and sequences of PyPtxt are encrypted in a single batch,
+                returning an array of ciphertexts (ctxt is then ignored).
             ctxt (PyCtxt, optional): Optional destination ciphertext.  
             
         Return:
@@ -508,6 +890,22 @@ cdef class Pyfhel:
         Raise:
             TypeError: if the plaintext doesn't have a valid type.
         """
+        # 2D arrays -> one ciphertext per row, encrypted in a single batch
+        if isinstance(ptxt, (np.ndarray, list)):
+            arr = np.asarray(ptxt)
+            if arr.dtype == object:
+                return self.encryptAPtxt(arr)
+            if arr.ndim == 2:
+                scale = self.scale if scale is None else scale
+                if self.scheme == Scheme_t.bfv:
+                    return self.encryptAInt(np.ascontiguousarray(arr, dtype=np.int64))
+                elif self.scheme == Scheme_t.bgv:
+                    return self.encryptABGV(np.ascontiguousarray(arr, dtype=np.int64))
+                elif self.scheme == Scheme_t.ckks:
+                    if np.issubdtype(arr.dtype, np.complexfloating):
+                        return self.encryptAComplex(np.ascontiguousarray(arr, dtype=complex), scale)
+                    return self.encryptAFrac(np.ascontiguousarray(arr, dtype=np.float64), scale)
+
         # np arrays or numbers -> encode first!
         if isinstance(ptxt, (np.ndarray, np.number, Number, list)):
             ptxt = self.encode(ptxt, scale=self.scale if scale is None else scale)
@@ -520,7 +918,7 @@ cdef class Pyfhel:
                         '] not supported for encryption')
     
     # .............................. DECRYPTION ................................
-    cpdef np.ndarray[int64_t, ndim=1] decryptInt(self, PyCtxt ctxt):
+    cpdef np.ndarray[int64_t, ndim=1] decryptInt(self, PyCtxt ctxt, object out=None):
         """Decrypts a PyCtxt ciphertext into a single int value.
         
         Decrypts a PyCtxt ciphertext using the current secret key, based on
@@ -528,6 +926,10 @@ cdef class Pyfhel:
         
         Args:
             ctxt (PyCtxt, optional): ciphertext to decrypt. 
+            out (np.ndarray, optional): Optional destination array, must be
+                1D, contiguous and of the decoded dtype. Receives the first
+                len(out) slots, zero-padded past nSlots. Defaults to a new
+                array of nSlots values.
             
         Return:
             int: the decrypted integer value
@@ -535,15 +937,19 @@ cdef class Pyfhel:
         Raise:
             RuntimeError: if the ctxt scheme isn't Scheme_t.bfv
         """
+        _ready(ctxt)
         if (ctxt._scheme != scheme_t.bfv):
             raise RuntimeError("<Pyfhel ERROR> wrong scheme type in PyCtxt")
-        cdef vector[int64_t] vec
+        cdef np.ndarray res = _out_array(out, self.get_nSlots(), np.int64)
+        cdef int64_t* values = <int64_t*>np.PyArray_DATA(res)
+        cdef size_t n_values = res.shape[0]
         cdef AfsealPtxt ptxt
-        self.afseal.decrypt(deref(ctxt._ptr_ctxt), ptxt)
-        self.afseal.decode_i(ptxt, vec)
-        return np.asarray(<list>vec)
+        with nogil:
+            self.afseal.decrypt(deref(ctxt._ptr_ctxt), ptxt)
+            self.afseal.decode_i(ptxt, values, n_values)
+        return res
 
-    cpdef np.ndarray[double, ndim=1] decryptFrac(self, PyCtxt ctxt):
+    cpdef np.ndarray[double, ndim=1] decryptFrac(self, PyCtxt ctxt, object out=None):
         """Decrypts a PyCtxt ciphertext into a vector of floats
         
         Decrypts a PyCtxt ciphertext using the current secret key, based on
@@ -551,6 +957,10 @@ cdef class Pyfhel:
         
         Args:
             ctxt (PyCtxt, optional): ciphertext to decrypt. 
+            out (np.ndarray, optional): Optional destination array, must be
+                1D, contiguous and of the decoded dtype. Receives the first
+                len(out) slots, zero-padded past nSlots. Defaults to a new
+                array of nSlots values.
             
         Return:
             np.array[float]: the decrypted float vector
@@ -558,15 +968,19 @@ cdef class Pyfhel:
         Raise:
             RuntimeError: if the ctxt scheme isn't Scheme_t.ckks
         """
+        _ready(ctxt)
         if (ctxt._scheme != scheme_t.ckks):
             raise RuntimeError("<Pyfhel ERROR> wrong scheme type in PyCtxt")
-        cdef vector[double] vec
+        cdef np.ndarray res = _out_array(out, self.get_nSlots(), np.float64)
+        cdef double* values = <double*>np.PyArray_DATA(res)
+        cdef size_t n_values = res.shape[0]
         cdef AfsealPtxt ptxt
-        self.afseal.decrypt(deref(ctxt._ptr_ctxt), ptxt)
-        self.afseal.decode_f(ptxt, vec)
-        return np.asarray(<list>vec)
+        with nogil:
+            self.afseal.decrypt(deref(ctxt._ptr_ctxt), ptxt)
+            self.afseal.decode_f(ptxt, values, n_values)
+        return res
     
-    cpdef np.ndarray[complex, ndim=1] decryptComplex(self, PyCtxt ctxt):
+    cpdef np.ndarray[complex, ndim=1] decryptComplex(self, PyCtxt ctxt, object out=None):
         """Decrypts a PyCtxt ciphertext into a vector of complex values
         
         Decrypts a PyCtxt ciphertext using the current secret key, based on
@@ -574,6 +988,10 @@ cdef class Pyfhel:
         
         Args:
             ctxt (PyCtxt, optional): ciphertext to decrypt. 
+            out (np.ndarray, optional): Optional destination array, must be
+                1D, contiguous and of the decoded dtype. Receives the first
+                len(out) slots, zero-padded past nSlots. Defaults to a new
+                array of nSlots values.
             
         Return:
             np.array[complex]: the decrypted complex vector
@@ -581,13 +999,17 @@ cdef class Pyfhel:
         Raise:
             RuntimeError: if the ctxt scheme isn't Scheme_t.ckks
         """
+        _ready(ctxt)
         if (ctxt._scheme != scheme_t.ckks):
             raise RuntimeError("<Pyfhel ERROR> wrong scheme type in PyCtxt")
-        cdef vector[cy_complex] vec
+        cdef np.ndarray res = _out_array(out, self.get_nSlots(), np.complex128)
+        cdef cy_complex* values = <cy_complex*>np.PyArray_DATA(res)
+        cdef size_t n_values = res.shape[0]
         cdef AfsealPtxt ptxt
-        self.afseal.decrypt(deref(ctxt._ptr_ctxt), ptxt)
-        self.afseal.decode_c(ptxt, vec)
-        return np.asarray(<list>vec)
+        with nogil:
+            self.afseal.decrypt(deref(ctxt._ptr_ctxt), ptxt)
+            self.afseal.decode_c(ptxt, values, n_values)
+        return res
     
     cpdef PyPtxt decryptPtxt(self, PyCtxt ctxt, PyPtxt ptxt=None):
         """Decrypts a PyCtxt ciphertext into a PyPtxt plaintext.
@@ -603,44 +1025,159 @@ cdef class Pyfhel:
         Return:
             PyPtxt: the decrypted plaintext
         """
+        _ready(ctxt)
         if ptxt is None:
             ptxt = PyPtxt(pyfhel=self)
-        self.afseal.decrypt(deref(ctxt._ptr_ctxt), deref(ptxt._ptr_ptxt))
+        else:
+            ptxt._ntt = None
+        with nogil:
+            self.afseal.decrypt(deref(ctxt._ptr_ctxt), deref(ptxt._ptr_ptxt))
         ptxt._scheme = ctxt._scheme
         return ptxt
         
-    cpdef np.ndarray[int64_t, ndim=1] decryptBGV(self, PyCtxt ctxt):
+    cpdef np.ndarray[int64_t, ndim=1] decryptBGV(self, PyCtxt ctxt, object out=None):
         """Decrypts a PyCtxt ciphertext into a single int value.
         Decrypts a PyCtxt ciphertext using the current secret key, based on
         the current context. PyCtxt scheme must be bfv.
         Args:
             ctxt (PyCtxt, optional): ciphertext to decrypt.
+            out (np.ndarray, optional): Optional destination array, must be
+                1D, contiguous and of the decoded dtype. Receives the first
+                len(out) slots, zero-padded past nSlots. Defaults to a new
+                array of nSlots values.
         Return:
             int: the decrypted integer value
         Raise:
             RuntimeError: if the ctxt scheme isn't Scheme_t.bgv
         """
+        _ready(ctxt)
         if (ctxt._scheme != scheme_t.bgv):
             raise RuntimeError("<Pyfhel ERROR> wrong scheme type in PyCtxt")
-        cdef vector[int64_t] vec
+        cdef np.ndarray res = _out_array(out, self.get_nSlots(), np.int64)
+        cdef int64_t* values = <int64_t*>np.PyArray_DATA(res)
+        cdef size_t n_values = res.shape[0]
         cdef AfsealPtxt ptxt
-        self.afseal.decrypt(deref(ctxt._ptr_ctxt), ptxt)
-        self.afseal.decode_g(ptxt, vec)
-        return np.asarray(<list>vec)
+        with nogil:
+            self.afseal.decrypt(deref(ctxt._ptr_ctxt), ptxt)
+            self.afseal.decode_g(ptxt, values, n_values)
+        return res
 
 
     # vectorized
-    cpdef np.ndarray[int64_t, ndim=2] decryptAInt(self, PyCtxt ctxt):
-        raise NotImplementedError("<Pyfhel ERROR> decryptAInt not implemented")
-    cpdef np.ndarray[double, ndim=2] decryptAFrac(self, PyCtxt ctxt):
-        raise NotImplementedError("<Pyfhel ERROR> decryptAFrac not implemented")
-    cpdef np.ndarray[double, ndim=2] decryptAComplex(self, PyCtxt ctxt):
-        raise NotImplementedError("<Pyfhel ERROR> decryptAComplex not implemented")
-    cpdef np.ndarray[object, ndim=1] decryptAPtxt(self, PyCtxt ctxt):
-        raise NotImplementedError("<Pyfhel ERROR> decryptAPtxt not implemented")
-    cpdef np.ndarray[int64_t, ndim=2] decryptABGV(self, PyCtxt ctxt):
-        raise NotImplementedError("<Pyfhel ERROR> decryptABGV not implemented")
-    def decrypt(self, PyCtxt ctxt, bool decode=True, PyPtxt ptxt=None):
+    @cython.boundscheck(False)
+    cpdef np.ndarray[int64_t, ndim=2] decryptAInt(self, object ctxt):
+        """Decrypts a sequence of bfv PyCtxt into a 2D array of ints.
+
+        All ciphertexts are decrypted and decoded in parallel by the backend,
+        in a single call that releases the GIL.
+
+        Args:
+            ctxt (list[PyCtxt], np.ndarray[PyCtxt]): ciphertexts to decrypt.
+
+        Return:
+            np.ndarray[int64_t, ndim=2]: one row of nSlots values per ciphertext.
+        """
+        cdef vector[shared_ptr[AfCtxt]] ctxtV = _ctxt_vector(ctxt, scheme_t.bfv)
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        _new_ptxt_array(self, ctxtV.size(), scheme_t.bfv, ptxtV)
+        cdef size_t row_len = self.get_nSlots()
+        cdef int64_t[:,::1] out = np.empty((ctxtV.size(), row_len), dtype=np.int64)
+        with nogil:
+            self.afseal.decrypt_v(ctxtV, ptxtV)
+            self.afseal.decode_i_v(ptxtV, &out[0,0], row_len)
+        return np.asarray(out)
+
+    @cython.boundscheck(False)
+    cpdef np.ndarray[double, ndim=2] decryptAFrac(self, object ctxt):
+        """Decrypts a sequence of ckks PyCtxt into a 2D array of floats.
+
+        All ciphertexts are decrypted and decoded in parallel by the backend,
+        in a single call that releases the GIL.
+
+        Args:
+            ctxt (list[PyCtxt], np.ndarray[PyCtxt]): ciphertexts to decrypt.
+
+        Return:
+            np.ndarray[double, ndim=2]: one row of nSlots values per ciphertext.
+        """
+        cdef vector[shared_ptr[AfCtxt]] ctxtV = _ctxt_vector(ctxt, scheme_t.ckks)
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        _new_ptxt_array(self, ctxtV.size(), scheme_t.ckks, ptxtV)
+        cdef size_t row_len = self.get_nSlots()
+        cdef double[:,::1] out = np.empty((ctxtV.size(), row_len), dtype=np.float64)
+        with nogil:
+            self.afseal.decrypt_v(ctxtV, ptxtV)
+            self.afseal.decode_f_v(ptxtV, &out[0,0], row_len)
+        return np.asarray(out)
+
+    @cython.boundscheck(False)
+    cpdef np.ndarray[complex, ndim=2] decryptAComplex(self, object ctxt):
+        """Decrypts a sequence of ckks PyCtxt into a 2D array of complex.
+
+        All ciphertexts are decrypted and decoded in parallel by the backend,
+        in a single call that releases the GIL.
+
+        Args:
+            ctxt (list[PyCtxt], np.ndarray[PyCtxt]): ciphertexts to decrypt.
+
+        Return:
+            np.ndarray[complex, ndim=2]: one row of nSlots values per ciphertext.
+        """
+        cdef vector[shared_ptr[AfCtxt]] ctxtV = _ctxt_vector(ctxt, scheme_t.ckks)
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        _new_ptxt_array(self, ctxtV.size(), scheme_t.ckks, ptxtV)
+        cdef size_t row_len = self.get_nSlots()
+        cdef complex[:,::1] out = np.empty((ctxtV.size(), row_len), dtype=complex)
+        with nogil:
+            self.afseal.decrypt_v(ctxtV, ptxtV)
+            self.afseal.decode_c_v(ptxtV, <cy_complex*>&out[0,0], row_len)
+        return np.asarray(out)
+
+    cpdef np.ndarray[object, ndim=1] decryptAPtxt(self, object ctxt):
+        """Decrypts a sequence of PyCtxt into PyPtxt plaintexts in parallel.
+
+        Args:
+            ctxt (list[PyCtxt], np.ndarray[PyCtxt]): ciphertexts to decrypt.
+
+        Return:
+            np.ndarray[PyPtxt]: 1D array with one plaintext per ciphertext.
+        """
+        cdef vector[shared_ptr[AfCtxt]] ctxtV
+        cdef PyCtxt c
+        for c in ctxt:
+            if c is None:
+                raise TypeError("<Pyfhel ERROR> None found in the PyCtxt sequence")
+            ctxtV.push_back(c._ptr_ctxt)
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        ptxts = _new_ptxt_array(self, ctxtV.size(), self.afseal.get_scheme(), ptxtV)
+        with nogil:
+            self.afseal.decrypt_v(ctxtV, ptxtV)
+        return ptxts
+
+    @cython.boundscheck(False)
+    cpdef np.ndarray[int64_t, ndim=2] decryptABGV(self, object ctxt):
+        """Decrypts a sequence of bgv PyCtxt into a 2D array of ints.
+
+        All ciphertexts are decrypted and decoded in parallel by the backend,
+        in a single call that releases the GIL.
+
+        Args:
+            ctxt (list[PyCtxt], np.ndarray[PyCtxt]): ciphertexts to decrypt.
+
+        Return:
+            np.ndarray[int64_t, ndim=2]: one row of nSlots values per ciphertext.
+        """
+        cdef vector[shared_ptr[AfCtxt]] ctxtV = _ctxt_vector(ctxt, scheme_t.bgv)
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        _new_ptxt_array(self, ctxtV.size(), scheme_t.bgv, ptxtV)
+        cdef size_t row_len = self.get_nSlots()
+        cdef int64_t[:,::1] out = np.empty((ctxtV.size(), row_len), dtype=np.int64)
+        with nogil:
+            self.afseal.decrypt_v(ctxtV, ptxtV)
+            self.afseal.decode_g_v(ptxtV, &out[0,0], row_len)
+        return np.asarray(out)
+
+    def decrypt(self, PyCtxt ctxt, bool decode=True, PyPtxt ptxt=None, object out=None):
         """Decrypts any valid PyCtxt into either a PyPtxt ciphertext or a value.
         
         Decrypts a PyCtxt ciphertext using the current secret key, based on
@@ -657,6 +1194,8 @@ cdef class Pyfhel:
             ctxt (PyCtxt): ciphertext to decrypt.
             decode (bool: True): return value or return PyPtxt.
             ptxt (PyPtxt, optional): Optional destination PyPtxt.  
+            out (np.ndarray, optional): Optional destination array for the
+                decoded values (see decryptInt/decryptFrac).
             
         Return:
             PyPtxt, np.array[int|float]: the decrypted result
@@ -666,11 +1205,11 @@ cdef class Pyfhel:
         """
         if (decode):
             if (ctxt._scheme == scheme_t.ckks):
-                return self.decryptFrac(ctxt)
+                return self.decryptFrac(ctxt, out)
             elif (ctxt._scheme == scheme_t.bfv):
-                return self.decryptInt(ctxt)
+                return self.decryptInt(ctxt, out)
             elif (ctxt._scheme == scheme_t.bgv):
-                return self.decryptBGV(ctxt)
+                return self.decryptBGV(ctxt, out)
             else:
                 raise RuntimeError("<Pyfhel ERROR> wrong scheme type in PyCtxt when decrypting")
         else: # Decrypt to plaintext        
@@ -694,9 +1233,13 @@ cdef class Pyfhel:
         Return:
             int: the noise budget level
         """
+        _ready(ctxt)
         if self.scheme != Scheme_t.bfv:
             raise RuntimeError("<Pyfhel ERROR> only bfv scheme supports noise level")
-        return self.afseal.noise_level(deref(ctxt._ptr_ctxt))
+        cdef int noise
+        with nogil:
+            noise = self.afseal.noise_level(deref(ctxt._ptr_ctxt))
+        return noise
 
     cpdef void relinearize(self, PyCtxt ctxt):
         """Relinearizes a ciphertext.
@@ -710,11 +1253,264 @@ cdef class Pyfhel:
         Return:
             None
         """
+        _ready(ctxt)
         if self.is_relin_key_empty():
             warn("<Pyfhel Warning> relin_key empty, generating it for relinearization.", RuntimeWarning)
             self.relinKeyGen()
-        self.afseal.relinearize(deref(ctxt._ptr_ctxt))  
-    
+        with nogil:
+            self.afseal.relinearize(deref(ctxt._ptr_ctxt))
+
+    def relin_stats(self, bool reset=False):
+        """Counters of the deferred relinearization (`auto_relin`) policy.
+
+        Args:
+            reset (bool): set the counters back to zero after reading them.
+
+        Return:
+            dict: `deferred` products left unrelinearized, `performed` automatic
+                relinearizations, and `saved` relinearizations with respect to
+                relinearizing every product.
+        """
+        cdef vector[uint64_t] stats = self.afseal.get_relin_stats(reset)
+        return {"deferred": stats[0], "performed": stats[1], "saved": stats[2]}
+
+    @staticmethod
+    def memory_pools():
+        """High-water marks of the per-thread SEAL memory pools.
+
+        The temporaries of every operation are allocated in a memory pool
+        owned by the calling thread, so that parallel batches do not contend
+        on a single pool. Pools keep their memory for reuse, and are shared
+        by all the Pyfhel objects of the process.
+
+        Return:
+            dict: `threads` list with the bytes held by the pool of each live
+                thread, and `retired` maximum bytes among exited threads.
+        """
+        return {"threads": list(AfsealMemoryPools.high_water()),
+                "retired": AfsealMemoryPools.retired_high_water()}
+
+    @staticmethod
+    def stats(bool reset=False):
+        """Per-operation statistics of the backend, for the whole process.
+
+        Operations are only recorded after `set_stats` (or with AFSEAL_STATS=1
+        in the environment). Rotations are recorded per step ("rotate[3]"),
+        and vectorized operations count one call per batch. Automatic
+        relinearizations appear as "auto_relin".
+
+        Args:
+            reset (bool): clear the recorded statistics after reading them.
+
+        Return:
+            dict: `enabled` flag, `pool_bytes` held by the memory pools of all
+                live threads, and `ops` mapping each operation name to its
+                `calls`, `total_ns`, `mean_ns`, latency percentiles `p50_ns`,
+                `p90_ns`, `p99_ns` and `max_ns`, the `bytes` it serialized
+                and the `pool_bytes` it allocated in the pool of its thread.
+        """
+        cdef cpp_map[string, vector[double]] snap = AfsealStats.snapshot()
+        if reset:
+            AfsealStats.reset()
+        ops = {}
+        for name, v in snap:
+            ops[name.decode()] = {
+                "calls": int(v[0]), "total_ns": int(v[1]),
+                "mean_ns": v[1] / v[0] if v[0] else 0.0,
+                "bytes": int(v[2]), "pool_bytes": int(v[3]),
+                "p50_ns": v[4], "p90_ns": v[5], "p99_ns": v[6],
+                "max_ns": int(v[7])}
+        return {"enabled": AfsealStats.enabled(),
+                "pool_bytes": sum(AfsealMemoryPools.high_water()),
+                "ops": ops}
+
+    @staticmethod
+    def set_stats(bool enabled=True, bool reset=False):
+        """Turns the per-operation statistics of `stats` on or off.
+
+        While disabled, operations skip the timers entirely.
+
+        Args:
+            enabled (bool): record the following operations.
+            reset (bool): clear the statistics recorded so far.
+        """
+        AfsealStats.set_enabled(enabled)
+        if reset:
+            AfsealStats.reset()
+
+    @staticmethod
+    def start_trace(size_t capacity=65536):
+        """Starts recording a timeline of the backend operations.
+
+        Every operation (and every element of a vectorized one, on the thread
+        of the task pool running it) is recorded with its thread, duration and
+        the level and size of its ciphertext. Events from previous traces are
+        dropped.
+
+        Args:
+            capacity (int): events kept per thread. Older ones are overwritten.
+        """
+        AfsealTracer.start(capacity)
+
+    @staticmethod
+    def stop_trace(fileName):
+        """Stops the trace and writes it as Chrome trace JSON.
+
+        The file can be opened in chrome://tracing or https://ui.perfetto.dev.
+        Gaps between the operations of the calling thread are Python time.
+
+        Args:
+            fileName (str, pathlib.Path): output JSON file.
+
+        Return:
+            int: number of operation events written.
+        """
+        cdef string f_name = _to_valid_file_str(fileName, check=False).encode()
+        return AfsealTracer.stop(f_name)
+
+    @staticmethod
+    def context_cache_stats():
+        """Statistics of the process-wide context cache.
+
+        contextGen and load_context share the SEAL context, evaluator and
+        encoders of previously seen parameters instead of building them anew,
+        skipping prime checks and NTT table generation.
+
+        Return:
+            dict: `hits` and `misses` of context lookups, their `hit_rate`,
+                cached parameter sets in `entries` and the cache `capacity`.
+        """
+        cdef vector[uint64_t] stats = AfsealContextCache.stats()
+        lookups = stats[0] + stats[1]
+        return {"hits": stats[0], "misses": stats[1],
+                "hit_rate": stats[0] / lookups if lookups else 0.0,
+                "entries": stats[2], "capacity": stats[3]}
+
+    @staticmethod
+    def set_context_cache(size_t capacity=16, bool clear=False):
+        """Sets the size of the process-wide context cache.
+
+        Beyond `capacity`, the least recently used parameter sets are dropped
+        from the cache. Pyfhel objects using them keep working. The initial
+        capacity is AFSEAL_CONTEXT_CACHE from the environment, or 16.
+
+        Args:
+            capacity (int): cached parameter sets. 0 disables the cache.
+            clear (bool): drop all cached parameter sets and reset the stats.
+
+        Return:
+            None
+        """
+        if clear:
+            AfsealContextCache.clear()
+        AfsealContextCache.set_capacity(capacity)
+
+    # ............................ TENANTS ....................................
+    def register_tenant(self, tenant_id):
+        """Registers the context and keys of this Pyfhel under a tenant ID.
+
+        The process-wide tenant registry keeps an evaluation-only copy sharing
+        the context, public, relinearization and rotation keys (no secret
+        key), so that a server can evaluate for many tenants with
+        :func:`~Pyfhel.Pyfhel.as_tenant` without restoring their keys on each
+        request. Registering an existing ID replaces it.
+
+        Args:
+            tenant_id (str): tenant ID.
+
+        Return:
+            None
+
+        See Also:
+            :func:`~Pyfhel.Pyfhel.set_tenant_registry`
+        """
+        AfsealTenantRegistry.add(str(tenant_id).encode(), deref(<Afseal*>self.afseal),
+                                 self._scale, self._qi_sizes)
+
+    @staticmethod
+    def as_tenant(tenant_id):
+        """Evaluation-only Pyfhel of a registered tenant.
+
+        Shares the context and keys held by the registry, reloading them from
+        the spill directory if they were evicted, with the default scale and
+        prime sizes of the registered Pyfhel. The tenant stays in memory
+        while the returned Pyfhel (or an eval_copy of it) exists.
+
+        Args:
+            tenant_id (str): tenant ID.
+
+        Return:
+            Pyfhel: evaluation-only Pyfhel of the tenant.
+
+        Raise:
+            IndexError: if the tenant is not registered.
+        """
+        cdef double scale
+        cdef vector[int] qi_sizes
+        cdef shared_ptr[Afseal] tenant = AfsealTenantRegistry.get(
+            str(tenant_id).encode(), scale, qi_sizes)
+        cdef Pyfhel he = Pyfhel.__new__(Pyfhel)
+        cdef Afseal* shared = new Afseal(deref(tenant))
+        del he.afseal
+        he.afseal = shared
+        he._tenant = tenant
+        he._sec = shared.get_sec()
+        he._scale = scale
+        he._qi_sizes = qi_sizes
+        return he
+
+    @staticmethod
+    def drop_tenant(tenant_id):
+        """Removes a tenant from the registry, with its spill files.
+
+        Pyfhel objects of the tenant keep working.
+
+        Args:
+            tenant_id (str): tenant ID. Unknown IDs are ignored.
+
+        Return:
+            None
+        """
+        AfsealTenantRegistry.remove(str(tenant_id).encode())
+
+    @staticmethod
+    def set_tenant_registry(size_t budget_bytes=0, spill_dir=None):
+        """Sets the memory budget of the process-wide tenant registry.
+
+        When the keys of the tenants in memory exceed `budget_bytes`, the least
+        recently used tenants not in use are evicted. With a spill directory,
+        their context and keys are written there once, and reloaded on next
+        use with the rotation keys memory-mapped (see
+        :func:`~Pyfhel.Pyfhel.load_rotate_key_store`). Without it, evicted
+        tenants are dropped.
+
+        Args:
+            budget_bytes (int): bytes of keys kept in memory. 0 is unlimited.
+            spill_dir (str, pathlib.Path, optional): spill directory, created
+                if missing. None disables spilling.
+
+        Return:
+            None
+        """
+        if spill_dir is not None:
+            Path(spill_dir).mkdir(parents=True, exist_ok=True)
+        AfsealTenantRegistry.configure(
+            budget_bytes, str(spill_dir).encode() if spill_dir is not None else b"")
+
+    @staticmethod
+    def tenant_registry_stats():
+        """Statistics of the process-wide tenant registry.
+
+        Return:
+            dict: registered `tenants`, those `in_memory`, the `bytes` of
+                their keys, the `budget`, and the number of `hits`, `reloads`
+                from the spill directory and `evictions`.
+        """
+        cdef vector[uint64_t] stats = AfsealTenantRegistry.stats()
+        return {"tenants": stats[0], "in_memory": stats[1], "bytes": stats[2],
+                "budget": stats[3], "hits": stats[4], "reloads": stats[5],
+                "evictions": stats[6]}
+
     # =========================================================================
     # ============================== ENCODING =================================
     # =========================================================================
@@ -733,9 +1529,12 @@ cdef class Pyfhel:
         """
         if ptxt is None:
             ptxt = PyPtxt(pyfhel=self)
-        cdef vector[int64_t] vec
-        vec.assign(&arr[0], &arr[0]+<Py_ssize_t>arr.size)
-        self.afseal.encode_i(vec, deref(ptxt._ptr_ptxt))
+        else:
+            ptxt._ntt = None
+        cdef const int64_t* values = &arr[0]
+        cdef size_t n_values = arr.shape[0]
+        with nogil:
+            self.afseal.encode_i(values, n_values, deref(ptxt._ptr_ptxt))
         ptxt._scheme = scheme_t.bfv
         return ptxt
     
@@ -756,9 +1555,12 @@ cdef class Pyfhel:
         scale = _get_valid_scale(scale_bits, scale, self._scale)
         if ptxt is None:
             ptxt = PyPtxt(pyfhel=self)
-        cdef vector[double] vec
-        vec.assign(&arr[0], &arr[0]+<Py_ssize_t>arr.size)
-        self.afseal.encode_f(vec, scale, deref(ptxt._ptr_ptxt))
+        else:
+            ptxt._ntt = None
+        cdef const double* values = &arr[0]
+        cdef size_t n_values = arr.shape[0]
+        with nogil:
+            self.afseal.encode_f(values, n_values, scale, deref(ptxt._ptr_ptxt))
         ptxt._scheme = scheme_t.ckks
         ptxt._pyfhel = self
         return ptxt
@@ -781,9 +1583,12 @@ cdef class Pyfhel:
         scale = _get_valid_scale(scale_bits, scale, self._scale)
         if ptxt is None:
             ptxt = PyPtxt(pyfhel=self)
-        cdef vector[cy_complex] vec
-        vec.assign(&arr[0], &arr[0]+<Py_ssize_t>arr.size)
-        self.afseal.encode_c(vec, scale, deref(ptxt._ptr_ptxt))
+        else:
+            ptxt._ntt = None
+        cdef const cy_complex* values = <cy_complex*>&arr[0]
+        cdef size_t n_values = arr.shape[0]
+        with nogil:
+            self.afseal.encode_c(values, n_values, scale, deref(ptxt._ptr_ptxt))
         ptxt._scheme = scheme_t.ckks
         ptxt._pyfhel = self
         return ptxt 
@@ -799,24 +1604,101 @@ cdef class Pyfhel:
         """
         if ptxt is None:
             ptxt = PyPtxt(pyfhel=self)
-        cdef vector[int64_t] vec
-        vec.assign(&arr[0], &arr[0]+<Py_ssize_t>arr.size)
-        self.afseal.encode_g(vec, deref(ptxt._ptr_ptxt))
+        else:
+            ptxt._ntt = None
+        cdef const int64_t* values = &arr[0]
+        cdef size_t n_values = arr.shape[0]
+        with nogil:
+            self.afseal.encode_g(values, n_values, deref(ptxt._ptr_ptxt))
         ptxt._scheme = scheme_t.bgv
         return ptxt
 
 
+    @cython.boundscheck(False)
     cpdef np.ndarray[object, ndim=1] encodeAInt(self, int64_t[:,::1] arr):
-        raise NotImplementedError("<Pyfhel ERROR> encodeAInt not implemented")
+        """Encodes each row of a 2D array of ints into a PyPtxt plaintext.
+
+        All rows are encoded in parallel by the backend, in a single call
+        that releases the GIL.
 
+        Args:
+            arr (int64_t[:,::1]): C-contiguous 2D array, one row per plaintext.
+
+        Return:
+            np.ndarray[PyPtxt]: 1D array with one plaintext per row.
+        """
+        cdef size_t n_rows = arr.shape[0], row_len = arr.shape[1]
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        ptxts = _new_ptxt_array(self, n_rows, scheme_t.bfv, ptxtV)
+        with nogil:
+            self.afseal.encode_i_v(&arr[0,0], n_rows, row_len, ptxtV)
+        return ptxts
+
+    @cython.boundscheck(False)
     cpdef np.ndarray[object, ndim=1] encodeAFrac(self, double[:,::1] arr, double scale=0, int scale_bits=0):
-        raise NotImplementedError("<Pyfhel ERROR> encodeAFrac not implemented")
+        """Encodes each row of a 2D array of floats into a PyPtxt plaintext.
+
+        All rows are encoded in parallel by the backend, in a single call
+        that releases the GIL.
 
+        Args:
+            arr (double[:,::1]): C-contiguous 2D array, one row per plaintext.
+            scale (double): scale factor to apply to the values.
+            scale_bits (int): overrides scale, sets it to 2**scale_bits.
+
+        Return:
+            np.ndarray[PyPtxt]: 1D array with one plaintext per row.
+        """
+        scale = _get_valid_scale(scale_bits, scale, self._scale)
+        cdef size_t n_rows = arr.shape[0], row_len = arr.shape[1]
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        ptxts = _new_ptxt_array(self, n_rows, scheme_t.ckks, ptxtV)
+        with nogil:
+            self.afseal.encode_f_v(&arr[0,0], n_rows, row_len, scale, ptxtV)
+        return ptxts
+
+    @cython.boundscheck(False)
     cpdef np.ndarray[object, ndim=1] encodeAComplex(self, complex[:,::1] arr, double scale=0, int scale_bits=0):
-        raise NotImplementedError("<Pyfhel ERROR> encodeAComplex not implemented")
+        """Encodes each row of a 2D array of complex into a PyPtxt plaintext.
+
+        All rows are encoded in parallel by the backend, in a single call
+        that releases the GIL.
+
+        Args:
+            arr (complex[:,::1]): C-contiguous 2D array, one row per plaintext.
+            scale (double): scale factor to apply to the values.
+            scale_bits (int): overrides scale, sets it to 2**scale_bits.
 
+        Return:
+            np.ndarray[PyPtxt]: 1D array with one plaintext per row.
+        """
+        scale = _get_valid_scale(scale_bits, scale, self._scale)
+        cdef size_t n_rows = arr.shape[0], row_len = arr.shape[1]
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        ptxts = _new_ptxt_array(self, n_rows, scheme_t.ckks, ptxtV)
+        with nogil:
+            self.afseal.encode_c_v(<cy_complex*>&arr[0,0], n_rows, row_len, scale, ptxtV)
+        return ptxts
+
+    @cython.boundscheck(False)
     cpdef np.ndarray[object, ndim=1] encodeABGV(self, int64_t[:,::1] arr):
-        raise NotImplementedError("<Pyfhel ERROR> encodeABGV not implemented")
+        """Encodes each row of a 2D array of ints into a PyPtxt plaintext (BGV).
+
+        All rows are encoded in parallel by the backend, in a single call
+        that releases the GIL.
+
+        Args:
+            arr (int64_t[:,::1]): C-contiguous 2D array, one row per plaintext.
+
+        Return:
+            np.ndarray[PyPtxt]: 1D array with one plaintext per row.
+        """
+        cdef size_t n_rows = arr.shape[0], row_len = arr.shape[1]
+        cdef vector[shared_ptr[AfPtxt]] ptxtV
+        ptxts = _new_ptxt_array(self, n_rows, scheme_t.bgv, ptxtV)
+        with nogil:
+            self.afseal.encode_g_v(&arr[0,0], n_rows, row_len, ptxtV)
+        return ptxts
 
     def encode(self, val_vec not None, double scale=0, int scale_bits=0, PyPtxt ptxt=None):
         """Encodes any valid value/vector into a PyPtxt plaintext.
@@ -824,6 +1706,7 @@ cdef class Pyfhel:
         Encodes any valid value/vector based on the current context.
         Value/Vector must be an integer (int), a decimal that will get 
         truncated (float), or in Batch mode a 1D vector of integers.
+        2D arrays are encoded row by row, returning an array of PyPtxt.
         
         If provided a plaintext, encodes the vector inside it. 
         
@@ -857,17 +1740,19 @@ cdef class Pyfhel:
                     return self.encodeFrac(val_vec.astype(np.float64), ptxt, scale)
         elif val_vec.ndim == 2:
             if self.scheme == Scheme_t.bfv:
-                return self.encryptAInt(val_vec.astype(np.int64))
+                return self.encodeAInt(np.ascontiguousarray(val_vec, dtype=np.int64))
+            elif self.scheme == Scheme_t.bgv:
+                return self.encodeABGV(np.ascontiguousarray(val_vec, dtype=np.int64))
             elif self.scheme == Scheme_t.ckks:
                 scale = _get_valid_scale(scale_bits, scale, self._scale)
                 if np.issubdtype(val_vec.dtype, np.complexfloating):
-                    return self.encryptAComplex(val_vec.astype(complex), scale)
+                    return self.encodeAComplex(np.ascontiguousarray(val_vec, dtype=complex), scale)
                 else: # all other numeric types
-                    return self.encryptAFrac(val_vec.astype(np.float64), scale)
+                    return self.encodeAFrac(np.ascontiguousarray(val_vec, dtype=np.float64), scale)
         raise TypeError('<Pyfhel ERROR> Plaintext could not be encoded')
 
     # ................................ DECODE .................................
-    cpdef np.ndarray[int64_t, ndim=1] decodeInt(self, PyPtxt ptxt):
+    cpdef np.ndarray[int64_t, ndim=1] decodeInt(self, PyPtxt ptxt, object out=None):
         """Decodes a PyPtxt plaintext into a single int value.
         
         Decodes a PyPtxt plaintext into a single int value based on
@@ -875,6 +1760,10 @@ cdef class Pyfhel:
         
         Args:
             ptxt (PyPtxt, optional): plaintext to decode. 
+            out (np.ndarray, optional): Optional destination array, must be
+                1D, contiguous and of the decoded dtype. Receives the first
+                len(out) slots, zero-padded past nSlots. Defaults to a new
+                array of nSlots values.
             
         Return:
             int: the decoded integer value
@@ -884,11 +1773,14 @@ cdef class Pyfhel:
         """
         if ptxt._scheme != scheme_t.bfv:
             raise RuntimeError('<Pyfhel ERROR> PyPtxt scheme must be bfv')
-        cdef vector[int64_t] output_vector
-        self.afseal.decode_i(deref(ptxt._ptr_ptxt), output_vector)
-        return vec_to_array_i(output_vector)
+        cdef np.ndarray res = _out_array(out, self.get_nSlots(), np.int64)
+        cdef int64_t* values = <int64_t*>np.PyArray_DATA(res)
+        cdef size_t n_values = res.shape[0]
+        with nogil:
+            self.afseal.decode_i(deref(ptxt._ptr_ptxt), values, n_values)
+        return res
     
-    cpdef np.ndarray[double, ndim=1] decodeFrac(self, PyPtxt ptxt):
+    cpdef np.ndarray[double, ndim=1] decodeFrac(self, PyPtxt ptxt, object out=None):
         """Decodes a PyPtxt plaintext into a single float value.
         
         Decodes a PyPtxt plaintext into a single float value based on
@@ -896,6 +1788,10 @@ cdef class Pyfhel:
         
         Args:
             ptxt (PyPtxt): plaintext to decode.
+            out (np.ndarray, optional): Optional destination array, must be
+                1D, contiguous and of the decoded dtype. Receives the first
+                len(out) slots, zero-padded past nSlots. Defaults to a new
+                array of nSlots values.
             
         Return:
             float: the decoded float value
@@ -905,12 +1801,15 @@ cdef class Pyfhel:
         """
         if ptxt._scheme != scheme_t.ckks:
             raise RuntimeError('<Pyfhel ERROR> PyPtxt scheme must be ckks')
-        cdef vector[double] output_vector
-        self.afseal.decode_f(deref(ptxt._ptr_ptxt), output_vector)
-        return vec_to_array_f(output_vector)
+        cdef np.ndarray res = _out_array(out, self.get_nSlots(), np.float64)
+        cdef double* values = <double*>np.PyArray_DATA(res)
+        cdef size_t n_values = res.shape[0]
+        with nogil:
+            self.afseal.decode_f(deref(ptxt._ptr_ptxt), values, n_values)
+        return res
     
 
-    cpdef np.ndarray[complex, ndim=1] decodeComplex(self, PyPtxt ptxt):
+    cpdef np.ndarray[complex, ndim=1] decodeComplex(self, PyPtxt ptxt, object out=None):
         """Decodes a PyPtxt plaintext into a single float value.
         
         Decodes a PyPtxt plaintext into a single float value based on
@@ -918,6 +1817,10 @@ cdef class Pyfhel:
         
         Args:
             ptxt (PyPtxt): plaintext to decode.
+            out (np.ndarray, optional): Optional destination array, must be
+                1D, contiguous and of the decoded dtype. Receives the first
+                len(out) slots, zero-padded past nSlots. Defaults to a new
+                array of nSlots values.
             
         Return:
             float: the decoded float value
@@ -927,16 +1830,23 @@ cdef class Pyfhel:
         """
         if ptxt._scheme != scheme_t.ckks:
             raise RuntimeError('<Pyfhel ERROR> PyPtxt scheme must be ckks')
-        cdef vector[cy_complex] output_vector
-        self.afseal.decode_c(deref(ptxt._ptr_ptxt), output_vector)  
-        return np.asarray(output_vector)
+        cdef np.ndarray res = _out_array(out, self.get_nSlots(), np.complex128)
+        cdef cy_complex* values = <cy_complex*>np.PyArray_DATA(res)
+        cdef size_t n_values = res.shape[0]
+        with nogil:
+            self.afseal.decode_c(deref(ptxt._ptr_ptxt), values, n_values)
+        return res
     
-    cpdef np.ndarray[int64_t, ndim=1] decodeBGV(self, PyPtxt ptxt):
+    cpdef np.ndarray[int64_t, ndim=1] decodeBGV(self, PyPtxt ptxt, object out=None):
         """Decodes a PyPtxt plaintext into a single int value.
         Decodes a PyPtxt plaintext into a single int value based on
         the current context. PyPtxt scheme must be bgv.
         Args:
             ptxt (PyPtxt, optional): plaintext to decode.
+            out (np.ndarray, optional): Optional destination array, must be
+                1D, contiguous and of the decoded dtype. Receives the first
+                len(out) slots, zero-padded past nSlots. Defaults to a new
+                array of nSlots values.
         Return:
             int: the decoded integer value
         Raise:
@@ -944,23 +1854,94 @@ cdef class Pyfhel:
         """
         if ptxt._scheme != scheme_t.bgv:
             raise RuntimeError('<Pyfhel ERROR> PyPtxt scheme must be bgv')
-        cdef vector[int64_t] output_vector
-        self.afseal.decode_g(deref(ptxt._ptr_ptxt), output_vector)
-        return vec_to_array_i(output_vector)
+        cdef np.ndarray res = _out_array(out, self.get_nSlots(), np.int64)
+        cdef int64_t* values = <int64_t*>np.PyArray_DATA(res)
+        cdef size_t n_values = res.shape[0]
+        with nogil:
+            self.afseal.decode_g(deref(ptxt._ptr_ptxt), values, n_values)
+        return res
+
+    @cython.boundscheck(False)
+    cpdef np.ndarray[int64_t, ndim=2] decodeAInt(self, object ptxt):
+        """Decodes a sequence of bfv PyPtxt into a 2D array of ints.
+
+        All plaintexts are decoded in parallel by the backend, in a single
+        call that releases the GIL.
+
+        Args:
+            ptxt (list[PyPtxt], np.ndarray[PyPtxt]): plaintexts to decode.
+
+        Return:
+            np.ndarray[int64_t, ndim=2]: one row of nSlots values per plaintext.
+        """
+        cdef vector[shared_ptr[AfPtxt]] ptxtV = _ptxt_vector(ptxt, scheme_t.bfv)
+        cdef size_t row_len = self.get_nSlots()
+        cdef int64_t[:,::1] out = np.empty((ptxtV.size(), row_len), dtype=np.int64)
+        with nogil:
+            self.afseal.decode_i_v(ptxtV, &out[0,0], row_len)
+        return np.asarray(out)
+
+    @cython.boundscheck(False)
+    cpdef np.ndarray[double, ndim=2] decodeAFrac(self, object ptxt):
+        """Decodes a sequence of ckks PyPtxt into a 2D array of floats.
+
+        All plaintexts are decoded in parallel by the backend, in a single
+        call that releases the GIL.
 
-    cpdef np.ndarray[int64_t, ndim=2] decodeAInt(self, PyPtxt[:] ptxt):
-        raise NotImplementedError("<Pyfhel ERROR> decodeAInt not implemented")
+        Args:
+            ptxt (list[PyPtxt], np.ndarray[PyPtxt]): plaintexts to decode.
 
-    cpdef np.ndarray[double, ndim=2] decodeAFrac(self, PyPtxt[:] ptxt):
-        raise NotImplementedError("<Pyfhel ERROR> decodeAFrac not implemented")
+        Return:
+            np.ndarray[double, ndim=2]: one row of nSlots values per plaintext.
+        """
+        cdef vector[shared_ptr[AfPtxt]] ptxtV = _ptxt_vector(ptxt, scheme_t.ckks)
+        cdef size_t row_len = self.get_nSlots()
+        cdef double[:,::1] out = np.empty((ptxtV.size(), row_len), dtype=np.float64)
+        with nogil:
+            self.afseal.decode_f_v(ptxtV, &out[0,0], row_len)
+        return np.asarray(out)
         
-    cpdef np.ndarray[complex, ndim=2] decodeAComplex(self, PyPtxt[:] ptxt):
-        raise NotImplementedError("<Pyfhel ERROR> decodeAComplex not implemented")
+    @cython.boundscheck(False)
+    cpdef np.ndarray[complex, ndim=2] decodeAComplex(self, object ptxt):
+        """Decodes a sequence of ckks PyPtxt into a 2D array of complex.
+
+        All plaintexts are decoded in parallel by the backend, in a single
+        call that releases the GIL.
+
+        Args:
+            ptxt (list[PyPtxt], np.ndarray[PyPtxt]): plaintexts to decode.
+
+        Return:
+            np.ndarray[complex, ndim=2]: one row of nSlots values per plaintext.
+        """
+        cdef vector[shared_ptr[AfPtxt]] ptxtV = _ptxt_vector(ptxt, scheme_t.ckks)
+        cdef size_t row_len = self.get_nSlots()
+        cdef complex[:,::1] out = np.empty((ptxtV.size(), row_len), dtype=complex)
+        with nogil:
+            self.afseal.decode_c_v(ptxtV, <cy_complex*>&out[0,0], row_len)
+        return np.asarray(out)
 
-    cpdef np.ndarray[int64_t, ndim=2] decodeABGV(self, PyPtxt[:] ptxt):
-        raise NotImplementedError("<Pyfhel ERROR> decodeABGV not implemented")
+    @cython.boundscheck(False)
+    cpdef np.ndarray[int64_t, ndim=2] decodeABGV(self, object ptxt):
+        """Decodes a sequence of bgv PyPtxt into a 2D array of ints.
 
-    def decode(self, PyPtxt ptxt):
+        All plaintexts are decoded in parallel by the backend, in a single
+        call that releases the GIL.
+
+        Args:
+            ptxt (list[PyPtxt], np.ndarray[PyPtxt]): plaintexts to decode.
+
+        Return:
+            np.ndarray[int64_t, ndim=2]: one row of nSlots values per plaintext.
+        """
+        cdef vector[shared_ptr[AfPtxt]] ptxtV = _ptxt_vector(ptxt, scheme_t.bgv)
+        cdef size_t row_len = self.get_nSlots()
+        cdef int64_t[:,::1] out = np.empty((ptxtV.size(), row_len), dtype=np.int64)
+        with nogil:
+            self.afseal.decode_g_v(ptxtV, &out[0,0], row_len)
+        return np.asarray(out)
+
+    def decode(self, PyPtxt ptxt, object out=None):
         """Decodes any valid PyPtxt into a value or vector.
         
         Decodes a PyPtxt plaintext based on the current context.
@@ -970,6 +1951,8 @@ cdef class Pyfhel:
     
         Args:
             ptxt (PyPtxt, int, float, np.array): plaintext to decode.
+            out (np.ndarray, optional): Optional destination array for the
+                decoded values (see decodeInt/decodeFrac).
             
         Return:
             int, float, list[int]: the decoded value or vector.
@@ -978,11 +1961,11 @@ cdef class Pyfhel:
             TypeError: if the plaintext doesn't have a valid type.
         """
         if (ptxt._scheme == scheme_t.ckks):
-            return self.decodeFrac(ptxt)
+            return self.decodeFrac(ptxt, out)
         elif (ptxt._scheme == scheme_t.bgv):
-            return self.decodeBGV(ptxt)
+            return self.decodeBGV(ptxt, out)
         elif (ptxt._scheme == scheme_t.bfv):
-            return self.decodeInt(ptxt)
+            return self.decodeInt(ptxt, out)
         else:
             raise RuntimeError("<Pyfhel ERROR> wrong scheme in PyPtxt. Cannot decode")
 
@@ -999,9 +1982,11 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
         if (in_new_ctxt):
             ctxt = PyCtxt(ctxt)
-        self.afseal.square(deref(ctxt._ptr_ctxt))
+        with nogil:
+            self.afseal.square(deref(ctxt._ptr_ctxt))
         ctxt.mod_level += 1
         return ctxt
         
@@ -1015,12 +2000,15 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
         if (in_new_ctxt):
             new_ctxt = PyCtxt(ctxt)
-            self.afseal.negate(deref(new_ctxt._ptr_ctxt))
+            with nogil:
+                self.afseal.negate(deref(new_ctxt._ptr_ctxt))
             return new_ctxt
         else:
-            self.afseal.negate(deref(ctxt._ptr_ctxt))
+            with nogil:
+                self.afseal.negate(deref(ctxt._ptr_ctxt))
             return ctxt
 
         
@@ -1039,12 +2027,15 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
+        _ready(ctxt_other)
         if (ctxt._scheme != ctxt_other._scheme):
             raise RuntimeError(f"<Pyfhel ERROR> scheme type mistmatch in add terms"
                                 " ({ctxt._scheme} VS {ctxt_other._scheme})")
         if (in_new_ctxt):
             ctxt = PyCtxt(copy_ctxt=ctxt)
-        self.afseal.add(deref(ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
+        with nogil:
+            self.afseal.add(deref(ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
         return ctxt
         
     cpdef PyCtxt add_plain(self, PyCtxt ctxt, PyPtxt ptxt, bool in_new_ctxt=False):
@@ -1062,12 +2053,14 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
         if (ctxt._scheme != ptxt._scheme):
             raise RuntimeError("<Pyfhel ERROR> scheme type mistmatch in add terms"
                                 " ({ctxt._scheme} VS {ptxt._scheme})")
         if (in_new_ctxt):
             ctxt = PyCtxt(copy_ctxt=ctxt)
-        self.afseal.add_plain(deref(ctxt._ptr_ctxt), deref(ptxt._ptr_ptxt))
+        with nogil:
+            self.afseal.add_plain(deref(ctxt._ptr_ctxt), deref(ptxt._ptr_ptxt))
         return ctxt
 
     cpdef PyCtxt cumul_add(self, PyCtxt ctxt, bool in_new_ctxt=False, size_t n_elements=0):
@@ -1087,7 +2080,8 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
-        if self.is_rotate_key_empty():
+        _ready(ctxt)
+        if self.is_rotate_key_empty() and not self._rot_dry_run:
             warn("<Pyfhel Warning> rot_key empty, initializing it for rotation.", RuntimeWarning)
             self.rotateKeyGen()
 
@@ -1102,24 +2096,63 @@ cdef class Pyfhel:
         if (in_new_ctxt):
             ctxt = PyCtxt(copy_ctxt=ctxt)
         
-        # Auxiliary ciphertext
-        aux = PyCtxt(copy_ctxt=ctxt)
-
-        # Add the second row in bfv
-        if self.scheme == Scheme_t.bfv and (n_elements > n_slots // 2):
-            self.afseal.flip(deref(ctxt._ptr_ctxt))
-            self.afseal.add(deref(ctxt._ptr_ctxt), deref(aux._ptr_ctxt))
-            n_elements = n_slots // 2  # loop over the entire vector in the next step
-            aux._ptr_ctxt = make_shared[AfsealCtxt](deref(dyn_cast[AfsealCtxt,AfCtxt](ctxt._ptr_ctxt)))
-
-        # Cumulative addition
-        cdef int k = 1
-        while (k < n_elements):
-            self.afseal.rotate(deref(ctxt._ptr_ctxt), -k)
-            self.afseal.add(deref(ctxt._ptr_ctxt), deref(aux._ptr_ctxt))
-            aux._ptr_ctxt = make_shared[AfsealCtxt](deref(dyn_cast[AfsealCtxt,AfCtxt](ctxt._ptr_ctxt)))
-            k *= 2
+        # Cumulative addition, in place with a single scratch ciphertext
+        with nogil:
+            self.afseal.cumul_add(deref(ctxt._ptr_ctxt), n_elements)
         return ctxt
+
+    cpdef PyCtxt add_many(self, object ctxts):
+        """Sums a sequence of PyCtxt ciphertexts into a new one.
+
+        The backend sums chunks of the sequence in parallel and then adds up
+        the partial sums as a balanced tree, releasing the GIL. Much faster
+        than K-1 calls to `add` for thousands of ciphertexts. Operands at
+        different levels are mod switched to the lowest one. In ckks, they are
+        rescaled instead where their scale exceeds the other's by the dropped
+        prime, and scales equal up to rounding are aligned as in
+        :func:`~Pyfhel.Pyfhel.align_mod_n_scale`.
+
+        Args:
+            ctxts (list[PyCtxt], np.ndarray[PyCtxt]): ciphertexts to sum.
+
+        Return:
+            PyCtxt: new ciphertext with the sum.
+
+        Raise:
+            ValueError: if the scales of two ckks operands cannot be aligned.
+        """
+        cdef vector[shared_ptr[AfCtxt]] ctxtV = _ctxt_vector(ctxts, self.afseal.get_scheme())
+        if ctxtV.empty():
+            raise ValueError("<Pyfhel ERROR> add_many needs at least one ciphertext")
+        cdef PyCtxt res = PyCtxt(pyfhel=self)
+        with nogil:
+            self.afseal.add_many(ctxtV, deref(res._ptr_ctxt))
+        res._mod_level = self.afseal.get_mod_level(deref(res._ptr_ctxt))
+        return res
+
+    cpdef PyCtxt multiply_many(self, object ctxts):
+        """Multiplies a sequence of PyCtxt ciphertexts into a new one.
+
+        The backend multiplies pairs of ciphertexts in parallel, as a balanced
+        tree, releasing the GIL. Each product is relinearized, and rescaled in
+        ckks or mod switched in bgv. K ciphertexts use ceil(log2(K)) levels,
+        instead of K-1 for a chain of `multiply` calls. Requires relinearization
+        keys.
+
+        Args:
+            ctxts (list[PyCtxt], np.ndarray[PyCtxt]): ciphertexts to multiply.
+
+        Return:
+            PyCtxt: new ciphertext with the product.
+        """
+        cdef vector[shared_ptr[AfCtxt]] ctxtV = _ctxt_vector(ctxts, self.afseal.get_scheme())
+        if ctxtV.empty():
+            raise ValueError("<Pyfhel ERROR> multiply_many needs at least one ciphertext")
+        cdef PyCtxt res = PyCtxt(pyfhel=self)
+        with nogil:
+            self.afseal.multiply_many(ctxtV, deref(res._ptr_ctxt))
+        res._mod_level = self.afseal.get_mod_level(deref(res._ptr_ctxt))
+        return res
             
             
     cpdef PyCtxt sub(self, PyCtxt ctxt, PyCtxt ctxt_other, bool in_new_ctxt=False):
@@ -1137,15 +2170,19 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
+        _ready(ctxt_other)
         if (ctxt._scheme != ctxt_other._scheme):
             raise RuntimeError("<Pyfhel ERROR> scheme type mistmatch in sub terms"
                                 " ({ctxt._scheme} VS {ctxt_other._scheme})")
         if (in_new_ctxt):
             new_ctxt = PyCtxt(ctxt)
-            self.afseal.sub(deref(new_ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
+            with nogil:
+                self.afseal.sub(deref(new_ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
             return new_ctxt
         else:
-            self.afseal.sub(deref(ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
+            with nogil:
+                self.afseal.sub(deref(ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
             return ctxt
         
     cpdef PyCtxt sub_plain (self, PyCtxt ctxt, PyPtxt ptxt, bool in_new_ctxt=False):
@@ -1163,13 +2200,15 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
         if (ctxt._scheme != ptxt._scheme):
             raise RuntimeError("<Pyfhel ERROR> scheme type mistmatch in sub terms"
                                 " ({ctxt._scheme} VS {ptxt._scheme})")
         
         if (in_new_ctxt):
             ctxt = PyCtxt(ctxt)
-        self.afseal.sub_plain(deref(ctxt._ptr_ctxt), deref(ptxt._ptr_ptxt))
+        with nogil:
+            self.afseal.sub_plain(deref(ctxt._ptr_ctxt), deref(ptxt._ptr_ptxt))
         return ctxt
 
         
@@ -1188,17 +2227,21 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
+        _ready(ctxt_other)
         if (ctxt._scheme != ctxt_other._scheme):
             raise RuntimeError("<Pyfhel ERROR> scheme type mistmatch in mult terms"
                                 " ({ctxt._scheme} VS {ctxt_other._scheme})")
         
         if (in_new_ctxt):
             new_ctxt = PyCtxt(ctxt)
-            self.afseal.multiply(deref(new_ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
+            with nogil:
+                self.afseal.multiply(deref(new_ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
             new_ctxt.mod_level += 1         # Next modulus in qi
             return new_ctxt
         else:
-            self.afseal.multiply(deref(ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
+            with nogil:
+                self.afseal.multiply(deref(ctxt._ptr_ctxt), deref(ctxt_other._ptr_ctxt))
             ctxt.mod_level += 1
             return ctxt
         
@@ -1216,12 +2259,15 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, either the input transformed or a new one
         """
+        _ready(ctxt)
         if (ctxt._scheme != ptxt._scheme):
             raise RuntimeError("<Pyfhel ERROR> scheme type mistmatch in mult terms"
                                 " ({ctxt._scheme} VS {ptxt._scheme})")   
+        ptxt = _ntt_for(self, ptxt, ctxt)
         if (in_new_ctxt):
             ctxt = PyCtxt(ctxt)
-        self.afseal.multiply_plain(deref(ctxt._ptr_ctxt), deref(ptxt._ptr_ptxt))
+        with nogil:
+            self.afseal.multiply_plain(deref(ctxt._ptr_ctxt), deref(ptxt._ptr_ptxt))
         ctxt.mod_level += 1
         return ctxt
     
@@ -1243,15 +2289,18 @@ cdef class Pyfhel:
             n_elements (size_t): number of elements to be considered on each vector.
                 If 0, the full encrypted vectors are considered (get_n_slots/ctxt.size).
             with_relin (bool): whether to perform relinearization after multiplication.
+                Ignored with `auto_relin`, which relinearizes before the rotations.
             with_mod_switch (bool): whether to perform modulus switching after multiplication.
             in_new_ctxt (bool): result in a newly created ciphertext.
 
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
+        _ready(ctxt_other)
         # Multiply ctxt with ctxt_other
         ctxt = self.multiply(ctxt, ctxt_other, in_new_ctxt=in_new_ctxt)
-        if (with_relin):
+        if (with_relin and not self.auto_relin):    # else before the rotations
             self.relinearize(ctxt)
         if (with_mod_switch and self.scheme == Scheme_t.ckks):
             self.mod_switch_to_next_ctxt(ctxt)
@@ -1283,6 +2332,7 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
         # Multiply ctxt with ctxt_other
         ctxt = self.multiply_plain(ctxt, ptxt_other, in_new_ctxt=in_new_ctxt)
         if (with_relin):
@@ -1293,6 +2343,91 @@ cdef class Pyfhel:
         # Return cumulative addition
         return self.cumul_add(ctxt, in_new_ctxt=False, n_elements=n_elements)
 
+    @cython.boundscheck(False)
+    cpdef np.ndarray[object, ndim=1] encode_matrix(self, object matrix, double scale=0, int scale_bits=0):
+        """Encodes a plaintext matrix into its diagonals, ready for matvec_plain.
+        
+        The matrix is zero padded to a dim x dim square, dim being the next
+        power of 2, and each of its dim generalized diagonals is encoded into
+        a PyPtxt (in parallel in the backend). Keep the result to reuse the
+        encoding across several products with the same matrix.
+
+        Args:
+            matrix (np.ndarray[int|float], ndim=2): plaintext matrix. Integer
+                in bfv/bgv, fractional in ckks.
+            scale (double): ckks scale factor to encode the diagonals with.
+            scale_bits (int): ckks scale factor as a power of 2.
+            
+        Return:
+            np.ndarray[PyPtxt]: the dim encoded diagonals.
+
+        Raise:
+            TypeError: if the matrix is not 2D.
+            ArithmeticError: if dim exceeds a ciphertext row.
+        """
+        cdef scheme_t scheme = self.afseal.get_scheme()
+        if scheme == scheme_t.ckks:
+            scale = _get_valid_scale(scale_bits, scale, self._scale)
+            matrix = np.ascontiguousarray(matrix, dtype=np.float64)
+        else:
+            matrix = np.ascontiguousarray(matrix, dtype=np.int64)
+        if matrix.ndim != 2 or matrix.size == 0:
+            raise TypeError("<Pyfhel ERROR> matrix must be a non-empty 2D array")
+        cdef size_t n_rows = matrix.shape[0]
+        cdef size_t n_cols = matrix.shape[1]
+        cdef size_t dim = 1
+        while dim < max(n_rows, n_cols):
+            dim *= 2
+        cdef vector[shared_ptr[AfPtxt]] diagV
+        cdef np.ndarray diags = _new_ptxt_array(self, dim, scheme, diagV)
+        cdef double[:,::1] m_f
+        cdef int64_t[:,::1] m_i
+        if scheme == scheme_t.ckks:
+            m_f = matrix
+            with nogil:
+                self.afseal.encode_matrix_f(&m_f[0,0], n_rows, n_cols, scale, diagV)
+        else:
+            m_i = matrix
+            with nogil:
+                self.afseal.encode_matrix_i(&m_i[0,0], n_rows, n_cols, diagV)
+        return diags
+
+    cpdef PyCtxt matvec_plain(self, PyCtxt ctxt, object matrix, bool in_new_ctxt=False):
+        """Multiplies a plaintext matrix with an encrypted vector.
+        
+        Uses the diagonal method with baby-step giant-step rotations, taking
+        O(sqrt(dim)) rotations instead of one cumul_add per matrix row. The
+        vector must be encrypted in the first n_cols slots, with zeros in
+        the remaining slots of the row; the result occupies the first n_rows
+        slots, with zeros in the rest, so products can be chained. An all-zero
+        matrix yields a fresh encryption of zero (requires the public key).
+        Requires rotation keys (the default rotateKeyGen() suffices).
+        In ckks the result scale is the product of both scales, rescale
+        afterwards as with multiply_plain.
+
+        Args:
+            ctxt (PyCtxt): encrypted vector.
+            matrix (np.ndarray): plaintext matrix, either a 2D numeric array
+                or its diagonals as returned by encode_matrix.
+            in_new_ctxt (bool): result in a newly created ciphertext.
+            
+        Return:
+            PyCtxt: resulting ciphertext, the input transformed or a new one
+        """
+        _ready(ctxt)
+        if self.is_rotate_key_empty() and not self._rot_dry_run:
+            warn("<Pyfhel Warning> rot_key empty, initializing it for rotation.", RuntimeWarning)
+            self.rotateKeyGen()
+        diags = matrix
+        if not (isinstance(matrix, np.ndarray) and matrix.dtype == object):
+            diags = self.encode_matrix(matrix)
+        cdef vector[shared_ptr[AfPtxt]] diagV = _ptxt_vector(diags, ctxt._scheme)
+        if (in_new_ctxt):
+            ctxt = PyCtxt(copy_ctxt=ctxt)
+        with nogil:
+            self.afseal.matvec_plain(deref(ctxt._ptr_ctxt), diagV)
+        return ctxt
+
     cpdef PyCtxt rotate(self, PyCtxt ctxt, int k, bool in_new_ctxt=False):
         """Rotates cyclically PyCtxt ciphertext values k positions.
         
@@ -1307,15 +2442,18 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
-        if self.is_rotate_key_empty():
+        _ready(ctxt)
+        if self.is_rotate_key_empty() and not self._rot_dry_run:
             warn("<Pyfhel Warning> rot_key empty, initializing it for rotation.", RuntimeWarning)
             self.rotateKeyGen()
         if (in_new_ctxt):
             new_ctxt = PyCtxt(ctxt)
-            self.afseal.rotate(deref(new_ctxt._ptr_ctxt), k)
+            with nogil:
+                self.afseal.rotate(deref(new_ctxt._ptr_ctxt), k)
             return new_ctxt
         else:
-            self.afseal.rotate(deref(ctxt._ptr_ctxt), k)
+            with nogil:
+                self.afseal.rotate(deref(ctxt._ptr_ctxt), k)
             return ctxt
         
     cpdef PyCtxt flip(self, PyCtxt ctxt, bool in_new_ctxt=False):
@@ -1330,17 +2468,44 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
-        if self.is_rotate_key_empty():
+        _ready(ctxt)
+        if self.is_rotate_key_empty() and not self._rot_dry_run:
             warn("<Pyfhel Warning> rot_key empty, initializing it for rotation.", RuntimeWarning)
             self.rotateKeyGen()
         if (in_new_ctxt):
             new_ctxt = PyCtxt(ctxt)
-            self.afseal.flip(deref(new_ctxt._ptr_ctxt))
+            with nogil:
+                self.afseal.flip(deref(new_ctxt._ptr_ctxt))
             return new_ctxt
         else:
-            self.afseal.flip(deref(ctxt._ptr_ctxt))
+            with nogil:
+                self.afseal.flip(deref(ctxt._ptr_ctxt))
             return ctxt
 
+    cpdef np.ndarray[object, ndim=1] rotate_many(self, PyCtxt ctxt, vector[int] steps):
+        """Rotates a single PyCtxt ciphertext by each of the given steps.
+        
+        All rotations read the same input and run in parallel in the backend,
+        releasing the GIL. Faster than calling `rotate` with in_new_ctxt=True
+        in a loop. Requires rotation keys for all the steps.
+    
+        Args:
+            ctxt (PyCtxt): ciphertext whose values are rotated.
+            steps (list[int]): number of positions for each rotation.
+            
+        Return:
+            np.ndarray[PyCtxt]: one rotated ciphertext per step.
+        """
+        _ready(ctxt)
+        if self.is_rotate_key_empty() and not self._rot_dry_run:
+            warn("<Pyfhel Warning> rot_key empty, initializing it for rotation.", RuntimeWarning)
+            self.rotateKeyGen()
+        cdef vector[shared_ptr[AfCtxt]] ctxtV
+        cdef np.ndarray res = _new_ctxt_array(self, steps.size(), ctxt._scheme, ctxtV)
+        with nogil:
+            self.afseal.rotate_many(deref(ctxt._ptr_ctxt), steps, ctxtV)
+        return res
+
     cpdef PyCtxt power(self, PyCtxt ctxt, uint64_t expon, bool in_new_ctxt=False):
         """Exponentiates PyCtxt ciphertext value/s to expon power.
         
@@ -1356,17 +2521,172 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
         if self.is_relin_key_empty():
             warn("<Pyfhel Warning> relin_key empty, generating it for relinearization.", RuntimeWarning)
             self.relinKeyGen()
         if (in_new_ctxt):
             new_ctxt = PyCtxt(ctxt)
-            self.afseal.exponentiate(deref(new_ctxt._ptr_ctxt), expon)
+            with nogil:
+                self.afseal.exponentiate(deref(new_ctxt._ptr_ctxt), expon)
             return new_ctxt
         else:
-            self.afseal.exponentiate(deref(ctxt._ptr_ctxt), expon) 
+            with nogil:
+                self.afseal.exponentiate(deref(ctxt._ptr_ctxt), expon)
             return ctxt
 
+    cpdef void eval_lazy(self, object ctxts):
+        """Evaluates the expression graphs of lazy PyCtxt ciphertexts.
+
+        The graphs of all the given ciphertexts are merged and run in a single
+        native call: shared subexpressions are computed once, intermediate
+        ciphertexts are reused in place, relinearization and rescaling (ckks)
+        are only applied where a product, a rotation or an output needs them,
+        and independent subexpressions run in parallel.
+
+        Args:
+            ctxts (PyCtxt, Iterable[PyCtxt]): ciphertexts to evaluate. Those
+                already evaluated are skipped.
+
+        Return:
+            None
+
+        See Also:
+            :attr:`~Pyfhel.Pyfhel.lazy`
+        """
+        if isinstance(ctxts, PyCtxt):
+            ctxts = (ctxts,)
+        cdef list roots = [c for c in ctxts if (<PyCtxt?>c)._expr is not None]
+        if not roots:
+            return
+        cdef vector[AfGraphNode] nodes
+        cdef dict index = {}
+        cdef list stack = [(c, False) for c in roots]
+        cdef PyCtxt c
+        cdef np.ndarray vals
+        cdef size_t i
+        cdef bool ckks = self.afseal.get_scheme() == scheme_t.ckks
+        needs_rlk = needs_rtk = False
+        # Topological order: operands always precede their consumers
+        while stack:
+            obj, expanded = stack.pop()
+            if id(obj) in index:
+                continue
+            if isinstance(obj, PyCtxt) and (<PyCtxt>obj)._expr is not None and not expanded:
+                _, lhs, rhs, _ = (<PyCtxt>obj)._expr
+                stack.append((obj, True))
+                if rhs is not None:
+                    stack.append((rhs, False))
+                stack.append((lhs, False))
+                continue
+            i = nodes.size()
+            nodes.resize(i + 1)
+            if isinstance(obj, PyCtxt):
+                c = obj
+                nodes[i].ctxt = c._ptr_ctxt
+                if c._expr is None:
+                    nodes[i].op = graph_op_t.ctxt
+                else:
+                    op, lhs, rhs, k = c._expr
+                    nodes[i].op = <graph_op_t><uint8_t>op
+                    nodes[i].lhs = index[id(lhs)]
+                    nodes[i].rhs = -1 if rhs is None else index[id(rhs)]
+                    nodes[i].k = k
+                    needs_rlk |= (op == <uint8_t>graph_op_t.multiply)
+                    needs_rtk |= (op in (<uint8_t>graph_op_t.rotate, <uint8_t>graph_op_t.flip))
+            elif isinstance(obj, PyPtxt):
+                nodes[i].op = graph_op_t.ptxt
+                nodes[i].ptxt = (<PyPtxt>obj)._ptr_ptxt
+            else:   # Raw values, encoded by the backend at the operand's level
+                vals = obj
+                nodes[i].op = graph_op_t.ptxt
+                if ckks:
+                    nodes[i].fvalues.assign(<double*>np.PyArray_DATA(vals),
+                                            <double*>np.PyArray_DATA(vals) + vals.shape[0])
+                else:
+                    nodes[i].ivalues.assign(<int64_t*>np.PyArray_DATA(vals),
+                                            <int64_t*>np.PyArray_DATA(vals) + vals.shape[0])
+            index[id(obj)] = i
+        for c in roots:
+            nodes[index[id(c)]].output = True
+        if needs_rlk and self.is_relin_key_empty():
+            warn("<Pyfhel Warning> relin_key empty, generating it for relinearization.", RuntimeWarning)
+            self.relinKeyGen()
+        if needs_rtk and self.is_rotate_key_empty() and not self._rot_dry_run:
+            warn("<Pyfhel Warning> rot_key empty, initializing it for rotation.", RuntimeWarning)
+            self.rotateKeyGen()
+        with nogil:
+            self.afseal.eval_graph(nodes)
+        for c in roots:
+            c._mod_level = nodes[index[id(c)]].mod_level
+            c._expr = None
+
+    def eval_poly(self, PyCtxt ctxt, coeffs, str basis="monomial", domain=(-1, 1),
+                  bool in_new_ctxt=False):
+        """Evaluates a polynomial on a ckks PyCtxt ciphertext.
+        
+        Uses baby-step giant-step (Paterson-Stockmeyer) in the backend: for
+        degree d it takes O(sqrt(d)) ciphertext multiplications and a depth
+        of ceil(log2(d+1))+1 levels (one more for a Chebyshev domain other than
+        [-1, 1]). Relinearization, rescaling and level alignment are done
+        automatically; the scale is rounded back to the input scale after each
+        rescale, so qi sizes should match the scale bits.
+
+        Args:
+            ctxt (PyCtxt): ciphertext to evaluate the polynomial on.
+            coeffs (list[float]): coefficients, lowest degree first.
+            basis (str): "monomial" or "chebyshev". Chebyshev coefficients
+                (e.g. from chebyshev_approx) are better conditioned at high
+                degrees.
+            domain (tuple[float, float]): interval the Chebyshev coefficients
+                refer to. Ignored in the monomial basis.
+            in_new_ctxt (bool): result in a newly created ciphertext.
+            
+        Return:
+            PyCtxt: resulting ciphertext, the input transformed or a new one
+
+        Raise:
+            ValueError: if the basis is unknown or the degree is below 1.
+        """
+        _ready(ctxt)
+        if basis not in ("monomial", "chebyshev"):
+            raise ValueError(f"<Pyfhel ERROR> unknown polynomial basis {basis}")
+        if (ctxt._scheme != scheme_t.ckks):
+            raise RuntimeError("<Pyfhel ERROR> wrong scheme type in PyCtxt")
+        if self.is_relin_key_empty():
+            warn("<Pyfhel Warning> relin_key empty, generating it for relinearization.", RuntimeWarning)
+            self.relinKeyGen()
+        cdef vector[double] c_coeffs = np.asarray(coeffs, dtype=np.float64).ravel()
+        cdef bool chebyshev = (basis == "chebyshev")
+        cdef double x_min = domain[0]
+        cdef double x_max = domain[1]
+        if (in_new_ctxt):
+            ctxt = PyCtxt(ctxt)
+        with nogil:
+            self.afseal.eval_poly(deref(ctxt._ptr_ctxt), c_coeffs, chebyshev, x_min, x_max)
+        return ctxt
+
+    def eval_function(self, PyCtxt ctxt, func, int degree=15, domain=(-8, 8),
+                      bool in_new_ctxt=False):
+        """Approximates a function on a ckks PyCtxt with a Chebyshev polynomial.
+        
+        Shorthand for eval_poly with the coefficients of chebyshev_approx.
+        Inputs outside of `domain` produce meaningless results.
+
+        Args:
+            ctxt (PyCtxt): ciphertext to evaluate the function on.
+            func (str, callable): built-in name (sigmoid, tanh, gelu, silu,
+                relu, exp, sqrt, inverse) or a vectorized numpy function.
+            degree (int): degree of the approximating polynomial.
+            domain (tuple[float, float]): interval of the input values.
+            in_new_ctxt (bool): result in a newly created ciphertext.
+            
+        Return:
+            PyCtxt: resulting ciphertext, the input transformed or a new one
+        """
+        coeffs = chebyshev_approx(func, degree, domain)
+        return self.eval_poly(ctxt, coeffs, "chebyshev", domain, in_new_ctxt)
+
     # CKKS
     cpdef void rescale_to_next(self, PyCtxt ctxt):
         """Rescales a ciphertext by dividing it by one scale factor.
@@ -1378,9 +2698,11 @@ cdef class Pyfhel:
             None
 
         """
+        _ready(ctxt)
         if self.scheme != Scheme_t.ckks:
             raise RuntimeError("<Pyfhel ERROR> Scheme must be CKKS for rescaling")
-        self.afseal.rescale_to_next(deref(ctxt._ptr_ctxt))
+        with nogil:
+            self.afseal.rescale_to_next(deref(ctxt._ptr_ctxt))
 
     cpdef PyCtxt mod_switch_to_next_ctxt(self, PyCtxt ctxt, bool in_new_ctxt=False):
         """Reduces the ciphertext modulus with next prime in the qi chain.
@@ -1392,10 +2714,12 @@ cdef class Pyfhel:
         Return:
             PyCtxt: resulting ciphertext, the input transformed or a new one
         """
+        _ready(ctxt)
         new_ctxt = PyCtxt(ctxt) if (in_new_ctxt) else ctxt
         if new_ctxt.scheme in (Scheme_t.ckks, Scheme_t.bgv):
             new_ctxt.mod_level += 1
-            self.afseal.mod_switch_to_next(deref(new_ctxt._ptr_ctxt))
+            with nogil:
+                self.afseal.mod_switch_to_next(deref(new_ctxt._ptr_ctxt))
         return new_ctxt
 
     cpdef PyPtxt mod_switch_to_next_ptxt(self, PyPtxt ptxt, bool in_new_ptxt=True):
@@ -1411,9 +2735,44 @@ cdef class Pyfhel:
         new_ptxt = PyPtxt(ptxt) if (in_new_ptxt) else ptxt
         if new_ptxt.scheme in (Scheme_t.ckks, Scheme_t.bgv):
             new_ptxt.mod_level += 1
-            self.afseal.mod_switch_to_next_plain(deref(new_ptxt._ptr_ptxt))
+            with nogil:
+                self.afseal.mod_switch_to_next_plain(deref(new_ptxt._ptr_ptxt))
         return new_ptxt
 
+    cpdef PyPtxt plain_to_ntt(self, PyPtxt ptxt, object mod_level=0, bool in_new_ptxt=False):
+        """Transforms a PyPtxt plaintext to NTT form at a given level.
+
+        Multiplying by the transformed plaintext skips the NTT that
+        multiply_plain would otherwise compute on every call, which pays off
+        when the same plaintext multiplies many ciphertexts. In ckks, where
+        plaintexts are always in NTT form, the plaintext is mod-switched
+        to that level instead. The result only operates at that level, and
+        cannot be added to bfv ciphertexts. See also `PyPtxt.ntt_cache`.
+
+        Args:
+            ptxt (PyPtxt): plaintext to transform.
+            mod_level (int, PyCtxt): number of primes dropped from the
+                coefficient modulus, or a ciphertext whose level is used.
+            in_new_ptxt (bool): result in a newly created plaintext.
+
+        Return:
+            PyPtxt: the transformed plaintext.
+        """
+        cdef size_t level
+        if isinstance(mod_level, PyCtxt):
+            _ready(mod_level)
+            level = self.afseal.get_mod_level(deref((<PyCtxt>mod_level)._ptr_ctxt))
+        else:
+            level = mod_level
+        if in_new_ptxt:
+            ptxt = PyPtxt(ptxt)
+        else:
+            ptxt._ntt = None
+        with nogil:
+            self.afseal.plain_to_ntt(deref(ptxt._ptr_ptxt), level)
+        ptxt._mod_level = level
+        return ptxt
+
     def mod_switch_to_next(self, cipher_or_plain, in_new_obj=False):
         """Reduces the ciphertext/plaintext modulus with next prime in the qi chain.
 
@@ -1460,6 +2819,12 @@ cdef class Pyfhel:
             return this, other
         elif (this.scale == other.scale) and (this.mod_level == other.mod_level):
             return this, other
+        elif (isinstance(other, PyPtxt) and (<PyPtxt>other)._ntt_cache and
+              (only_mod or this.scale == other.scale) and
+              this.mod_level > other.mod_level):
+            # Cached plaintexts are reused at the ciphertext level, not copied
+            this_ = PyCtxt(copy_ctxt=this) if copy_this else this
+            return this_, _ntt_for(self, other, this_)
         else: # Time to align!
             # Copy?
             this_ = PyCtxt(copy_ctxt=this) if copy_this else this
@@ -1522,7 +2887,11 @@ cdef class Pyfhel:
         cdef string f_name = _to_valid_file_str(fileName, check=False).encode()
         cdef ofstream ostr = ofstream(f_name, binary)
         _write_cy_attributes(self, ostr)
-        return self.afseal.save_context(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.save_context(ostr, bcompr)
+        return n_bytes
     
     cpdef size_t load_context(self, fileName):
         """Restores context from a file
@@ -1536,21 +2905,30 @@ cdef class Pyfhel:
         cdef string f_name = _to_valid_file_str(fileName, check=True).encode()
         cdef ifstream istr = ifstream(f_name, binary)
         _read_cy_attributes(self, istr)
-        return self.afseal.load_context(istr, self._sec)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_context(istr, self._sec)
+        return n_bytes
 
-    cpdef size_t save_public_key(self, fileName, str compr_mode="zstd"):
+    cpdef size_t save_public_key(self, fileName, str compr_mode="zstd", bool seeded=False):
         """Saves current public key in a file
         
         Args:
             fileName (str, pathlib.Path): Name of the file.   
-            compr_mode (str): Compression. One of "none", "zlib", "zstd" 
+            compr_mode (str): Compression. One of "none", "zlib", "zstd"
+            seeded (bool): generate a new public key from the secret key and save
+                it in seeded form, about half the size.
             
         Return:
             size_t: number of bytes saved/loaded
         """
         cdef string f_name = _to_valid_file_str(fileName, check=False).encode()
         cdef ofstream ostr = ofstream(f_name, binary)
-        return self.afseal.save_public_key(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.save_public_key(ostr, bcompr, seeded)
+        return n_bytes
             
     cpdef size_t load_public_key(self, fileName):
         """Restores current public key from a file
@@ -1563,7 +2941,10 @@ cdef class Pyfhel:
         """
         cdef string f_name = _to_valid_file_str(fileName, check=True).encode()
         cdef ifstream istr = ifstream(f_name, binary)
-        return self.afseal.load_public_key(istr)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_public_key(istr)
+        return n_bytes
 
     cpdef size_t save_secret_key(self, fileName, str compr_mode="zstd"):
         """Saves current secret key in a file
@@ -1577,7 +2958,11 @@ cdef class Pyfhel:
         """
         cdef string f_name = _to_valid_file_str(fileName, check=False).encode()
         cdef ofstream ostr = ofstream(f_name, binary)
-        return self.afseal.save_secret_key(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.save_secret_key(ostr, bcompr)
+        return n_bytes
     
     cpdef size_t load_secret_key(self, fileName):
         """Restores current secret key from a file
@@ -1590,21 +2975,30 @@ cdef class Pyfhel:
         """
         cdef string f_name = _to_valid_file_str(fileName, check=True).encode()
         cdef ifstream istr = ifstream(f_name, binary)
-        return self.afseal.load_secret_key(istr)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_secret_key(istr)
+        return n_bytes
     
-    cpdef size_t save_relin_key(self, fileName, str compr_mode="zstd"):
+    cpdef size_t save_relin_key(self, fileName, str compr_mode="zstd", bool seeded=False):
         """Saves current relinearization keys in a file
         
         Args:
             fileName (str, pathlib.Path): Name of the file.   
             compr_mode (str): Compression. One of "none", "zlib", "zstd"
+            seeded (bool): generate new relinearization keys from the secret key
+                and save them in seeded form, about half the size.
             
         Return:
             size_t: number of bytes saved/loaded
         """
         cdef string f_name = _to_valid_file_str(fileName, check=False).encode()
         cdef ofstream ostr = ofstream(f_name, binary)
-        return self.afseal.save_relin_keys(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.save_relin_keys(ostr, bcompr, seeded)
+        return n_bytes
     
     cpdef size_t load_relin_key(self, fileName):
         """Restores current relinearization keys from a file
@@ -1617,21 +3011,30 @@ cdef class Pyfhel:
         """
         cdef string f_name = _to_valid_file_str(fileName, check=True).encode()
         cdef ifstream istr = ifstream(f_name, binary)
-        return self.afseal.load_relin_keys(istr)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_relin_keys(istr)
+        return n_bytes
     
-    cpdef size_t save_rotate_key(self, fileName, str compr_mode="zstd"):
+    cpdef size_t save_rotate_key(self, fileName, str compr_mode="zstd", bool seeded=False):
         """Saves current rotation Keys from a file
         
         Args:
             fileName (str, pathlib.Path): Name of the file.   
             compr_mode (str): Compression. One of "none", "zlib", "zstd"
+            seeded (bool): generate the same rotation keys anew from the secret
+                key and save them in seeded form, about half the size.
             
         Return:
             size_t: number of bytes saved/loaded
         """
         cdef string f_name = _to_valid_file_str(fileName, check=False).encode()
         cdef ofstream ostr = ofstream(f_name, binary)
-        return self.afseal.save_rotate_keys(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.save_rotate_keys(ostr, bcompr, seeded)
+        return n_bytes
     
     cpdef size_t load_rotate_key(self, fileName):
         """Restores current rotation Keys from a file
@@ -1644,7 +3047,141 @@ cdef class Pyfhel:
         """
         cdef string f_name = _to_valid_file_str(fileName, check=True).encode()
         cdef ifstream istr = ifstream(f_name, binary)
-        return self.afseal.load_rotate_keys(istr)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_rotate_keys(istr)
+        return n_bytes
+
+    cpdef size_t save_rotate_key_store(self, fileName):
+        """Saves current rotation Keys as a key store, indexed by rotation.
+
+        Unlike `save_rotate_key`, the keys are uncompressed and each one can
+        be read on its own, to be used with `load_rotate_key_store`.
+
+        Args:
+            fileName (str, pathlib.Path): Name of the file.
+
+        Return:
+            size_t: number of bytes saved
+        """
+        cdef string f_name = _to_valid_file_str(fileName, check=False).encode()
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.save_rotate_keys_store(f_name)
+        return n_bytes
+
+    cpdef size_t load_rotate_key_store(self, fileName):
+        """Opens a rotation key store as the current rotation Keys, lazily.
+
+        The file is memory-mapped instead of read, and each key is loaded
+        the first time a rotation needs it. Worker processes opening the same
+        store share its pages, and only pay for the keys they use.
+
+        Args:
+            fileName (str, pathlib.Path): Name of the file, made with
+                `save_rotate_key_store` for the current context.
+
+        Return:
+            size_t: number of keys in the store
+        """
+        cdef string f_name = _to_valid_file_str(fileName, check=True).encode()
+        cdef size_t n_keys
+        with nogil:
+            n_keys = self.afseal.load_rotate_keys_store(f_name)
+        return n_keys
+
+    def rotate_key_store_info(self):
+        """Keys loaded so far from the current rotation key store.
+
+        Return:
+            dict: `keys` in the store and `loaded` among them, or None if
+                the rotation Keys are not a key store.
+        """
+        cdef vector[size_t] stats = self.afseal.get_rotate_keys_store_stats()
+        if stats.empty():
+            return None
+        return {"keys": stats[0], "loaded": stats[1]}
+
+    # CIPHERTEXT FILES
+    def save_ctxt_file(self, fileName, ctxts, str compr_mode="zstd", bool append=False):
+        """Saves a sequence of ciphertexts in a single container file.
+
+        The file holds the hash of the context, then one record per ciphertext
+        and an index of their offsets, so that `load_ctxt_file` can read any
+        range of them. Ciphertexts are serialized in parallel. With `append`,
+        they are added after those already in the file, which keeps its own
+        compression mode; this is how large batches are streamed to disk.
+
+        Args:
+            fileName (str, pathlib.Path): Name of the file.
+            ctxts (list[PyCtxt], np.ndarray[PyCtxt]): ciphertexts to save.
+            compr_mode (str): Compression mode. One of "none", "zlib", "zstd".
+            append (bool): append to the file if it exists, instead of
+                overwriting it.
+
+        Return:
+            int: number of ciphertexts in the file.
+        """
+        cdef string f_name = _to_valid_file_str(fileName, check=False).encode()
+        cdef string bcompr_mode = compr_mode.lower().encode()
+        cdef vector[shared_ptr[AfCtxt]] ctxtV = _ctxt_vector(ctxts, self.afseal.get_scheme())
+        cdef AfsealCtxtFileWriter* writer = new AfsealCtxtFileWriter(
+            f_name, deref(<Afseal*>self.afseal), bcompr_mode, append)
+        try:
+            with nogil:
+                writer.append(ctxtV)
+                writer.close()
+            return writer.size()
+        finally:
+            del writer
+
+    def load_ctxt_file(self, fileName, size_t start=0, stop=None):
+        """Loads the ciphertexts [start, stop) of a container file.
+
+        Only the requested records are read, in large chunks decoded in
+        parallel. Files left without an index by an interrupted
+        `save_ctxt_file` are indexed by scanning their complete records.
+
+        Args:
+            fileName (str, pathlib.Path): file made by `save_ctxt_file` for
+                the current context.
+            start (int): index of the first ciphertext.
+            stop (int, optional): index past the last ciphertext. Defaults to
+                the end of the file.
+
+        Return:
+            np.ndarray[PyCtxt]: 1D array with the ciphertexts.
+        """
+        cdef string f_name = _to_valid_file_str(fileName, check=True).encode()
+        cdef vector[shared_ptr[AfCtxt]] ctxtV
+        cdef AfsealCtxtFileReader* reader = new AfsealCtxtFileReader(f_name, deref(<Afseal*>self.afseal))
+        cdef size_t n
+        try:
+            n = reader.size() if stop is None else min(<size_t>stop, reader.size())
+            start = min(start, n)
+            ctxts = _new_ctxt_array(self, n - start, self.afseal.get_scheme(), ctxtV)
+            with nogil:
+                reader.read(start, ctxtV)
+        finally:
+            del reader
+        return ctxts
+
+    def ctxt_file_info(self, fileName):
+        """Number of ciphertexts and compression mode of a container file.
+
+        Args:
+            fileName (str, pathlib.Path): file made by `save_ctxt_file` for
+                the current context.
+
+        Return:
+            dict: `size` (number of ciphertexts) and `compr_mode`.
+        """
+        cdef string f_name = _to_valid_file_str(fileName, check=True).encode()
+        cdef AfsealCtxtFileReader* reader = new AfsealCtxtFileReader(f_name, deref(<Afseal*>self.afseal))
+        try:
+            return {"size": reader.size(), "compr_mode": reader.compr_mode().decode()}
+        finally:
+            del reader
     
     
     # BYTES
@@ -1660,7 +3197,9 @@ cdef class Pyfhel:
         """
         cdef ostringstream ostr
         _write_cy_attributes(self, ostr)
-        self.afseal.save_context(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        with nogil:
+            self.afseal.save_context(ostr, bcompr)
         return ostr.str()
     
     cpdef size_t from_bytes_context(self, bytes content):
@@ -1675,19 +3214,26 @@ cdef class Pyfhel:
         cdef stringstream istr
         istr.write(content,len(content))
         _read_cy_attributes(self, istr)
-        return self.afseal.load_context(istr, self._sec)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_context(istr, self._sec)
+        return n_bytes
 
-    cpdef bytes to_bytes_public_key(self, str compr_mode="zstd"):
+    cpdef bytes to_bytes_public_key(self, str compr_mode="zstd", bool seeded=False):
         """Saves current public key in a bytes string
         
         Args:
-            compr_mode (str): Compression. One of "none", "zlib", "zstd" 
+            compr_mode (str): Compression. One of "none", "zlib", "zstd"
+            seeded (bool): generate a new public key from the secret key and save
+                it in seeded form, about half the size.
             
         Return:
             bytes: Serialized public key.
         """
         cdef ostringstream ostr
-        self.afseal.save_public_key(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        with nogil:
+            self.afseal.save_public_key(ostr, bcompr, seeded)
         return ostr.str()
             
     cpdef size_t from_bytes_public_key(self, bytes content):
@@ -1701,7 +3247,10 @@ cdef class Pyfhel:
         """
         cdef stringstream istr
         istr.write(content,len(content))
-        return self.afseal.load_public_key(istr)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_public_key(istr)
+        return n_bytes
 
     cpdef bytes to_bytes_secret_key(self, str compr_mode="zstd"):
         """Saves current secret key in a bytes string
@@ -1713,7 +3262,9 @@ cdef class Pyfhel:
             bytes: Serialized secret key.
         """
         cdef ostringstream ostr
-        self.afseal.save_secret_key(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        with nogil:
+            self.afseal.save_secret_key(ostr, bcompr)
         return ostr.str()
     
     cpdef size_t from_bytes_secret_key(self, bytes content):
@@ -1727,19 +3278,26 @@ cdef class Pyfhel:
         """
         cdef stringstream istr
         istr.write(content,len(content))
-        return self.afseal.load_secret_key(istr)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_secret_key(istr)
+        return n_bytes
     
-    cpdef bytes to_bytes_relin_key(self, str compr_mode="zstd"):
+    cpdef bytes to_bytes_relin_key(self, str compr_mode="zstd", bool seeded=False):
         """Saves current relinearization key in a bytes string
         
         Args:
-            compr_mode (str): Compression. One of "none", "zlib", "zstd" 
+            compr_mode (str): Compression. One of "none", "zlib", "zstd"
+            seeded (bool): generate new relinearization keys from the secret key
+                and save them in seeded form, about half the size.
             
         Return:
             bytes: Serialized relinearization key.
         """
         cdef ostringstream ostr
-        self.afseal.save_relin_keys(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        with nogil:
+            self.afseal.save_relin_keys(ostr, bcompr, seeded)
         return ostr.str()
     
     cpdef size_t from_bytes_relin_key(self, bytes content):
@@ -1753,19 +3311,26 @@ cdef class Pyfhel:
         """
         cdef stringstream istr
         istr.write(content,len(content))
-        return self.afseal.load_relin_keys(istr)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_relin_keys(istr)
+        return n_bytes
     
-    cpdef bytes to_bytes_rotate_key(self, str compr_mode="zstd"):
+    cpdef bytes to_bytes_rotate_key(self, str compr_mode="zstd", bool seeded=False):
         """Saves current context in a bytes string
         
         Args:
-            compr_mode (str): Compression. One of "none", "zlib", "zstd" 
+            compr_mode (str): Compression. One of "none", "zlib", "zstd"
+            seeded (bool): generate the same rotation keys anew from the secret
+                key and save them in seeded form, about half the size.
             
         Return:
             bytes: Serialized rotation key.
         """
         cdef ostringstream ostr
-        self.afseal.save_rotate_keys(ostr, compr_mode.encode())
+        cdef string bcompr = compr_mode.encode()
+        with nogil:
+            self.afseal.save_rotate_keys(ostr, bcompr, seeded)
         return ostr.str()
     
     cpdef size_t from_bytes_rotate_key(self, bytes content):
@@ -1779,7 +3344,10 @@ cdef class Pyfhel:
         """
         cdef stringstream istr
         istr.write(content,len(content))
-        return self.afseal.load_rotate_keys(istr)
+        cdef size_t n_bytes
+        with nogil:
+            n_bytes = self.afseal.load_rotate_keys(istr)
+        return n_bytes
 
     # SIZES
     cpdef size_t sizeof_context(self, str compr_mode="none"):
@@ -1979,6 +3547,7 @@ cdef class Pyfhel:
     
     cpdef PyPoly poly_from_ciphertext(self, PyCtxt ctxt, size_t i):
         """Gets the i-th underlying polynomial of a ciphertext"""
+        _ready(ctxt)
         return PyPoly(ref=ctxt, index=i)
 
     cpdef PyPoly poly_from_plaintext(self, PyCtxt ref, PyPtxt ptxt):
@@ -1991,6 +3560,7 @@ cdef class Pyfhel:
     
     cpdef list polys_from_ciphertext(self, PyCtxt ctxt):
         """Generates a list of polynomials of the given ciphertext"""
+        _ready(ctxt)
         raise NotImplementedError("TODO: Not yet there")
 
     # OPS
@@ -2009,7 +3579,8 @@ cdef class Pyfhel:
             PyPoly: resulting polynomial, the input transformed or a new one.
         """
         res_poly = PyPoly(p) if in_new_poly else p
-        self.afseal.add_inplace(deref(res_poly._afpoly), deref(p_other._afpoly))
+        with nogil:
+            self.afseal.add_inplace(deref(res_poly._afpoly), deref(p_other._afpoly))
         return res_poly
 
     cpdef PyPoly poly_subtract(self, PyPoly p, PyPoly p_other, bool in_new_poly=False):
@@ -2027,7 +3598,8 @@ cdef class Pyfhel:
             PyPoly: resulting polynomial, the input transformed or a new one.
         """
         res_poly = PyPoly(p) if in_new_poly else p
-        self.afseal.subtract_inplace(deref(res_poly._afpoly), deref(p_other._afpoly))
+        with nogil:
+            self.afseal.subtract_inplace(deref(res_poly._afpoly), deref(p_other._afpoly))
         return res_poly
 
     cpdef PyPoly poly_multiply(self, PyPoly p, PyPoly p_other, bool in_new_poly=False):
@@ -2045,7 +3617,8 @@ cdef class Pyfhel:
             PyPoly: resulting polynomial, the input transformed or a new one.
         """
         res_poly = PyPoly(p) if in_new_poly else p
-        self.afseal.multiply_inplace(deref(res_poly._afpoly), deref(p_other._afpoly))
+        with nogil:
+            self.afseal.multiply_inplace(deref(res_poly._afpoly), deref(p_other._afpoly))
         return res_poly
 
     cpdef PyPoly poly_invert(self, PyPoly p, bool in_new_poly=False):
@@ -2062,7 +3635,8 @@ cdef class Pyfhel:
             PyPoly: resulting polynomial, the input transformed or a new one.
         """
         res_poly = PyPoly(p) if in_new_poly else p
-        self.afseal.invert_inplace(deref(res_poly._afpoly))
+        with nogil:
+            self.afseal.invert_inplace(deref(res_poly._afpoly))
         return res_poly
 
     # I/O
@@ -2079,7 +3653,8 @@ cdef class Pyfhel:
         Return:
             None
         """
-        self.afseal.poly_to_ciphertext(deref(p._afpoly), deref(ctxt._ptr_ctxt), i)
+        with nogil:
+            self.afseal.poly_to_ciphertext(deref(p._afpoly), deref(ctxt._ptr_ctxt), i)
 
     cpdef void poly_to_plaintext(self, PyPoly p, PyPtxt ptxt):
         """Set the polynimial in ptxt to p.
@@ -2093,4 +3668,5 @@ cdef class Pyfhel:
         Return:
             None
         """
-        self.afseal.poly_to_plaintext(deref(p._afpoly), deref(ptxt._ptr_ptxt))
+        with nogil:
+            self.afseal.poly_to_plaintext(deref(p._afpoly), deref(ptxt._ptr_ptxt))
@@ -0,0 +1,143 @@
+"""Wrapper overhead benchmarks of the Pyfhel API.
+
+Each benchmark times a PyCtxt operator or a Pyfhel method with pytest-benchmark,
+while Pyfhel.stats() measures the time spent inside the Afseal calls it wraps.
+Their difference is the cost of the Cython layer (operand encoding, alignment,
+PyCtxt construction, casts...), saved in the `extra_info` of each benchmark.
+Small polynomial degrees are used on purpose, since that is where the overhead
+dominates. Not collected by default; run and track them with:
+
+    python -m pytest Pyfhel/test/bench_Pyfhel.py --benchmark-autosave
+    python -m pytest Pyfhel/test/bench_Pyfhel.py --benchmark-compare
+"""
+import pytest
+import numpy as np
+from Pyfhel import Pyfhel, PyCtxt
+from Pyfhel.utils import Scheme_t
+
+pytest.importorskip("pytest_benchmark")
+
+################################################################################
+#                                SETUP FIXTURES                                #
+################################################################################
+# The list of context parameters to be benchmarked
+context_params_list = [
+    {"scheme": "bfv",  "n": 4096, "t_bits": 20},
+    {"scheme": "ckks", "n": 4096, "scale": 2**20, "qi_sizes": [30, 20, 30]},
+    ]
+
+# Pyfhel object setup
+@pytest.fixture(scope="module", params=context_params_list,
+                ids=[p["scheme"] for p in context_params_list])
+def HE(request):
+    HE = Pyfhel()
+    HE.contextGen(**request.param)
+    HE.keyGen()
+    HE.relinKeyGen()
+    HE.rotateKeyGen()
+    return HE
+
+@pytest.fixture(scope="module")
+def operands(HE):
+    dtype = np.float64 if HE.scheme == Scheme_t.ckks else np.int64
+    x = np.arange(1, 9, dtype=dtype)
+    return x, HE.encode(x), HE.encrypt(x), HE.encrypt(x)
+
+
+def bench_overhead(benchmark, calls_op, f, setup=None):
+    """Benchmarks f, attributing to Afseal the time its backend calls took.
+
+    Args:
+        calls_op (str): Afseal operation called exactly once per run of f.
+        f (callable): code to benchmark.
+        setup (callable): untimed preparation before each run of f.
+    """
+    Pyfhel.set_stats(True, reset=True)
+    try:
+        if setup is None:
+            benchmark(f)
+        else:
+            benchmark.pedantic(f, setup=setup, rounds=200, warmup_rounds=5)
+        ops = Pyfhel.stats()["ops"]
+    finally:
+        Pyfhel.set_stats(False, reset=True)
+    calls = ops[calls_op]["calls"]
+    backend_ns = sum(op["total_ns"] for op in ops.values()) / calls
+    total_ns = benchmark.stats.stats.mean * 1e9
+    benchmark.extra_info.update({
+        "backend_ops": sorted(ops),
+        "backend_ns": backend_ns,
+        "overhead_ns": total_ns - backend_ns,
+        "overhead_ratio": (total_ns - backend_ns) / total_ns,
+    })
+
+
+################################################################################
+#                                 BENCHMARKS                                   #
+################################################################################
+class TestPyCtxtOverhead:
+    @pytest.mark.parametrize("name, calls_op, op", [
+        ("add",        "add",            lambda x, p, c, c2: c + c2),
+        ("add_plain",  "add_plain",      lambda x, p, c, c2: c + p),
+        ("add_array",  "add_plain",      lambda x, p, c, c2: c + x),
+        ("add_scalar", "add_plain",      lambda x, p, c, c2: c + 2),
+        ("sub",        "sub",            lambda x, p, c, c2: c - c2),
+        ("sub_plain",  "sub_plain",      lambda x, p, c, c2: c - p),
+        ("mul",        "multiply",       lambda x, p, c, c2: c * c2),
+        ("mul_plain",  "multiply_plain", lambda x, p, c, c2: c * p),
+        ("mul_scalar", "multiply_plain", lambda x, p, c, c2: c * 2),
+        ("neg",        "negate",         lambda x, p, c, c2: -c),
+        ("square",     "square",         lambda x, p, c, c2: c ** 2),
+        ("rotate",     "rotate[1]",      lambda x, p, c, c2: c << 1),
+        ("bytes",      "save_ciphertext",lambda x, p, c, c2: bytes(c)),
+    ])
+    def test_PyCtxt_operator(self, benchmark, operands, name, calls_op, op):
+        bench_overhead(benchmark, calls_op, lambda: op(*operands))
+
+    def test_PyCtxt_iadd(self, benchmark, operands):
+        x, p, c, c2 = operands
+        acc = c.copy()
+        def iadd():
+            nonlocal acc
+            acc += c2
+        bench_overhead(benchmark, "add", iadd)
+
+
+class TestPyfhelOverhead:
+    def test_Pyfhel_encode(self, benchmark, HE, operands):
+        bench_overhead(benchmark, "encode", lambda: HE.encode(operands[0]))
+
+    def test_Pyfhel_decode(self, benchmark, HE, operands):
+        bench_overhead(benchmark, "decode", lambda: HE.decode(operands[1]))
+
+    def test_Pyfhel_encrypt(self, benchmark, HE, operands):
+        bench_overhead(benchmark, "encrypt", lambda: HE.encrypt(operands[1]))
+
+    def test_Pyfhel_decrypt(self, benchmark, HE, operands):
+        bench_overhead(benchmark, "decrypt", lambda: HE.decrypt(operands[2]))
+
+    @pytest.mark.parametrize("method, calls_op, args", [
+        ("add",       "add",       lambda p, c, c2: (c, c2)),
+        ("add_plain", "add_plain", lambda p, c, c2: (c, p)),
+        ("multiply",  "multiply",  lambda p, c, c2: (c, c2)),
+        ("square",    "square",    lambda p, c, c2: (c,)),
+        ("negate",    "negate",    lambda p, c, c2: (c,)),
+        ("rotate",    "rotate[1]", lambda p, c, c2: (c, 1)),
+    ])
+    def test_Pyfhel_method(self, benchmark, HE, operands, method, calls_op, args):
+        f, a = getattr(HE, method), args(*operands[1:])
+        bench_overhead(benchmark, calls_op, lambda: f(*a, in_new_ctxt=True))
+
+    def test_Pyfhel_relinearize(self, benchmark, HE, operands):
+        x, p, c, c2 = operands
+        prod = HE.multiply(c, c2, in_new_ctxt=True)
+        state = {}
+        def setup():
+            state["c"] = prod.copy()
+        bench_overhead(benchmark, "relinearize",
+                       lambda: HE.relinearize(state["c"]), setup=setup)
+
+    def test_Pyfhel_from_bytes(self, benchmark, HE, operands):
+        data = operands[2].to_bytes()
+        bench_overhead(benchmark, "load_ciphertext",
+                       lambda: PyCtxt(pyfhel=HE, bytestring=data))
@@ -202,6 +202,39 @@ class TestPyCtxt:
             c1 ^= 1
             assert np.round(HE.decrypt(c1)[0])==1
     
+    def test_PyCtxt_lazy(self, HE):
+        x = np.array([1, 2, 3])
+        c = HE.encrypt(x.astype(np.float64) if HE.scheme == Scheme_t.ckks else x)
+        HE.lazy = True
+        try:
+            r = (c * c + c) * 2 - 1
+            s = (r << 1) + r
+            assert "lazy" in repr(s)
+            HE.eval_lazy([r, s])            # one graph, r computed once
+            expected = (x * x + x) * 2 - 1
+            assert np.allclose(HE.decrypt(r)[:3], expected, atol=1e-2)
+            assert np.allclose(HE.decrypt(s)[:2], expected[1:] + expected[:2], atol=1e-2)
+            c3 = -c ** 3                    # evaluated on decryption
+            assert np.allclose(c3.decrypt()[:3], -x**3, atol=1e-2)
+        finally:
+            HE.lazy = False
+
+    def test_PyCtxt_lazy_operands(self, HE):
+        x = np.array([1, 2, 3])
+        ckks = HE.scheme == Scheme_t.ckks
+        c = HE.encrypt(x.astype(np.float64) if ckks else x)
+        # Plaintext at another scale, leaf left unrelinearized by auto_relin
+        p = HE.encode(x.astype(np.float64), scale=2**30) if ckks else HE.encode(x)
+        HE.auto_relin = True
+        try:
+            c2 = c * c
+            HE.lazy = True
+            r = (c2 + p) << 1
+            assert np.allclose(HE.decrypt(r)[:2], (x * x + x)[1:], atol=1e-2)
+        finally:
+            HE.lazy = False
+            HE.auto_relin = False
+
     def test_PyCtxt_io(self, HE):
         c = HE.encrypt(1)
         assert bytes(c) == c.to_bytes()
@@ -215,6 +248,29 @@ class TestPyCtxt:
         #     c.save("dummy.file")
         # Cannot deserialize without pyfhel object
     
+    def test_PyCtxt_buffer_pickle(self, HE):
+        import pickle
+        x = np.array([1, 2, 3])
+        c = HE.encrypt(x)
+        raw = np.asarray(c)
+        assert raw.shape[0] == 2 and raw.dtype == np.uint64
+        assert not raw.flags.writeable
+        # The export is a snapshot: in-place operations leave it untouched
+        snapshot = raw.copy()
+        c.from_bytes(bytearray(c.to_bytes()))
+        c += c
+        assert np.array_equal(raw, snapshot)
+        del raw
+        c.from_bytes(HE.encrypt(x).to_bytes())
+        # Protocol 5 ships the RNS data out-of-band
+        buffers = []
+        data = pickle.dumps(c, protocol=5, buffer_callback=buffers.append)
+        assert len(buffers) == 1 and len(data) < 10000
+        c2 = pickle.loads(data, buffers=buffers)
+        assert np.allclose(HE.decrypt(c2)[:3], x, atol=1e-2)
+        p2 = pickle.loads(pickle.dumps(HE.encode(x), protocol=5))
+        assert np.allclose(HE.decode(p2)[:3], x, atol=1e-2)
+
     def test_PyCtxt_encrypt(self, HE):
         c = HE.encrypt(1)
         c.encrypt(2)
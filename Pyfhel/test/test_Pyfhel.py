@@ -94,16 +94,20 @@ class TestPyfhel:
         with pytest.raises(TypeError, match=".*PyPtxt Plaintext is empty.*"):
             HE_ckks.encryptPtxt(None)
         # vectorized 
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.encryptAInt(np.array([[1,1],[1,1]],dtype=np.int64))
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.encryptAFrac(np.array([[1., 1.], [1., 1.], ],dtype=np.float64))
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.encryptAComplex(np.array([[1+1j,1j],[1-1j,1]]))
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.encryptAPtxt(np.array([PyPtxt(), PyPtxt()], dtype=object))
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.encryptABGV(np.array([[1,1],[1,1]],dtype=np.int64))
+        c_v = HE_ckks.encryptAFrac(np.array([[1., 2.], [3., 4.], [5., 6.]],dtype=np.float64))
+        assert c_v.shape == (3,) and all(isinstance(c, PyCtxt) for c in c_v)
+        assert np.allclose(HE_ckks.decryptAFrac(c_v)[:,:2], [[1,2],[3,4],[5,6]], atol=1e-3)
+        c_v = HE_ckks.encryptAComplex(np.array([[1+1j,1j],[1-1j,1]]))
+        assert np.allclose(HE_ckks.decryptAComplex(c_v)[:,:2], [[1+1j,1j],[1-1j,1]], atol=1e-3)
+        c_v = HE_ckks.encryptAPtxt([HE_ckks.encode(np.array([1.])), HE_ckks.encode(np.array([2.]))])
+        assert np.allclose(HE_ckks.decryptAFrac(c_v)[:,0], [1, 2], atol=1e-3)
+        c_v = HE_ckks.encrypt(np.array([[1.], [2.]]))
+        assert np.allclose(HE_ckks.decryptAFrac(c_v)[:,0], [1, 2], atol=1e-3)
+        assert HE_ckks.encryptAFrac(np.empty((0, 4))).shape == (0,)
+        with pytest.raises(ArithmeticError, match=".*nSlots.*"):
+            HE_ckks.encryptAFrac(np.ones((1, HE_ckks.get_nSlots()+1)))
+        with pytest.raises(ValueError, match=".*contiguous.*"):
+            HE_ckks.encryptAFrac(np.ones((4, 4))[:, ::2])
         with pytest.raises(TypeError, match=".*<Pyfhel ERROR>.*"):
             HE_ckks.encrypt("wrong type")
         
@@ -119,16 +123,28 @@ class TestPyfhel:
         with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
             HE_ckks.decryptBGV(c2)
         # vectorized 
-        with pytest.raises(NotImplementedError, match=".*not implemented.*"):
-            HE_ckks.decryptAInt(c)
-        with pytest.raises(NotImplementedError, match=".*not implemented.*"):
-            HE_ckks.decryptAFrac(c)
-        with pytest.raises(NotImplementedError, match=".*not implemented.*"):
-            HE_ckks.decryptAComplex(c)
-        with pytest.raises(NotImplementedError, match=".*not implemented.*"):
-            HE_ckks.decryptAPtxt(c)
-        with pytest.raises(NotImplementedError, match=".*not implemented.*"):
-            HE_ckks.decryptABGV(c)
+        with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
+            HE_ckks.decryptAInt([c])
+        with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
+            HE_ckks.decryptABGV([c])
+        with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
+            HE_ckks.decryptAFrac([c, c2])
+        with pytest.raises(TypeError):
+            HE_ckks.decryptAFrac([c, None])
+        assert HE_ckks.decryptAFrac([c, c]).shape == (2, HE_ckks.get_nSlots())
+        assert HE_ckks.decryptAFrac([]).shape == (0, HE_ckks.get_nSlots())
+        p_v = HE_ckks.decryptAPtxt(np.array([c, c], dtype=object))
+        assert all(isinstance(p, PyPtxt) for p in p_v)
+        assert np.round(HE_ckks.decodeAFrac(p_v)[1,0]) == 1
+        # decrypt into a preallocated array
+        out = np.zeros(HE_ckks.get_nSlots(), dtype=np.float64)
+        assert HE_ckks.decryptFrac(c, out=out) is out
+        assert np.round(out[0]) == 1
+        assert np.round(HE_ckks.decrypt(c, out=out[:4].copy())[0]) == 1
+        with pytest.raises(ValueError, match=".*out must be.*"):
+            HE_ckks.decryptFrac(c, out=np.zeros(4, dtype=np.int64))
+        with pytest.raises(ValueError, match=".*out must be.*"):
+            HE_ckks.decryptFrac(c, out=out[::2])
         # full decode
         with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
             c3 = PyCtxt()
@@ -136,13 +152,13 @@ class TestPyfhel:
     
     def test_Pyfhel_encode(self, HE_ckks, HE_bfv):
         # vectorized 
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_bfv.encodeAInt(np.array([[1]],dtype=np.int64))
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.encodeAFrac(np.array([[1.]],dtype=np.float64))
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.encodeAComplex(np.array([[1+1j]]))
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
+        p_v = HE_bfv.encodeAInt(np.array([[1, 2], [3, 4]],dtype=np.int64))
+        assert (HE_bfv.decodeAInt(p_v)[:,:2] == [[1, 2], [3, 4]]).all()
+        p_v = HE_ckks.encodeAFrac(np.array([[1.]],dtype=np.float64))
+        assert np.allclose(HE_ckks.decodeAFrac(p_v)[:,0], [1.], atol=1e-3)
+        p_v = HE_ckks.encodeAComplex(np.array([[1+1j]]))
+        assert np.allclose(HE_ckks.decodeAComplex(p_v)[:,0], [1+1j], atol=1e-3)
+        with pytest.raises(RuntimeError):  # bfv context has no bgv encoder
             HE_bfv.encodeABGV(np.array([[1]],dtype=np.int64))
 
         # 3d arrays not supported
@@ -151,15 +167,13 @@ class TestPyfhel:
         # non-numeric array not supported
         with pytest.raises(TypeError, match=".*cannot encrypt.*"):
             HE_ckks.encode(np.array([['hi', 'you']]))
-        with pytest.raises(NotImplementedError, match=".*encryptAInt not implemented.*"):
-            HE_bfv.encode(np.array([[1]],dtype=np.int64))
-        with pytest.raises(NotImplementedError, match=".*encryptAFrac not implemented.*"):
-            HE_ckks.encode(np.array([[1.]],dtype=np.float64))
-        with pytest.raises(NotImplementedError, match=".*encryptAComplex not implemented.*"):
-            HE_ckks.encode(np.array([[1+1j]]))
-        with pytest.raises(TypeError, match=".*Plaintext could not be encoded.*"):
-            HE_bgv = Pyfhel(context_params={'scheme':'BGV', 'n': 2**13, 't': 65537, 't_bits': 20, 'sec': 128,})
-            HE_bgv.encode(np.array([[1,2]]))
+        # 2d arrays are encoded row by row
+        assert HE_bfv.encode(np.array([[1]],dtype=np.int64))[0].scheme == Scheme_t.bfv
+        assert HE_ckks.encode(np.array([[1.]],dtype=np.float64))[0].scheme == Scheme_t.ckks
+        assert len(HE_ckks.encode(np.array([[1+1j], [2]]))) == 2
+        HE_bgv = Pyfhel(context_params={'scheme':'BGV', 'n': 2**13, 't': 65537, 't_bits': 20, 'sec': 128,})
+        p_v = HE_bgv.encode(np.array([[1,2]]))
+        assert (HE_bgv.decodeABGV(p_v)[0,:2] == [1, 2]).all()
 
     def test_Pyfhel_decode(self, HE_ckks, HE_bfv):
         p = HE_ckks.encode(1)
@@ -174,14 +188,20 @@ class TestPyfhel:
             HE_bfv.decodeBGV(p)
         # Vectorized
         p_v = np.array([p],dtype=object)
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.decodeAInt(p_v)
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
+        assert HE_bfv.decodeAInt(p_v)[0,0] == 1
+        with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
             HE_ckks.decodeAFrac(p_v)
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
-            HE_ckks.decodeAComplex(p_v)
-        with pytest.raises(NotImplementedError, match=".*<Pyfhel ERROR>.*"):
+        with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
             HE_ckks.decodeAComplex(p_v)
+        with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
+            HE_bfv.decodeABGV(p_v)
+
+        # decode into a preallocated array, zero padded past nSlots
+        out = np.full(HE_bfv.get_nSlots()+2, -1, dtype=np.int64)
+        assert HE_bfv.decodeInt(p, out=out) is out
+        assert out[0] == 1 and (out[-2:] == 0).all()
+        with pytest.raises(ValueError, match=".*out must be.*"):
+            HE_bfv.decode(p, out=[0]*4)
 
         # scheme none
         del p.scheme
@@ -228,6 +248,11 @@ class TestPyfhel:
         # rot
         with pytest.warns(match=".*rot_key empty.*"):
             c_bfv >>= 1
+        # rotation fan-out
+        c_r = HE_ckks.encrypt(np.arange(4, dtype=np.float64))
+        c_v = HE_ckks.rotate_many(c_r, [0, 1, 2])
+        assert [np.round(HE_ckks.decrypt(c)[0]) for c in c_v] == [0, 1, 2]
+        assert len(HE_ckks.rotate_many(c_r, [])) == 0
         # flip
         with pytest.warns(match=".*rot_key empty.*"):
             HE_bfv_nokeys = Pyfhel()
@@ -253,6 +278,321 @@ class TestPyfhel:
         with pytest.raises(TypeError, match=".*Expected PyCtxt or PyPtxt for mod switching.*"):
             HE_bfv.mod_switch_to_next(np.array([1]))
 
+    def test_Pyfhel_matvec(self, HE_ckks, HE_bfv):
+        M = np.arange(15, dtype=np.int64).reshape(3, 5) - 7
+        x = np.array([1, -2, 3, 0, 5], dtype=np.int64)
+        c = HE_bfv.encrypt(x)
+        c_y = HE_bfv.matvec_plain(c, M, in_new_ctxt=True)
+        assert (HE_bfv.decrypt(c_y)[:3] == M @ x).all()
+        # cached diagonals, reused across products
+        M_d = HE_ckks.encode_matrix(M / 4)
+        assert len(M_d) == 8
+        c = HE_ckks.encrypt(x.astype(np.float64))
+        c_y = HE_ckks.matvec_plain(c, M_d, in_new_ctxt=True)
+        assert np.allclose(HE_ckks.decrypt(c_y)[:3], M @ x / 4, atol=1e-2)
+        HE_ckks.mod_switch_to_next(c)
+        HE_ckks.matvec_plain(c, M_d)
+        assert np.allclose(HE_ckks.decrypt(c)[:3], M @ x / 4, atol=1e-2)
+        # chained A·(B·x): the output is zero outside the first n_rows slots
+        B = np.arange(30, dtype=np.int64).reshape(6, 5) % 7 - 3
+        A = np.arange(18, dtype=np.int64).reshape(3, 6) % 5 - 2
+        c = HE_bfv.encrypt(x)
+        HE_bfv.matvec_plain(c, B)
+        y = HE_bfv.decrypt(c)
+        assert (y[:6] == B @ x).all() and not y[6:HE_bfv.get_nSlots()//2].any()
+        HE_bfv.matvec_plain(c, A)
+        assert (HE_bfv.decrypt(c)[:3] == A @ (B @ x)).all()
+        c = HE_ckks.encrypt(x.astype(np.float64))
+        c_y = HE_ckks.matvec_plain(HE_ckks.matvec_plain(c, B / 4, True), A / 4)
+        assert np.allclose(HE_ckks.decrypt(c_y)[:3], A @ (B @ x) / 16, atol=1e-1)
+        # all-zero matrix: encryption of zero
+        c_y = HE_bfv.matvec_plain(HE_bfv.encrypt(x), np.zeros((3, 5), dtype=np.int64))
+        assert not HE_bfv.decrypt(c_y).any()
+        # diagonals already in NTT form
+        M_d = HE_bfv.encode_matrix(M)
+        for p in M_d:
+            HE_bfv.plain_to_ntt(p)
+        c_y = HE_bfv.matvec_plain(HE_bfv.encrypt(x), M_d)
+        assert (HE_bfv.decrypt(c_y)[:3] == M @ x).all()
+        with pytest.raises(TypeError, match=".*2D.*"):
+            HE_ckks.encode_matrix(np.ones(4))
+        with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
+            HE_ckks.matvec_plain(c, HE_bfv.encode_matrix(M))
+
+    def test_Pyfhel_eval_poly(self, HE_ckks, HE_bfv):
+        x = np.linspace(-1, 1, 8)
+        c = HE_ckks.encrypt(x)
+        coeffs = [0.5, -1, 0, 0.25, 0, 0, 0, 0.125]
+        c_p = HE_ckks.eval_poly(c, coeffs, in_new_ctxt=True)
+        assert np.allclose(HE_ckks.decrypt(c_p)[:8], np.polyval(coeffs[::-1], x), atol=1e-2)
+        # Chebyshev approximations, with domain mapping
+        x = np.linspace(-6, 6, 8)
+        c = HE_ckks.encrypt(x)
+        c_s = HE_ckks.eval_function(c, "sigmoid", degree=15, domain=(-8, 8), in_new_ctxt=True)
+        assert np.allclose(HE_ckks.decrypt(c_s)[:8], 1/(1+np.exp(-x)), atol=1e-2)
+        with pytest.raises(ValueError, match=".*basis.*"):
+            HE_ckks.eval_poly(c, coeffs, basis="legendre")
+        with pytest.raises(ValueError, match=".*degree.*"):
+            HE_ckks.eval_poly(c, [1.])
+        with pytest.raises(ValueError, match=".*unknown function.*"):
+            HE_ckks.eval_function(c, "softmax")
+        with pytest.raises(RuntimeError, match=".*wrong scheme.*"):
+            HE_bfv.eval_poly(HE_bfv.encrypt(1), coeffs)
+
+    def test_Pyfhel_auto_relin(self, HE_ckks):
+        HE_ckks.relin_stats(reset=True)
+        HE_ckks.auto_relin = True
+        try:
+            c = HE_ckks.encrypt(np.array([1., 2.]))
+            acc = c * c
+            for _ in range(3):
+                acc += c * c
+            assert acc.size() == 3
+            acc <<= 1                       # single relinearization, before rotating
+            assert acc.size() == 2
+            assert HE_ckks.relin_stats() == {"deferred": 4, "performed": 1, "saved": 3}
+            assert np.allclose(HE_ckks.decrypt(acc)[:1], [16.], atol=1e-2)
+            sq, c4 = c * c, c * c
+            c4 *= sq                        # sq is only read: relinearized on a copy
+            assert sq.size() == 3
+            assert np.allclose(HE_ckks.decrypt(c4)[:2], [1., 16.], atol=1e-1)
+            with pytest.raises(ValueError, match=".*max size.*"):
+                HE_ckks.relin_max_size = 1
+            with pytest.raises(ValueError, match=".*max size.*"):
+                HE_ckks.relin_max_size = 4
+            assert HE_ckks.relin_max_size == 3
+            c3 = c * c * c                  # c * c relinearized before the second product
+            assert np.allclose(HE_ckks.decrypt(c3 << 1)[:1], [8.], atol=1e-1)
+        finally:
+            HE_ckks.auto_relin = False
+
+    def test_Pyfhel_ntt_plain(self, HE_ckks, HE_bfv):
+        p = HE_bfv.encodeInt(np.array([2, 3]))
+        p.ntt_cache = True
+        for v in ([1, 2], [4, 5]):
+            c = HE_bfv.encrypt(np.array(v))
+            assert np.all(HE_bfv.decrypt(c * p)[:2] == np.array(v) * [2, 3])
+        p_ntt = HE_bfv.plain_to_ntt(p, 0, in_new_ptxt=True)
+        assert p_ntt.is_ntt_form() and not p.is_ntt_form()
+        with pytest.raises(RuntimeError, match=".*NTT form.*"):
+            HE_bfv.plain_to_ntt(p_ntt)
+        with pytest.raises(IndexError):
+            HE_bfv.plain_to_ntt(p, 100, in_new_ptxt=True)
+        # ckks: cached plaintexts follow the ciphertext level
+        p = HE_ckks.encodeFrac(np.array([0.5, 2.]))
+        p.ntt_cache = True
+        c = HE_ckks.encrypt(np.array([1., 2.]))
+        c2 = HE_ckks.mod_switch_to_next(c, in_new_obj=True)
+        assert np.allclose(HE_ckks.decrypt(c * p)[:2], [0.5, 4.], atol=1e-2)
+        Pyfhel.set_stats(True, reset=True)
+        try:
+            for _ in range(3):   # Aligned with the cached copy at c2's level
+                assert np.allclose(HE_ckks.decrypt(c2 * p)[:2], [0.5, 4.], atol=1e-2)
+            ops = Pyfhel.stats()["ops"]
+        finally:
+            Pyfhel.set_stats(False, reset=True)
+        assert ops["plain_to_ntt"]["calls"] == 1 and "mod_switch_to_next_plain" not in ops
+        assert ops["multiply_plain"]["calls"] == 3
+
+    def test_Pyfhel_seeded(self, HE_ckks):
+        for kind in ("public_key", "relin_key", "rotate_key"):
+            to_bytes = getattr(HE_ckks, "to_bytes_" + kind)
+            assert len(to_bytes("none", seeded=True)) < 0.6 * len(to_bytes("none"))
+        # Client holding only the secret key -> server without it
+        HE_cli = Pyfhel()
+        HE_cli.from_bytes_context(HE_ckks.to_bytes_context())
+        HE_cli.from_bytes_secret_key(HE_ckks.to_bytes_secret_key())
+        HE_srv = Pyfhel()
+        HE_srv.from_bytes_context(HE_ckks.to_bytes_context())
+        HE_srv.from_bytes_relin_key(HE_cli.to_bytes_relin_key(seeded=True))
+        c_seeded = HE_cli.encrypt_symmetric_bytes(np.array([1., 2.]), "none")
+        assert len(c_seeded) < 0.6 * len(HE_cli.encrypt_symmetric(np.array([1., 2.])).to_bytes("none"))
+        c = PyCtxt(pyfhel=HE_srv, bytestring=c_seeded)
+        c = c * c
+        HE_srv.relinearize(c)
+        assert np.allclose(HE_cli.decrypt(c)[:2], [1., 4.], atol=1e-2)
+
+    def test_Pyfhel_rotation_plan(self):
+        HE = Pyfhel()
+        HE.contextGen(**context_params_list_ckks[0])
+        HE.keyGen()
+        x = np.arange(1, 9, dtype=np.float64)
+        c = HE.encrypt(x)
+        HE.start_rotation_record(dry_run=True)
+        HE.cumul_add(c, n_elements=8)
+        HE.rotate(c, 3)
+        assert HE.stop_rotation_record() == {-4: 1, -2: 1, -1: 1, 3: 1}
+        assert HE.is_rotate_key_empty()
+        report = HE.plan_rotation_keys(max_extra=1)
+        assert report["n_keys"] <= 4 and report["n_keys"] < report["default_n_keys"]
+        assert report["rotations"] <= 2 * report["direct_rotations"]
+        assert np.allclose(HE.decrypt(HE.rotate(c, 3, True))[:5], x[3:], atol=1e-2)
+        assert np.allclose(HE.decrypt(HE.cumul_add(c, n_elements=8))[0], x.sum(), atol=1e-2)
+
+    def test_Pyfhel_rotate_key_store(self, HE_ckks, tmp_path):
+        HE_ckks.save_rotate_key_store(tmp_path / "rtk")
+        HE = Pyfhel()
+        HE.from_bytes_context(HE_ckks.to_bytes_context())
+        HE.from_bytes_secret_key(HE_ckks.to_bytes_secret_key())
+        n_keys = HE.load_rotate_key_store(tmp_path / "rtk")
+        assert HE.rotate_key_store_info() == {"keys": n_keys, "loaded": 0}
+        c = HE.encrypt_symmetric(np.array([1., 2., 3.]))
+        assert np.allclose(HE.decrypt(HE.rotate(c, 1))[:2], [2., 3.], atol=1e-2)
+        assert HE.rotate_key_store_info()["loaded"] == 1
+        HE.rotateKeyGen([1])
+        assert HE.rotate_key_store_info() is None
+
+    def test_Pyfhel_eval_only(self, HE_ckks):
+        HE = HE_ckks.eval_copy()
+        assert HE.eval_only and HE.is_secret_key_empty() and not HE_ckks.is_secret_key_empty()
+        c = HE.encrypt(np.array([1., 2.]))
+        c = HE.rotate(c * c, 1, True)
+        HE.relinearize(c)
+        assert np.allclose(HE_ckks.decrypt(c)[:1], [4.], atol=1e-2)
+        with pytest.raises(RuntimeError):
+            HE.decrypt(c)
+        # Server restoring context and keys without a key generator
+        HE_srv = Pyfhel(eval_only=True)
+        HE_srv.from_bytes_context(HE_ckks.to_bytes_context())
+        HE_srv.from_bytes_public_key(HE_ckks.to_bytes_public_key())
+        with pytest.raises(RuntimeError):
+            HE_srv.keyGen()
+        c = HE_srv.encrypt(np.array([3.]))
+        assert np.allclose(HE_ckks.decrypt(c + c)[:1], [6.], atol=1e-2)
+
+    def test_Pyfhel_context_cache(self, HE_ckks):
+        Pyfhel.set_context_cache(4, clear=True)
+        ctx = HE_ckks.to_bytes_context()
+        for _ in range(3):
+            HE = Pyfhel(eval_only=True)
+            HE.from_bytes_context(ctx)
+        stats = Pyfhel.context_cache_stats()
+        assert (stats["hits"], stats["misses"], stats["entries"]) == (2, 1, 1)
+        HE.from_bytes_public_key(HE_ckks.to_bytes_public_key())
+        assert np.allclose(HE_ckks.decrypt(HE.encrypt(np.array([1.])))[:1], [1.], atol=1e-2)
+        Pyfhel.set_context_cache(0)
+        assert Pyfhel.context_cache_stats()["entries"] == 0
+        Pyfhel.set_context_cache()
+
+    def test_Pyfhel_tenants(self, HE_ckks, tmp_path):
+        Pyfhel.set_tenant_registry(1, spill_dir=tmp_path / "spill")
+        try:
+            HE_ckks.register_tenant("a")
+            stats = Pyfhel.tenant_registry_stats()
+            assert (stats["tenants"], stats["in_memory"], stats["evictions"]) == (1, 0, 1)
+            HE = Pyfhel.as_tenant("a")
+            assert HE.eval_only and Pyfhel.tenant_registry_stats()["reloads"] == 1
+            assert (HE.scale, HE.qi_sizes) == (HE_ckks.scale, HE_ckks.qi_sizes)
+            # Held by HE, so not evicted past the budget
+            Pyfhel.set_tenant_registry(1, spill_dir=tmp_path / "spill")
+            assert Pyfhel.tenant_registry_stats()["in_memory"] == 1
+            c = HE_ckks.encrypt(np.array([1., 2.]))
+            c2 = HE.rotate(c * c, 1, in_new_ctxt=True)
+            assert np.allclose(HE_ckks.decrypt(c2)[:1], [4.], atol=1e-2)
+            del HE
+            Pyfhel.set_tenant_registry(1, spill_dir=tmp_path / "spill")
+            assert Pyfhel.tenant_registry_stats()["in_memory"] == 0
+            Pyfhel.drop_tenant("a")
+            with pytest.raises(IndexError):
+                Pyfhel.as_tenant("a")
+        finally:
+            Pyfhel.set_tenant_registry()
+
+    def test_Pyfhel_ctxt_file(self, HE_ckks, tmp_path):
+        f = tmp_path / "ctxts.afc"
+        ctxts = HE_ckks.encryptAFrac(np.arange(6, dtype=float).reshape(6, 1))
+        assert HE_ckks.save_ctxt_file(f, ctxts[:4], "none") == 4
+        assert HE_ckks.save_ctxt_file(f, ctxts[4:], "zlib", append=True) == 6
+        assert HE_ckks.ctxt_file_info(f) == {"size": 6, "compr_mode": "none"}
+        loaded = HE_ckks.load_ctxt_file(f, 2, 5)
+        assert [round(HE_ckks.decrypt(c)[0]) for c in loaded] == [2, 3, 4]
+        # Without its index (interrupted writer), records are scanned
+        data = f.read_bytes()
+        f.write_bytes(data[:-(6 * 8 + 24) - 10])
+        assert HE_ckks.ctxt_file_info(f)["size"] == 5
+        assert round(HE_ckks.decrypt(HE_ckks.load_ctxt_file(f, 4)[0])[0]) == 4
+
+    def test_Pyfhel_stats(self):
+        HE = Pyfhel(context_params={'scheme': 'bfv', 'n': 2**13, 't_bits': 20})
+        HE.keyGen()
+        HE.rotateKeyGen()
+        HE.relinKeyGen()
+        Pyfhel.set_stats(True, reset=True)
+        try:
+            ctxt = HE.encryptInt(np.arange(HE.n, dtype=np.int64))
+            HE.multiply(ctxt, ctxt, in_new_ctxt=True)
+            HE.rotate(ctxt, 1, in_new_ctxt=True)
+            ctxt.to_bytes()
+            stats = Pyfhel.stats(reset=True)
+        finally:
+            Pyfhel.set_stats(False)
+        assert stats["enabled"]
+        ops = stats["ops"]
+        assert ops["multiply"]["calls"] == 1
+        assert ops["rotate[1]"]["calls"] == 1
+        assert ops["save_ciphertext"]["bytes"] > 0
+        assert Pyfhel.stats()["ops"] == {}
+
+    def test_Pyfhel_trace(self, HE_ckks, tmp_path):
+        import json
+        Pyfhel.start_trace()
+        ctxt = HE_ckks.encrypt(np.array([1., 2.]))
+        HE_ckks.rotate(ctxt * ctxt, 1)
+        HE_ckks.rescale_to_next(ctxt)
+        n = Pyfhel.stop_trace(tmp_path / "trace.json")
+        HE_ckks.square(ctxt)    # not traced
+        with open(tmp_path / "trace.json") as f:
+            trace = json.load(f)
+        events = [e for e in trace["traceEvents"] if e["ph"] == "X"]
+        assert len(events) == n
+        names = {e["name"] for e in events}
+        assert {"encrypt", "multiply", "rotate[1]", "rescale_to_next"} <= names
+        assert "square" not in names
+        enc = next(e for e in events if e["name"] == "encrypt")
+        res = next(e for e in events if e["name"] == "rescale_to_next")
+        assert res["args"]["level"] == enc["args"]["level"] - 1
+        assert enc["args"]["size"] == 2
+
+    def test_Pyfhel_add_many_multiply_many(self, HE_ckks, HE_bfv):
+        # bfv sum of many ciphertexts
+        ctxts = [HE_bfv.encryptInt(np.array([i, 1], dtype=np.int64)) for i in range(100)]
+        s = HE_bfv.add_many(ctxts)
+        assert (HE_bfv.decryptInt(s)[:2] == [4950, 100]).all()
+        # ckks, with an operand one level down
+        cs = [HE_ckks.encrypt(np.array([v])) for v in [1.5, 2., 0.5, 2., 1.]]
+        c_low = HE_ckks.mod_switch_to_next_ctxt(cs[0], in_new_ctxt=True)
+        s = HE_ckks.add_many(cs + [c_low])
+        assert np.round(HE_ckks.decrypt(s)[0], 3) == 8.5
+        assert s.mod_level == 1
+        # ckks, with products: rescaled to the level below, or already rescaled
+        prod = HE_ckks.multiply(cs[1], cs[1], in_new_ctxt=True)
+        s = HE_ckks.add_many([prod, c_low])
+        assert np.round(HE_ckks.decrypt(s)[0], 3) == 5.5
+        rescaled = prod.copy()
+        HE_ckks.rescale_to_next(rescaled)
+        s = HE_ckks.add_many(cs + [rescaled])
+        assert np.round(HE_ckks.decrypt(s)[0], 3) == 11
+        with pytest.raises(ValueError, match=".*scales.*"):
+            HE_ckks.add_many([prod, cs[0]])
+        p = HE_ckks.multiply_many(cs)
+        assert np.round(HE_ckks.decrypt(p)[0], 3) == 3
+        assert p.mod_level == 3     # ceil(log2(5)) tree levels
+        assert HE_ckks.add_many(cs[:1]).mod_level == 0
+        with pytest.raises(ValueError):
+            HE_ckks.multiply_many([])
+
+    def test_Pyfhel_threads(self, HE_ckks):
+        from concurrent.futures import ThreadPoolExecutor
+        def work(i):
+            c = HE_ckks.encrypt(np.array([i, 2.]))
+            c = HE_ckks.rotate(c * c, 1)
+            return np.round(HE_ckks.decrypt(c)[:1])
+        with ThreadPoolExecutor(max_workers=4) as pool:
+            res = list(pool.map(work, range(8)))
+        assert all(r[0]==4 for r in res)
+        pools = Pyfhel.memory_pools()
+        assert pools["threads"] and all(b > 0 for b in pools["threads"])
+
     def test_Pyfhel_align_mod_n_scale(self, HE_ckks, HE_bfv):
         # Small scale rounding
         c1 = HE_ckks.encrypt(1, scale=2**30+1)
@@ -3,6 +3,7 @@ import pytest
 import numpy as np
 from Pyfhel import Pyfhel, PyPtxt, PyCtxt
 from Pyfhel.utils import Scheme_t, Backend_t, _to_valid_file_str, modular_pow
+from Pyfhel.utils import chebyshev_approx, chebyshev_eval
 
 ################################################################################
 #                             COVERAGE TESTS                                   #
@@ -39,3 +40,15 @@ def test_utils_to_valid_file_str():
 
 def test_utils_modular_pow():
     assert np.allclose(modular_pow([2,3], 3, 11), np.array([2,3])**3 % 11)
+
+def test_utils_chebyshev_approx():
+    x = np.linspace(-8, 8, 50)
+    c = chebyshev_approx("tanh", 31, (-8, 8))
+    assert len(c) == 32
+    assert np.allclose(chebyshev_eval(c, x, (-8, 8)), np.tanh(x), atol=1e-2)
+    c = chebyshev_approx(lambda v: v**2, 2, (0, 2))
+    assert np.allclose(chebyshev_eval(c, [0.5, 1.5], (0, 2)), [0.25, 2.25])
+    with pytest.raises(ValueError, match=".*unknown function.*"):
+        chebyshev_approx("nope")
+    with pytest.raises(ValueError, match=".*domain.*"):
+        chebyshev_approx("exp", 3, (1, 1))
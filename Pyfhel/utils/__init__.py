@@ -1,4 +1,6 @@
 from Pyfhel.utils.Scheme_t import Scheme_t
 from Pyfhel.utils.Backend_t import Backend_t
 from Pyfhel.utils.utils import _to_valid_file_str, modular_pow
-__all__ = ["Backend_t", "Scheme_t", "_to_valid_file_str", "modular_pow"]
+from Pyfhel.utils.poly_approx import chebyshev_approx, chebyshev_eval, POLY_FUNCTIONS
+__all__ = ["Backend_t", "Scheme_t", "_to_valid_file_str", "modular_pow",
+           "chebyshev_approx", "chebyshev_eval", "POLY_FUNCTIONS"]
@@ -58,3 +58,83 @@ cdef inline shared_ptr[AfsealCtxt] _dyn_c(shared_ptr[AfCtxt] c):
     """Converts a shared_ptr[AfCtxt] to a shared_ptr[AfsealCtxt]"""
     return dynamic_pointer_cast[AfsealCtxt, AfCtxt](c)
 
+cdef inline np.ndarray _out_array(object out, size_t n, object dtype):
+    """Checks a user-provided decoding destination, or allocates one of n values"""
+    if out is None:
+        return np.empty(n, dtype=dtype)
+    if not isinstance(out, np.ndarray) or out.ndim != 1 or out.dtype != dtype\
+       or not out.flags.c_contiguous or not out.flags.writeable:
+        raise ValueError("<Pyfhel ERROR> out must be a writeable, contiguous "
+                         "1D array of dtype " + str(np.dtype(dtype)))
+    return out
+
+# Batched (vectorized) encryption/encoding: build the backend vectors of
+#  shared pointers out of sequences of PyCtxt/PyPtxt, and vice versa.
+cdef inline np.ndarray _new_ctxt_array(Pyfhel he, size_t n, scheme_t scheme, vector[shared_ptr[AfCtxt]]& ctxtV):
+    """Creates n empty PyCtxt for `he`, pushing their pointers into ctxtV"""
+    cdef np.ndarray arr = np.empty(n, dtype=object)
+    cdef PyCtxt c
+    cdef size_t i
+    ctxtV.reserve(ctxtV.size() + n)
+    for i in range(n):
+        c = PyCtxt(pyfhel=he)
+        c._scheme = scheme
+        ctxtV.push_back(c._ptr_ctxt)
+        arr[i] = c
+    return arr
+
+cdef inline np.ndarray _new_ptxt_array(Pyfhel he, size_t n, scheme_t scheme, vector[shared_ptr[AfPtxt]]& ptxtV):
+    """Creates n empty PyPtxt for `he`, pushing their pointers into ptxtV"""
+    cdef np.ndarray arr = np.empty(n, dtype=object)
+    cdef PyPtxt p
+    cdef size_t i
+    ptxtV.reserve(ptxtV.size() + n)
+    for i in range(n):
+        p = PyPtxt(pyfhel=he)
+        p._scheme = scheme
+        ptxtV.push_back(p._ptr_ptxt)
+        arr[i] = p
+    return arr
+
+cdef inline void _ready(PyCtxt c) except *:
+    """Evaluates a lazy PyCtxt expression before its ciphertext is accessed"""
+    if c is not None and c._expr is not None:
+        c._pyfhel.eval_lazy(c)
+
+cdef inline PyPtxt _ntt_for(Pyfhel he, PyPtxt ptxt, PyCtxt ctxt):
+    """Operand of multiply_plain: the cached NTT form at the ctxt level, if enabled"""
+    if not ptxt._ntt_cache or (ptxt.is_ntt_form() and ptxt._scheme != scheme_t.ckks):
+        return ptxt
+    cdef size_t level = he.afseal.get_mod_level(deref(ctxt._ptr_ctxt))
+    if ptxt._ntt is None:
+        ptxt._ntt = {}
+    cdef PyPtxt p = ptxt._ntt.get(level)
+    if p is None:
+        p = he.plain_to_ntt(ptxt, level, True)
+        ptxt._ntt[level] = p
+    return p
+
+cdef inline vector[shared_ptr[AfCtxt]] _ctxt_vector(object ctxts, scheme_t scheme) except *:
+    """Collects the pointers of a sequence of PyCtxt, checking their scheme"""
+    cdef vector[shared_ptr[AfCtxt]] ctxtV
+    cdef PyCtxt c
+    for c in ctxts:
+        if c is None:
+            raise TypeError("<Pyfhel ERROR> None found in the PyCtxt sequence")
+        if c._scheme != scheme:
+            raise RuntimeError("<Pyfhel ERROR> wrong scheme type in PyCtxt")
+        _ready(c)
+        ctxtV.push_back(c._ptr_ctxt)
+    return ctxtV
+
+cdef inline vector[shared_ptr[AfPtxt]] _ptxt_vector(object ptxts, scheme_t scheme) except *:
+    """Collects the pointers of a sequence of PyPtxt, checking their scheme"""
+    cdef vector[shared_ptr[AfPtxt]] ptxtV
+    cdef PyPtxt p
+    for p in ptxts:
+        if p is None:
+            raise TypeError("<Pyfhel ERROR> None found in the PyPtxt sequence")
+        if scheme != scheme_t.none and p._scheme != scheme:
+            raise RuntimeError("<Pyfhel ERROR> wrong scheme type in PyPtxt")
+        ptxtV.push_back(p._ptr_ptxt)
+    return ptxtV
@@ -0,0 +1,73 @@
+"""Chebyshev approximations of common functions, for Pyfhel.eval_poly.
+
+Coefficients are in the Chebyshev basis over `domain`, which keeps them
+well conditioned for high degrees (degree 15-63 activations).
+"""
+import numpy as np
+from numpy.polynomial import chebyshev as _cheb
+
+def _sigmoid(x):
+    return 1 / (1 + np.exp(-x))
+
+def _gelu(x):
+    return 0.5 * x * (1 + np.tanh(np.sqrt(2 / np.pi) * (x + 0.044715 * x**3)))
+
+def _silu(x):
+    return x * _sigmoid(x)
+
+POLY_FUNCTIONS = {
+    "sigmoid": _sigmoid,
+    "tanh": np.tanh,
+    "gelu": _gelu,
+    "silu": _silu,
+    "relu": lambda x: np.maximum(x, 0),
+    "exp": np.exp,
+    "sqrt": np.sqrt,
+    "inverse": lambda x: 1 / x,
+}
+"""Functions with a built-in approximation, by name."""
+
+def chebyshev_approx(func, degree=15, domain=(-8, 8)):
+    """Chebyshev interpolant of `func` over `domain`.
+
+    Interpolates at the Chebyshev points of the first kind, which is close
+    to the best uniform approximation of that degree.
+
+    Args:
+        func (str, callable): name in POLY_FUNCTIONS, or a vectorized
+            function of one numpy array.
+        degree (int): degree of the approximating polynomial.
+        domain (tuple[float, float]): interval (x_min, x_max) to approximate on.
+
+    Return:
+        np.ndarray[float]: degree+1 coefficients in the Chebyshev basis.
+
+    Raise:
+        ValueError: if the function name is unknown or the domain is empty.
+    """
+    if isinstance(func, str):
+        if func not in POLY_FUNCTIONS:
+            raise ValueError(f"<Pyfhel ERROR> unknown function {func}, "
+                             f"available: {list(POLY_FUNCTIONS)}")
+        func = POLY_FUNCTIONS[func]
+    x_min, x_max = float(domain[0]), float(domain[1])
+    if not x_min < x_max:
+        raise ValueError("<Pyfhel ERROR> domain must satisfy x_min < x_max")
+    # Interpolate on [-1, 1], evaluating func on the mapped points
+    f = lambda t: func((t + 1) * (x_max - x_min) / 2 + x_min)
+    return _cheb.chebinterpolate(f, int(degree))
+
+def chebyshev_eval(coeffs, x, domain=(-8, 8)):
+    """Evaluates Chebyshev coefficients over `domain` in the clear.
+
+    Args:
+        coeffs (np.ndarray[float]): coefficients in the Chebyshev basis.
+        x (np.ndarray[float]): points to evaluate.
+        domain (tuple[float, float]): interval the coefficients refer to.
+
+    Return:
+        np.ndarray[float]: the polynomial evaluated at x.
+    """
+    x_min, x_max = float(domain[0]), float(domain[1])
+    t = (2 * np.asarray(x, dtype=np.float64) - x_min - x_max) / (x_max - x_min)
+    return _cheb.chebval(t, coeffs)